@@ -0,0 +1,39 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Fixtures shared by the sysd microbenchmark and fuzz targets.
+ */
+
+#ifndef __SYSD_BENCH_H__
+#define __SYSD_BENCH_H__
+
+#include <stddef.h>
+
+#include "sysd_fru.h"
+
+/* Largest OCP FRU image: header plus a 16 bit total_length. */
+#define SYSD_BENCH_FRU_MAX_LEN  (sizeof(fru_header_t) + UINT16_MAX)
+
+size_t sysd_bench_fru_image(unsigned char *buf, size_t size);
+void sysd_bench_fru_free(fru_eeprom_t *fru);
+
+extern const char sysd_bench_manifest[];
+void sysd_bench_manifest_reset(void);
+
+#endif /* __SYSD_BENCH_H__ */
@@ -0,0 +1,164 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Fixtures shared by the sysd microbenchmark and fuzz targets.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <ovsdb-idl.h>
+#include <util.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_util.h"
+#include "sysd_fru.h"
+#include "sysd_bench.h"
+
+/* Manifest in the layout of files/image.manifest. */
+const char sysd_bench_manifest[] =
+    "{\"manifest_info\": {"
+    "  \"kernel\": {\"name\": \"linux\", \"version\": \"4.1\"},"
+    "  \"mgmt_intf\": {\"intf\": \"eth0\"},"
+    "  \"daemons\": {"
+    "    \"ops-sysd\": {\"is_hw_handler\": true},"
+    "    \"ops-pmd\": {\"is_hw_handler\": true},"
+    "    \"ops-tempd\": {\"is_hw_handler\": true},"
+    "    \"ops-powerd\": {\"is_hw_handler\": true},"
+    "    \"ops-fand\": {\"is_hw_handler\": true},"
+    "    \"ops-ledd\": {\"is_hw_handler\": true},"
+    "    \"ops-switchd\": {\"is_hw_handler\": true},"
+    "    \"ops-intfd\": {\"is_hw_handler\": false},"
+    "    \"ops-vland\": {\"is_hw_handler\": false},"
+    "    \"ops-portd\": {\"is_hw_handler\": false},"
+    "    \"ops-lacpd\": {\"is_hw_handler\": false},"
+    "    \"ops-lldpd\": {\"is_hw_handler\": false},"
+    "    \"ops-cfgd\": {\"is_hw_handler\": false},"
+    "    \"ops-arpmgrd\": {\"is_hw_handler\": false},"
+    "    \"ops-bgpd\": {\"is_hw_handler\": false},"
+    "    \"ops-zebra\": {\"is_hw_handler\": false}"
+    "  }"
+    "}}";
+
+void
+sysd_bench_manifest_reset(void)
+{
+    /* The daemon entries live in the state arena. */
+    sysd_arena_destroy(&sysd_state_arena);
+    free(daemons);
+    daemons = NULL;
+    num_daemons = 0;
+    num_hw_daemons = 0;
+
+    free(mgmt_intf);
+    mgmt_intf = NULL;
+
+} /* sysd_bench_manifest_reset */
+
+static size_t
+fixture_put_tlv(unsigned char *buf, size_t pos, uint8_t code,
+                const void *value, uint8_t len)
+{
+    buf[pos] = code;
+    buf[pos + 1] = len;
+    memcpy(&buf[pos + 2], value, len);
+
+    return pos + 2 + len;
+
+} /* fixture_put_tlv */
+
+static size_t
+fixture_put_str(unsigned char *buf, size_t pos, uint8_t code, const char *str)
+{
+    return fixture_put_tlv(buf, pos, code, str, strlen(str));
+
+} /* fixture_put_str */
+
+/*
+ * Builds a complete OCP FRU EEPROM image with every TLV type sysd decodes,
+ * two vendor extensions and a valid CRC. Returns its length.
+ */
+size_t
+sysd_bench_fru_image(unsigned char *buf, size_t size)
+{
+    static const uint8_t mac[FRU_BASE_MAC_ADDRESS_LEN] = {
+        0x70, 0x72, 0xcf, 0x12, 0x34, 0x56
+    };
+    static const uint8_t num_macs[FRU_NUM_MACS_LEN] = { 0x00, 0x4a };
+    static const uint8_t ext[] = {
+        0x00, 0x00, 0x00, 0x0b, 0xde, 0xad, 0xbe, 0xef, 0x01, 0x02
+    };
+    uint8_t device_version = 1;
+    fru_header_t *header = (fru_header_t *) buf;
+    size_t pos = sizeof(fru_header_t);
+    unsigned int crc;
+    uint16_t total_len;
+
+    ovs_assert(size >= 512);
+
+    memset(buf, 0, size);
+    memcpy(header->id, "TlvInfo", sizeof(header->id));
+    header->header_version = SUPPORTED_OCP_FRU_EEPROM_VERSION;
+
+    pos = fixture_put_str(buf, pos, FRU_PRODUCT_NAME_TYPE, "5712-54X-O-AC-F");
+    pos = fixture_put_str(buf, pos, FRU_PART_NUMBER_TYPE, "FP1ZZ5654002A");
+    pos = fixture_put_str(buf, pos, FRU_SERIAL_NUMBER_TYPE, "571254X1523001");
+    pos = fixture_put_tlv(buf, pos, FRU_BASE_MAC_ADDRESS_TYPE, mac, sizeof(mac));
+    pos = fixture_put_str(buf, pos, FRU_MANUFACTURE_DATE_TYPE,
+                          "06/15/2015 10:31:02");
+    pos = fixture_put_tlv(buf, pos, FRU_DEVICE_VERSION_TYPE,
+                          &device_version, sizeof(device_version));
+    pos = fixture_put_str(buf, pos, FRU_LABEL_REVISION_TYPE, "R01A");
+    pos = fixture_put_str(buf, pos, FRU_PLATFORM_NAME_TYPE,
+                          "x86_64-accton_as5712_54x-r0");
+    pos = fixture_put_str(buf, pos, FRU_ONIE_VERSION_TYPE, "2014.08.0.0.4");
+    pos = fixture_put_tlv(buf, pos, FRU_NUM_MAC_TYPE, num_macs, sizeof(num_macs));
+    pos = fixture_put_str(buf, pos, FRU_MANUFACTURER_TYPE, "Accton");
+    pos = fixture_put_str(buf, pos, FRU_COUNTRY_CODE_TYPE, "TW");
+    pos = fixture_put_str(buf, pos, FRU_VENDOR_TYPE, "Edgecore");
+    pos = fixture_put_str(buf, pos, FRU_DIAG_VERSION_TYPE, "1.2.3");
+    pos = fixture_put_str(buf, pos, FRU_SERVICE_TAG_TYPE, "X00001");
+    pos = fixture_put_tlv(buf, pos, FRU_VENDOR_EXTENSION_TYPE, ext, sizeof(ext));
+    pos = fixture_put_tlv(buf, pos, FRU_VENDOR_EXTENSION_TYPE, ext, sizeof(ext));
+
+    /* CRC TLV: type, length, then CRC-32 over everything before the value. */
+    total_len = pos + FRU_CRC_LEN - sizeof(fru_header_t);
+    header->total_length[0] = total_len >> 8;
+    header->total_length[1] = total_len & 0xff;
+    buf[pos] = FRU_CRC_TYPE;
+    buf[pos + 1] = FRU_CRC_LEN - 2;
+    crc = calc_crc(buf, pos + 2);
+    buf[pos + 2] = (crc >> 24) & 0xff;
+    buf[pos + 3] = (crc >> 16) & 0xff;
+    buf[pos + 4] = (crc >> 8) & 0xff;
+    buf[pos + 5] = crc & 0xff;
+
+    return pos + FRU_CRC_LEN;
+
+} /* sysd_bench_fru_image */
+
+void
+sysd_bench_fru_free(fru_eeprom_t *fru)
+{
+    free(fru->arena);
+    memset(fru, 0, sizeof(*fru));
+
+} /* sysd_bench_fru_free */
@@ -0,0 +1,468 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * sysd-bootbench: measures how long ops-sysd takes to bring a database up
+ * to System:cur_hw=1.
+ *
+ *      sysd-bootbench [OPTIONS] DATABASE COMMAND [ARG...]
+ *
+ * Connects to DATABASE, then runs COMMAND (normally ops-sysd pointed at the
+ * same database) and plays the part of every other h/w daemon listed in the
+ * image manifest: once a daemon's row shows up, its cur_hw is set to 1
+ * after the configured delay. When sysd sets System:cur_hw=1 the wall time,
+ * CPU time and peak RSS of COMMAND are printed as a JSON object and COMMAND
+ * is terminated.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <openvswitch/vlog.h>
+#include <command-line.h>
+#include <json.h>
+#include <poll-loop.h>
+#include <shash.h>
+#include <smap.h>
+#include <timeval.h>
+#include <util.h>
+#include <ovsdb-idl.h>
+#include <vswitch-idl.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_util.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_bootbench);
+
+#define BOOTBENCH_DFLT_TIMEOUT_SEC  60
+
+/* How often the child is checked for an early exit. */
+#define BOOTBENCH_REAP_MSEC         100
+
+struct bootbench_daemon {
+    char        *name;
+    long long   delay;          /* msec between appearance and cur_hw=1. */
+    long long   seen;           /* time_msec() the row first appeared. */
+    long long   flipped;        /* time_msec() cur_hw=1 was committed. */
+};
+
+static long long    dflt_delay = 0;
+static struct smap  daemon_delays = SMAP_INITIALIZER(&daemon_delays);
+static int          timeout_sec = BOOTBENCH_DFLT_TIMEOUT_SEC;
+
+static void
+usage(void)
+{
+    printf("%s: ops-sysd boot benchmark\n"
+           "usage: %s [OPTIONS] DATABASE COMMAND [ARG...]\n"
+           "\nOptions:\n"
+           "  -d, --delay=[NAME=]MSEC  set h/w daemon cur_hw=1 MSEC after its\n"
+           "                           Daemon row appears; without NAME, the\n"
+           "                           default for all daemons (default: 0)\n"
+           "  -t, --timeout=SEC        give up after SEC seconds (default: %d)\n"
+           "  -h, --help               display this help message\n",
+           program_name, program_name, BOOTBENCH_DFLT_TIMEOUT_SEC);
+    exit(EXIT_SUCCESS);
+
+} /* usage */
+
+static long long
+bootbench_parse_msec(const char *str)
+{
+    char        *end;
+    long long   value;
+
+    errno = 0;
+    value = strtoll(str, &end, 10);
+    if (errno || end == str || *end != '\0' || value < 0) {
+        ovs_fatal(0, "invalid delay \"%s\"", str);
+    }
+    return value;
+
+} /* bootbench_parse_msec */
+
+static void
+parse_options(int argc, char *argv[])
+{
+    static const struct option long_options[] = {
+        {"delay",   required_argument, NULL, 'd'},
+        {"timeout", required_argument, NULL, 't'},
+        {"help",    no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    for (;;) {
+        char    *eq;
+        int     c;
+
+        /* Stop at the first non-option so COMMAND keeps its own options. */
+        c = getopt_long(argc, argv, "+d:t:h", long_options, NULL);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+        case 'd':
+            eq = strchr(optarg, '=');
+            if (eq) {
+                *eq = '\0';
+                bootbench_parse_msec(eq + 1);
+                smap_replace(&daemon_delays, optarg, eq + 1);
+            } else {
+                dflt_delay = bootbench_parse_msec(optarg);
+            }
+            break;
+
+        case 't':
+            timeout_sec = atoi(optarg);
+            if (timeout_sec <= 0) {
+                ovs_fatal(0, "invalid timeout \"%s\"", optarg);
+            }
+            break;
+
+        case 'h':
+            usage();
+
+        case '?':
+            exit(EXIT_FAILURE);
+
+        default:
+            abort();
+        }
+    }
+
+    if (argc - optind < 2) {
+        ovs_fatal(0, "DATABASE and COMMAND are required; "
+                  "use --help for usage");
+    }
+
+} /* parse_options */
+
+static struct bootbench_daemon *
+bootbench_daemon_get(struct shash *seen, const char *name, long long now)
+{
+    struct bootbench_daemon *daemon = shash_find_data(seen, name);
+    const char              *delay;
+
+    if (daemon == NULL) {
+        daemon = xzalloc(sizeof *daemon);
+        daemon->name = xstrdup(name);
+        delay = smap_get(&daemon_delays, name);
+        daemon->delay = delay ? bootbench_parse_msec(delay) : dflt_delay;
+        daemon->seen = now;
+        shash_add(seen, name, daemon);
+    }
+    return daemon;
+
+} /* bootbench_daemon_get */
+
+/* Plays the h/w daemons. Returns the earliest time a pending daemon is due,
+ * or LLONG_MAX if none is. */
+static long long
+bootbench_run_daemons(struct ovsdb_idl *idl, struct ovsdb_idl_txn **txnp,
+                      struct shash *seen, long long now)
+{
+    const struct ovsrec_daemon  *row;
+    long long                   next = LLONG_MAX;
+
+    if (*txnp) {
+        enum ovsdb_idl_txn_status status = ovsdb_idl_txn_commit(*txnp);
+
+        if (status == TXN_INCOMPLETE) {
+            return next;
+        }
+        if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+            struct shash_node *node;
+
+            VLOG_WARN("Daemon cur_hw update failed: %s",
+                      ovsdb_idl_txn_status_to_string(status));
+
+            /* Retry whatever is still unset on this pass. */
+            SHASH_FOR_EACH (node, seen) {
+                ((struct bootbench_daemon *) node->data)->flipped = 0;
+            }
+        }
+        ovsdb_idl_txn_destroy(*txnp);
+        *txnp = NULL;
+    }
+
+    OVSREC_DAEMON_FOR_EACH (row, idl) {
+        struct bootbench_daemon *daemon;
+
+        if (!row->is_hw_handler || !strcmp(row->name, NAME_IN_DAEMON_TABLE)) {
+            continue;
+        }
+
+        daemon = bootbench_daemon_get(seen, row->name, now);
+        if (row->cur_hw > 0 || daemon->flipped) {
+            continue;
+        }
+
+        if (now >= daemon->seen + daemon->delay) {
+            if (*txnp == NULL) {
+                *txnp = ovsdb_idl_txn_create(idl);
+            }
+            ovsrec_daemon_set_cur_hw(row, 1);
+            daemon->flipped = now;
+        } else if (daemon->seen + daemon->delay < next) {
+            next = daemon->seen + daemon->delay;
+        }
+    }
+
+    if (*txnp) {
+        ovsdb_idl_txn_commit(*txnp);
+    }
+    return next;
+
+} /* bootbench_run_daemons */
+
+/* Reads user and system CPU time of 'pid', in msec. */
+static bool
+bootbench_read_cpu(pid_t pid, long long *user, long long *sys)
+{
+    unsigned long long  utime;
+    unsigned long long  stime;
+    char                path[64];
+    char                buf[1024];
+    char                *p;
+    size_t              n;
+    long                hz = sysconf(_SC_CLK_TCK);
+    FILE                *fp;
+
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int) pid);
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        return false;
+    }
+    n = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[n] = '\0';
+
+    /* comm may contain spaces; fields restart after the last ')'. utime
+     * and stime are fields 14 and 15, the 12th and 13th after 'state'. */
+    p = strrchr(buf, ')');
+    if (p == NULL
+        || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+                  &utime, &stime) != 2) {
+        return false;
+    }
+
+    *user = utime * 1000 / hz;
+    *sys = stime * 1000 / hz;
+    return true;
+
+} /* bootbench_read_cpu */
+
+/* Reads the peak resident set size of 'pid', in kB. */
+static long long
+bootbench_read_peak_rss(pid_t pid)
+{
+    long long   kb = -1;
+    char        path[64];
+    char        line[256];
+    FILE        *fp;
+
+    snprintf(path, sizeof(path), "/proc/%d/status", (int) pid);
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "VmHWM: %lld kB", &kb) == 1) {
+            break;
+        }
+    }
+    fclose(fp);
+    return kb;
+
+} /* bootbench_read_peak_rss */
+
+static pid_t
+bootbench_spawn(char *argv[])
+{
+    pid_t pid = fork();
+
+    if (pid < 0) {
+        ovs_fatal(errno, "fork failed");
+    } else if (pid == 0) {
+        execvp(argv[0], argv);
+        fprintf(stderr, "%s: exec of %s failed (%s)\n",
+                program_name, argv[0], ovs_strerror(errno));
+        _exit(127);
+    }
+    return pid;
+
+} /* bootbench_spawn */
+
+int
+main(int argc, char *argv[])
+{
+    const struct ovsrec_system  *sys;
+    struct ovsdb_idl            *idl;
+    struct ovsdb_idl_txn        *txn = NULL;
+    struct shash                seen = SHASH_INITIALIZER(&seen);
+    struct shash_node           *node;
+    struct json                 *result;
+    struct json                 *daemons;
+    const char                  *status = "timeout";
+    long long                   start;
+    long long                   deadline;
+    long long                   now;
+    long long                   cpu_user = -1;
+    long long                   cpu_sys = -1;
+    long long                   peak_rss = -1;
+    char                        *str;
+    pid_t                       pid;
+    int                         wstatus;
+    bool                        reaped = false;
+
+    set_program_name(argv[0]);
+    vlog_set_levels(NULL, VLF_ANY_DESTINATION, VLL_WARN);
+    parse_options(argc, argv);
+
+    ovsrec_init();
+    idl = ovsdb_idl_create(argv[optind], &ovsrec_idl_class, false, true);
+    ovsdb_idl_add_table(idl, &ovsrec_table_system);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_cur_hw);
+    ovsdb_idl_add_table(idl, &ovsrec_table_daemon);
+    ovsdb_idl_add_column(idl, &ovsrec_daemon_col_name);
+    ovsdb_idl_add_column(idl, &ovsrec_daemon_col_cur_hw);
+    ovsdb_idl_add_column(idl, &ovsrec_daemon_col_is_hw_handler);
+
+    /* Have the database contents in hand before the clock starts, so the
+     * measurement doesn't include our own connection setup. */
+    deadline = time_msec() + timeout_sec * 1000LL;
+    for (;;) {
+        ovsdb_idl_run(idl);
+        if (ovsdb_idl_has_ever_connected(idl)) {
+            break;
+        }
+        if (time_msec() >= deadline) {
+            ovs_fatal(0, "unable to connect to %s", argv[optind]);
+        }
+        ovsdb_idl_wait(idl);
+        poll_timer_wait_until(deadline);
+        poll_block();
+    }
+
+    sys = ovsrec_system_first(idl);
+    if (sys && sys->cur_hw > 0) {
+        ovs_fatal(0, "System:cur_hw is already set, use a fresh database");
+    }
+
+    start = time_msec();
+    deadline = start + timeout_sec * 1000LL;
+    pid = bootbench_spawn(&argv[optind + 1]);
+
+    for (;;) {
+        long long next;
+
+        ovsdb_idl_run(idl);
+        now = time_msec();
+
+        sys = ovsrec_system_first(idl);
+        if (sys && sys->cur_hw > 0) {
+            status = "ok";
+            break;
+        }
+
+        if (waitpid(pid, &wstatus, WNOHANG) == pid) {
+            status = "exited";
+            reaped = true;
+            break;
+        }
+
+        if (now >= deadline) {
+            break;
+        }
+
+        next = bootbench_run_daemons(idl, &txn, &seen, now);
+
+        ovsdb_idl_wait(idl);
+        if (txn) {
+            ovsdb_idl_txn_wait(txn);
+        }
+        poll_timer_wait_until(MIN(next, deadline));
+        poll_timer_wait(BOOTBENCH_REAP_MSEC);
+        poll_block();
+    }
+
+    /* Sample while the process is still around; it is in the middle of its
+     * main loop, so this is the cost of getting to cur_hw=1. */
+    if (!reaped) {
+        bootbench_read_cpu(pid, &cpu_user, &cpu_sys);
+        peak_rss = bootbench_read_peak_rss(pid);
+        kill(pid, SIGTERM);
+        waitpid(pid, &wstatus, 0);
+    }
+
+    result = json_object_create();
+    json_object_put_string(result, "status", status);
+    json_object_put(result, "wall_ms", json_integer_create(now - start));
+    json_object_put(result, "cpu_user_ms", json_integer_create(cpu_user));
+    json_object_put(result, "cpu_sys_ms", json_integer_create(cpu_sys));
+    json_object_put(result, "peak_rss_kb", json_integer_create(peak_rss));
+    if (reaped) {
+        json_object_put(result, "exit_status",
+                        json_integer_create(WIFEXITED(wstatus)
+                                            ? WEXITSTATUS(wstatus) : -1));
+    }
+
+    daemons = json_object_create();
+    SHASH_FOR_EACH (node, &seen) {
+        struct bootbench_daemon *daemon = node->data;
+        struct json             *obj = json_object_create();
+
+        json_object_put(obj, "seen_ms",
+                        json_integer_create(daemon->seen - start));
+        json_object_put(obj, "cur_hw_ms",
+                        json_integer_create(daemon->flipped
+                                            ? daemon->flipped - start : -1));
+        json_object_put(daemons, daemon->name, obj);
+    }
+    json_object_put(result, "daemons", daemons);
+
+    str = json_to_string(result, JSSF_PRETTY | JSSF_SORT);
+    puts(str);
+    free(str);
+    json_destroy(result);
+
+    SHASH_FOR_EACH (node, &seen) {
+        struct bootbench_daemon *daemon = node->data;
+
+        free(daemon->name);
+    }
+    shash_destroy_free_data(&seen);
+    if (txn) {
+        ovsdb_idl_txn_destroy(txn);
+    }
+    ovsdb_idl_destroy(idl);
+    smap_destroy(&daemon_delays);
+
+    return strcmp(status, "ok") ? EXIT_FAILURE : EXIT_SUCCESS;
+
+} /* main */
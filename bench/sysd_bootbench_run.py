@@ -0,0 +1,328 @@
+#!/usr/bin/env python3
+# (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+
+"""
+Runs ops-sysd end to end against a private ovsdb-server and reports how long
+it takes to reach System:cur_hw=1, as JSON.
+
+Each run gets a fresh database created from the vswitch schema. The hardware
+description files are copied from --hw-desc-dir and adjusted so that no
+switch hardware is needed: fru.yaml is dropped, the FRU EEPROM is read from a
+generated image through the 'file' transport, and the devices.yaml 'init'
+section is removed. The image manifest lists ops-sysd plus --hw-daemons
+simulated h/w daemons, which sysd-bootbench marks ready after --delay.
+
+    sysd_bootbench_run.py --sysd build/ops-sysd \\
+        --bootbench build/bench/sysd-bootbench --runs 10 \\
+        --hw-daemons 5 --delay 50 --delay bench-hwd-0=500
+"""
+
+import argparse
+import json
+import os
+import re
+import shlex
+import shutil
+import signal
+import statistics
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+import zlib
+
+REPO_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DFLT_HW_DESC_DIR = os.path.join(REPO_DIR, 'tests', 'test_hw_desc_files')
+DFLT_SCHEMA = '/usr/share/openvswitch/vswitch.ovsschema'
+PROXY = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                     'sysd_ovsdb_proxy.py')
+
+METRICS = ('wall_ms', 'cpu_user_ms', 'cpu_sys_ms', 'peak_rss_kb',
+           'initial_config_ms', 'package_info_ms')
+
+# Phase timings ops-sysd logs at INFO level.
+LOG_PHASES = [
+    (re.compile(r'Initial configuration committed (\d+) ms after it was '
+                r'queued'),
+     ('initial_config_ms',)),
+    (re.compile(r'Package_Info populated with \d+ entries in (\d+) ms'),
+     ('package_info_ms',)),
+]
+
+FRU_FIELDS = [
+    (0x21, b'X86-64'),                      # product name
+    (0x22, b'BENCH-0001'),                  # part number
+    (0x23, b'SN0123456789'),                # serial number
+    (0x24, b'\x02\x00\x00\x00\x01\x00'),    # base MAC address
+    (0x25, b'10/18/2016 12:00:00'),         # manufacture date
+    (0x26, b'\x01'),                        # device version
+    (0x27, b'A'),                           # label revision
+    (0x28, b'x86_64-generic-r0'),           # platform name
+    (0x29, b'2016.05'),                     # ONIE version
+    (0x2a, struct.pack('>H', 64)),          # number of MACs
+    (0x2b, b'Generic-x86'),                 # manufacturer
+    (0x2c, b'US'),                          # country code
+    (0x2d, b'OpenSwitch'),                  # vendor
+    (0x2e, b'1.0'),                         # diag version
+    (0x2f, b'BENCH'),                       # service tag
+]
+
+
+def fru_image():
+    """Builds an OCP ONIE TlvInfo FRU image with a valid CRC."""
+    tlvs = b''.join(struct.pack('BB', code, len(value)) + value
+                    for code, value in FRU_FIELDS)
+    total_len = len(tlvs) + 6
+    data = b'TlvInfo\x00' + struct.pack('>BH', 1, total_len) + tlvs
+    data += b'\xfe\x04'
+    return data + struct.pack('>I', zlib.crc32(data) & 0xffffffff)
+
+
+def prepare_hw_desc(src, dst, fru_path):
+    """Copies the hw desc files, rewiring the FRU EEPROM to 'fru_path'."""
+    shutil.copytree(src, dst)
+
+    manifest = os.path.join(dst, 'manifest.yaml')
+    with open(manifest) as f:
+        text = f.read()
+    text = re.sub(r'\n\s*-\s+name:\s+fru\s*\n\s*filename:\s+fru\.yaml', '',
+                  text)
+    with open(manifest, 'w') as f:
+        f.write(text)
+    fru_yaml = os.path.join(dst, 'fru.yaml')
+    if os.path.exists(fru_yaml):
+        os.remove(fru_yaml)
+
+    devices = os.path.join(dst, 'devices.yaml')
+    out = []
+    skip = False
+    with open(devices) as f:
+        for line in f:
+            # Top level keys start in column 0; drop the 'init' section.
+            if re.match(r'^\S', line):
+                skip = line.startswith('init:')
+            if skip:
+                continue
+            out.append(line)
+            m = re.match(r'^(\s*)-(\s+)name:\s+fru_eeprom\s*$', line)
+            if m:
+                indent = ' ' * (len(m.group(1)) + 1 + len(m.group(2)))
+                out.append('%stransport:  file\n' % indent)
+                out.append('%spath:       %s\n' % (indent, fru_path))
+    with open(devices, 'w') as f:
+        f.writelines(out)
+
+    with open(fru_path, 'wb') as f:
+        f.write(fru_image())
+
+
+def write_manifest(path, hw_daemons):
+    daemons = {'ops-sysd': {'is_hw_handler': True}}
+    for i in range(hw_daemons):
+        daemons['bench-hwd-%d' % i] = {'is_hw_handler': True}
+    with open(path, 'w') as f:
+        json.dump({'daemons': daemons, 'mgmt_intf': {'intf': 'eth0'}}, f,
+                  indent=4)
+
+
+def start_ovsdb(workdir, schema):
+    db = os.path.join(workdir, 'ovsdb.db')
+    sock = os.path.join(workdir, 'db.sock')
+    pidfile = os.path.join(workdir, 'ovsdb-server.pid')
+
+    subprocess.check_call(['ovsdb-tool', 'create', db, schema])
+    subprocess.check_call(['ovsdb-server', db,
+                           '--remote=punix:' + sock,
+                           '--unixctl=' + os.path.join(workdir, 'ovsdb.ctl'),
+                           '--pidfile=' + pidfile,
+                           '--log-file=' + os.path.join(workdir,
+                                                        'ovsdb-server.log'),
+                           '--detach', '--no-chdir'])
+    return 'unix:' + sock, pidfile
+
+
+def stop_ovsdb(pidfile):
+    try:
+        with open(pidfile) as f:
+            os.kill(int(f.read().strip()), signal.SIGTERM)
+    except (IOError, OSError, ValueError):
+        pass
+
+
+def start_proxy(workdir, upstream, options):
+    """Starts sysd_ovsdb_proxy.py in front of 'upstream'. Returns the remote
+    for ops-sysd, the proxy process and its statistics file."""
+    sock = os.path.join(workdir, 'proxy.sock')
+    stats = os.path.join(workdir, 'proxy.json')
+    proc = subprocess.Popen([sys.executable, PROXY, '--listen=punix:' + sock,
+                             '--upstream=' + upstream, '--stats=' + stats]
+                            + shlex.split(options))
+    for _ in range(100):
+        if os.path.exists(sock) or proc.poll() is not None:
+            break
+        time.sleep(0.05)
+    return 'unix:' + sock, proc, stats
+
+
+def stop_proxy(proc, stats):
+    proc.send_signal(signal.SIGTERM)
+    proc.wait()
+    try:
+        with open(stats) as f:
+            result = json.load(f)
+    except (IOError, ValueError):
+        return None
+    del result['transactions']
+    return result
+
+
+def run_once(args, workdir, hw_desc_dir, manifest, fru_cache,
+             version_detail=None):
+    rundir = tempfile.mkdtemp(prefix='run-', dir=workdir)
+    remote, pidfile = start_ovsdb(rundir, args.schema)
+    log = os.path.join(rundir, 'ops-sysd.log')
+    proxy = None
+    sysd_remote = remote
+    try:
+        if args.proxy is not None:
+            sysd_remote, proxy, proxy_stats = start_proxy(rundir, remote,
+                                                          args.proxy)
+        if not args.warm_fru_cache and os.path.exists(fru_cache):
+            os.remove(fru_cache)
+
+        cmd = [args.bootbench, '--timeout=%d' % args.timeout]
+        cmd += ['--delay=%s' % d for d in args.delay]
+        cmd += [remote, args.sysd, sysd_remote,
+                '--hw-desc-dir=' + hw_desc_dir,
+                '--manifest=' + manifest,
+                '--fru-cache=' + fru_cache,
+                '--unixctl=' + os.path.join(rundir, 'sysd.ctl'),
+                '--log-file=' + log,
+                '-vconsole:off']
+        if version_detail:
+            cmd.append('--version-detail=' + version_detail)
+        proc = subprocess.run(cmd, stdout=subprocess.PIPE,
+                              universal_newlines=True)
+        try:
+            result = json.loads(proc.stdout)
+        except ValueError:
+            result = {'status': 'error', 'returncode': proc.returncode}
+        result.update(log_phases(log))
+        if proxy:
+            result['proxy'] = stop_proxy(proxy, proxy_stats)
+            proxy = None
+        return result
+    finally:
+        if proxy:
+            stop_proxy(proxy, proxy_stats)
+        stop_ovsdb(pidfile)
+
+
+def log_phases(path):
+    """Returns the phase timings found in the ops-sysd log at 'path'."""
+    phases = {}
+    try:
+        with open(path) as f:
+            for line in f:
+                for regex, keys in LOG_PHASES:
+                    m = regex.search(line)
+                    if m:
+                        phases.update(zip(keys, map(int, m.groups())))
+    except IOError:
+        pass
+    return phases
+
+
+def summarize(runs):
+    summary = {}
+    ok = [r for r in runs if r.get('status') == 'ok']
+    for metric in METRICS:
+        values = [r[metric] for r in ok if r.get(metric, -1) >= 0]
+        if values:
+            summary[metric] = {'min': min(values),
+                               'median': statistics.median(values),
+                               'max': max(values)}
+    summary['ok'] = len(ok)
+    summary['failed'] = len(runs) - len(ok)
+    return summary
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='End-to-end ops-sysd boot benchmark.')
+    parser.add_argument('--sysd', default='ops-sysd',
+                        help='ops-sysd binary (default: %(default)s)')
+    parser.add_argument('--bootbench', default='sysd-bootbench',
+                        help='sysd-bootbench binary (default: %(default)s)')
+    parser.add_argument('--schema', default=DFLT_SCHEMA,
+                        help='vswitch schema (default: %(default)s)')
+    parser.add_argument('--hw-desc-dir', default=DFLT_HW_DESC_DIR,
+                        help='hardware description files to boot from')
+    parser.add_argument('--hw-daemons', type=int, default=5,
+                        help='simulated h/w daemons in the manifest')
+    parser.add_argument('--delay', action='append', default=[],
+                        metavar='[NAME=]MSEC',
+                        help='time before a h/w daemon reports ready; '
+                             'may be given more than once')
+    parser.add_argument('--runs', type=int, default=5)
+    parser.add_argument('--timeout', type=int, default=60,
+                        help='per run timeout in seconds')
+    parser.add_argument('--warm-fru-cache', action='store_true',
+                        help='keep the FRU cache between runs')
+    parser.add_argument('--proxy', metavar='OPTIONS',
+                        help='connect ops-sysd through sysd_ovsdb_proxy.py '
+                             'with these options, e.g. "--delay 20 '
+                             '--try-again 1"')
+    parser.add_argument('--keep', action='store_true',
+                        help='keep the work directory and logs')
+    args = parser.parse_args()
+
+    workdir = tempfile.mkdtemp(prefix='sysd-bootbench-')
+    try:
+        hw_desc_dir = os.path.join(workdir, 'hwdesc')
+        manifest = os.path.join(workdir, 'image.manifest')
+        fru_cache = os.path.join(workdir, 'fru_cache.json')
+
+        prepare_hw_desc(args.hw_desc_dir, hw_desc_dir,
+                        os.path.join(workdir, 'fru.bin'))
+        write_manifest(manifest, args.hw_daemons)
+
+        runs = []
+        for i in range(args.runs):
+            runs.append(run_once(args, workdir, hw_desc_dir, manifest,
+                                 fru_cache))
+
+        json.dump({'config': {'hw_desc_dir': args.hw_desc_dir,
+                              'hw_daemons': args.hw_daemons,
+                              'delay': args.delay,
+                              'warm_fru_cache': args.warm_fru_cache,
+                              'proxy': args.proxy,
+                              'date': time.strftime('%Y-%m-%dT%H:%M:%SZ',
+                                                    time.gmtime())},
+                   'runs': runs,
+                   'summary': summarize(runs)},
+                  sys.stdout, indent=4, sort_keys=True)
+        sys.stdout.write('\n')
+        return 0 if all(r.get('status') == 'ok' for r in runs) else 1
+    finally:
+        if args.keep:
+            sys.stderr.write('work directory: %s\n' % workdir)
+        else:
+            shutil.rmtree(workdir, ignore_errors=True)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,111 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * libFuzzer target for the FRU TLV decoder and the image.manifest parser.
+ *
+ * The first input byte selects the parser: even for sysd_process_eeprom(),
+ * odd for sysd_process_json(). The rest is the FRU image or manifest text.
+ * Run with -dict and a corpus seeded from sysd-microbench's fixtures for
+ * best results.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openvswitch/vlog.h>
+#include <json.h>
+#include <util.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_util.h"
+#include "sysd_fru.h"
+#include "sysd_bench.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static void
+fuzz_eeprom(const uint8_t *data, size_t size)
+{
+    const fru_header_t *header;
+    unsigned char *buf;
+    fru_eeprom_t fru;
+    int total_len;
+
+    if (size < sizeof(fru_header_t)) {
+        return;
+    }
+
+    /* Exact sized copy so ASan catches any read past the image. */
+    buf = xmemdup(data, size);
+    header = (const fru_header_t *) buf;
+
+    /* sysd_read_fru_eeprom_xport() always reads total_length bytes after
+     * the header, so the decoder may assume that much is present. */
+    total_len = (header->total_length[0] << 8) | header->total_length[1];
+    total_len = MIN(total_len, (int) (size - sizeof(fru_header_t)));
+
+    memset(&fru, 0, sizeof(fru));
+    if (sysd_process_eeprom(buf, &fru, total_len)) {
+        sysd_bench_fru_free(&fru);
+    }
+    free(buf);
+}
+
+static void
+fuzz_manifest(const uint8_t *data, size_t size)
+{
+    struct json *json;
+    char *str;
+
+    str = xmemdup0((const char *) data, size);
+    json = json_from_string(str);
+    free(str);
+
+    if (json->type == JSON_OBJECT || json->type == JSON_ARRAY) {
+        sysd_process_json(json);
+        sysd_bench_manifest_reset();
+    }
+    json_destroy(json);
+}
+
+int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static bool initialized = false;
+
+    if (!initialized) {
+        vlog_set_levels(NULL, VLF_ANY_DESTINATION, VLL_OFF);
+        initialized = true;
+    }
+
+    if (size < 1) {
+        return 0;
+    }
+
+    if (data[0] & 1) {
+        fuzz_manifest(data + 1, size - 1);
+    } else {
+        fuzz_eeprom(data + 1, size - 1);
+    }
+
+    return 0;
+}
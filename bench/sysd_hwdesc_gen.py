@@ -0,0 +1,373 @@
+#!/usr/bin/env python3
+# (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+
+"""
+Generates a synthetic platform description for scale testing ops-sysd.
+
+The output directory gets a complete set of hardware description files
+(manifest.yaml, devices.yaml, ports.yaml, qos.yaml, acl.yaml) plus an
+image.manifest and a version_detail.yaml for Package_Info:
+
+    sysd_hwdesc_gen.py --ports 1024 --daemons 120 --packages 4000 OUTDIR
+
+With --vlans or --vrfs, a defaults.yaml also asks for that many VLANs on the
+default bridge and VRFs besides the default one.
+
+Every --qsfp-every'th front panel port is a splittable QSFP28 port with four
+subports; the rest are SFP28 ports. Each pluggable port has its own module
+EEPROM device behind a CPLD mux, with CPLDs spread over several I2C buses.
+The FRU EEPROM is described without a transport; sysd_bootbench_run.py
+rewires it to a generated image.
+"""
+
+import argparse
+import json
+import os
+import shutil
+import sys
+
+TEMPLATE_DIR = os.path.join(
+    os.path.dirname(os.path.dirname(os.path.abspath(__file__))),
+    'tests', 'test_hw_desc_files')
+
+LICENSE = """\
+# (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+#  Generated by sysd_hwdesc_gen.py, do not edit.
+"""
+
+MANUFACTURER = 'Generic-x86'
+PRODUCT_NAME = 'X86-64'
+
+# Module mux selects per CPLD before a new CPLD is needed.
+PORTS_PER_CPLD = 48
+# CPLDs sharing one I2C bus.
+CPLDS_PER_BUS = 4
+SUBPORTS = 4
+
+
+def header(title):
+    return (LICENSE + '#\n#  %s for a synthetic %s switch\n\n'
+            'manufacturer:    %s\nproduct_name:    %s\nversion:         \'1\'\n\n'
+            % (title, PRODUCT_NAME, MANUFACTURER, PRODUCT_NAME))
+
+
+class Port(object):
+    def __init__(self, number, qsfp):
+        self.number = number
+        self.qsfp = qsfp
+        self.cpld = 'cpld%d' % ((number - 1) // PORTS_PER_CPLD + 1)
+        self.mux = (number - 1) % PORTS_PER_CPLD
+        self.eeprom = '%s%d' % ('qsfp28_' if qsfp else 'sfp28_', number)
+
+
+def front_panel(ports, qsfp_every):
+    """Returns the front panel ports of a switch with 'ports' interfaces in
+    total, subports included."""
+    panel = []
+    total = 0
+    number = 1
+    while total < ports:
+        qsfp = qsfp_every and number % qsfp_every == 0 \
+            and total + 1 + SUBPORTS <= ports
+        panel.append(Port(number, qsfp))
+        total += 1 + (SUBPORTS if qsfp else 0)
+        number += 1
+    return panel
+
+
+def gen_devices(panel):
+    n_cplds = (len(panel) - 1) // PORTS_PER_CPLD + 1
+    n_buses = (n_cplds - 1) // CPLDS_PER_BUS + 2
+    out = [header('Devices Description File')]
+
+    out.append('buses:\n')
+    for bus in range(n_buses):
+        out.append('    -   name:       i2c_%d\n'
+                   '        dev_name:   /dev/i2c-%d\n'
+                   '        smbus:      true\n' % (bus, bus + 1))
+
+    out.append('\ndevices:\n')
+    for cpld in range(n_cplds):
+        out.append('    -   name:       cpld%d\n'
+                   '        bus:        i2c_%d\n'
+                   '        dev_type:   cpld\n'
+                   '        address:    0x%02X\n'
+                   % (cpld + 1, cpld // CPLDS_PER_BUS + 1,
+                      0x60 + cpld % CPLDS_PER_BUS))
+    for port in panel:
+        bus = (int(port.cpld[4:]) - 1) // CPLDS_PER_BUS + 1
+        out.append('    -   name:       %s\n'
+                   '        bus:        i2c_%d\n'
+                   '        dev_type:   %s\n'
+                   '        address:    0x50\n'
+                   '        pre:\n'
+                   '            - device:   %s\n'
+                   '              register: 0x02\n'
+                   '              data:     [ 0x%02X ]\n'
+                   '        post:\n'
+                   '            - device:   %s\n'
+                   '              register: 0x02\n'
+                   '              data:     [ 0xFF ]\n'
+                   % (port.eeprom, bus, 'qsfpp' if port.qsfp else 'sfpp',
+                      port.cpld, port.mux, port.cpld))
+    out.append('    -   name:       fru_eeprom\n'
+               '        bus:        i2c_0\n'
+               '        dev_type:   fru_eeprom\n'
+               '        address:    0x57\n')
+
+    out.append('\ninit:\n')
+    for cpld in range(n_cplds):
+        out.append('    - device:   cpld%d\n'
+                   '      register: 0x02\n'
+                   '      data:     [ 0xff ]\n' % (cpld + 1))
+    return ''.join(out)
+
+
+def gen_signals(port):
+    kind = 'qsfpp' if port.qsfp else 'sfpp'
+    bit = 1 << (port.mux % 8)
+    base = 0x10 + (port.mux // 8) * 0x08
+    signals = (['reset', 'mod_present', 'int', 'lp_mode'] if port.qsfp
+               else ['tx_disable', 'tx_fault', 'rx_loss', 'mod_present'])
+    out = ['       module_signals:\n']
+    for i, signal in enumerate(signals):
+        out.append('            %s_%s:\n'
+                   '                device:     %s\n'
+                   '                register:   0x%02X\n'
+                   '                bitmask:    0x%02X\n'
+                   % (kind, signal, port.cpld, base + i, bit))
+        if signal in ('mod_present', 'int'):
+            out.append('                polarity:   negative\n')
+    return ''.join(out)
+
+
+def gen_ports(panel, n_ports):
+    out = [header('Port Description File')]
+    out.append('port_info:\n'
+               '    number_ports:    %d\n'
+               '    max_port_speed:  100000\n'
+               '    max_transmission_unit: 9192\n'
+               '    max_lag_count:         1024\n'
+               '    max_lag_member_count:  256\n'
+               '    L3_port_requires_internal_VLAN: False\n\nports:\n'
+               % n_ports)
+
+    hw_port = 1
+    for port in panel:
+        if port.qsfp:
+            subports = ['%d-%d' % (port.number, i)
+                        for i in range(1, SUBPORTS + 1)]
+            out.append('    -  name:             %d\n'
+                       '       switch_device:      0\n'
+                       '       switch_device_port: %d\n'
+                       '       pluggable:          True\n'
+                       '       connector:          QSFP28\n'
+                       '       max_speed:          100000\n'
+                       '       speeds:             [40000,100000]\n'
+                       '       capabilities:       [enet40G, enet100G, split_4]\n'
+                       '       subports:           [%s]\n'
+                       '       supported_modules:  [TBD]\n'
+                       '       module_eeprom:      %s\n'
+                       % (port.number, hw_port, ','.join(subports),
+                          port.eeprom))
+            out.append(gen_signals(port))
+            for i, name in enumerate(subports):
+                out.append('    -  name:             "%s"\n'
+                           '       switch_device:      0\n'
+                           '       switch_device_port: %d\n'
+                           '       parent_port:        %d\n'
+                           '       pluggable:          False\n'
+                           '       connector:          QSFP28\n'
+                           '       max_speed:          25000\n'
+                           '       speeds:             [10000,25000]\n'
+                           '       capabilities:       [enet10G, enet25G]\n'
+                           '       subports:           []\n'
+                           '       supported_modules:  [TBD]\n'
+                           '       subport_number:      %d\n'
+                           % (name, hw_port + i, port.number, i + 1))
+            hw_port += SUBPORTS
+        else:
+            out.append('    -  name:             %d\n'
+                       '       switch_device:      0\n'
+                       '       switch_device_port: %d\n'
+                       '       pluggable:          True\n'
+                       '       connector:          SFP28\n'
+                       '       max_speed:          25000\n'
+                       '       speeds:             [10000,25000]\n'
+                       '       capabilities:       [enet10G, enet25G]\n'
+                       '       subports:           []\n'
+                       '       supported_modules:  [TBD]\n'
+                       '       module_eeprom:      %s\n'
+                       % (port.number, hw_port, port.eeprom))
+            out.append(gen_signals(port))
+            hw_port += 1
+    return ''.join(out)
+
+
+def gen_acl(n_ports):
+    return (header('ACL Description File') +
+            'acl_info:\n'
+            '     max_acls:         %d\n'
+            '     max_aces:         %d\n'
+            '     max_aces_per_acl: 512\n'
+            % (max(512, n_ports), max(1024, n_ports * 4)))
+
+
+def gen_qos():
+    # QoS tables are per switch, not per port; reuse the fixture's.
+    with open(os.path.join(TEMPLATE_DIR, 'qos.yaml')) as f:
+        text = f.read()
+    body = text[text.index('qos_info:'):]
+    return header('QoS Description File') + body
+
+
+def gen_manifest():
+    out = [header('Hardware Description Manifest File')]
+    out.append('subsystem_info: |\n'
+               '    Synthetic platform generated for ops-sysd scale tests.\n\n'
+               'files:\n')
+    for name in ('manifest', 'devices', 'ports', 'qos', 'acl'):
+        out.append('    -   name:       %s\n'
+                   '        filename:   %s.yaml\n' % (name, name))
+    return ''.join(out)
+
+
+def gen_image_manifest(daemons, hw_daemons):
+    entries = {'ops-sysd': {'is_hw_handler': True}}
+    for i in range(daemons - 1):
+        entries['bench-%s-%d' % ('hwd' if i < hw_daemons else 'd', i)] = \
+            {'is_hw_handler': i < hw_daemons}
+    return json.dumps({'daemons': entries, 'mgmt_intf': {'intf': 'eth0'}},
+                      indent=4, sort_keys=True) + '\n'
+
+
+def gen_version_detail(packages):
+    out = []
+    for i in range(packages):
+        out.append('- PKG: bench-package-%d\n'
+                   '  PV: 1.0.%d\n'
+                   '  SRCREV: %040x\n'
+                   '  SRC_URL: git://git.openswitch.net/openswitch/'
+                   'bench-package-%d\n'
+                   '  TYPE: git\n' % (i, i, i * 2654435761, i))
+    return ''.join(out)
+
+
+def gen_defaults(vlans, vrfs):
+    out = [header('Default Topology File'),
+           'bridges:\n'
+           '    -   name:           bridge_normal\n'
+           '        internal_port:  true\n']
+    if vlans:
+        out.append('        vlans:\n'
+                   '            -   ids:    1-%d\n' % vlans)
+    out.append('\nvrfs:\n'
+               '    -   name:       vrf_default\n'
+               '        table_id:   0\n')
+    for i in range(vrfs):
+        out.append('    -   name:       bench_vrf_%d\n'
+                   '        table_id:   %d\n' % (i, i + 1))
+    return ''.join(out)
+
+
+def generate(outdir, ports, qsfp_every=4, daemons=120, hw_daemons=8,
+             packages=2000, vlans=0, vrfs=0):
+    """Writes a generated platform description to 'outdir'. Returns the
+    paths of the hw desc dir, image.manifest and version_detail.yaml."""
+    panel = front_panel(ports, qsfp_every)
+    n_ports = sum(1 + (SUBPORTS if p.qsfp else 0) for p in panel)
+
+    hw_desc_dir = os.path.join(outdir, 'hwdesc')
+    if os.path.exists(hw_desc_dir):
+        shutil.rmtree(hw_desc_dir)
+    os.makedirs(hw_desc_dir)
+
+    files = {
+        os.path.join(hw_desc_dir, 'manifest.yaml'): gen_manifest(),
+        os.path.join(hw_desc_dir, 'devices.yaml'): gen_devices(panel),
+        os.path.join(hw_desc_dir, 'ports.yaml'): gen_ports(panel, n_ports),
+        os.path.join(hw_desc_dir, 'qos.yaml'): gen_qos(),
+        os.path.join(hw_desc_dir, 'acl.yaml'): gen_acl(n_ports),
+        os.path.join(outdir, 'image.manifest'):
+            gen_image_manifest(daemons, hw_daemons),
+        os.path.join(outdir, 'version_detail.yaml'):
+            gen_version_detail(packages),
+    }
+    if vlans or vrfs:
+        files[os.path.join(hw_desc_dir, 'defaults.yaml')] = \
+            gen_defaults(vlans, vrfs)
+    for path, text in files.items():
+        with open(path, 'w') as f:
+            f.write(text)
+
+    return (hw_desc_dir, os.path.join(outdir, 'image.manifest'),
+            os.path.join(outdir, 'version_detail.yaml'))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Generate a synthetic ops-sysd platform description.')
+    parser.add_argument('outdir')
+    parser.add_argument('--ports', type=int, default=64,
+                        help='interfaces, subports included (default: '
+                             '%(default)s)')
+    parser.add_argument('--qsfp-every', type=int, default=4,
+                        help='make every Nth front panel port a splittable '
+                             'QSFP28 port, 0 for none (default: %(default)s)')
+    parser.add_argument('--daemons', type=int, default=120,
+                        help='daemons in image.manifest (default: '
+                             '%(default)s)')
+    parser.add_argument('--hw-daemons', type=int, default=8,
+                        help='of those, h/w daemons besides ops-sysd '
+                             '(default: %(default)s)')
+    parser.add_argument('--packages', type=int, default=2000,
+                        help='version_detail.yaml entries (default: '
+                             '%(default)s)')
+    parser.add_argument('--vlans', type=int, default=0,
+                        help='VLANs on the default bridge in defaults.yaml '
+                             '(default: %(default)s)')
+    parser.add_argument('--vrfs', type=int, default=0,
+                        help='VRFs besides the default one in defaults.yaml '
+                             '(default: %(default)s)')
+    args = parser.parse_args()
+
+    if args.ports < 1 or args.hw_daemons >= args.daemons:
+        parser.error('need at least one port and fewer h/w daemons '
+                     'than daemons')
+    if not 0 <= args.vlans <= 4094 or args.vrfs < 0:
+        parser.error('--vlans must be 0 to 4094 and --vrfs at least 0')
+
+    for path in generate(args.outdir, args.ports, args.qsfp_every,
+                         args.daemons, args.hw_daemons, args.packages,
+                         args.vlans, args.vrfs):
+        print(path)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
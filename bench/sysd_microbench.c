@@ -0,0 +1,275 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * sysd-microbench: times sysd's pure parsing and formatting functions on
+ * fixed fixtures, without ovsdb-server or platform hardware.
+ *
+ *      sysd-microbench [-n ITERATIONS] [CASE...]
+ *
+ * Prints one line per case with the mean time per call.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+
+#include <openvswitch/vlog.h>
+#include <json.h>
+#include <smap.h>
+#include <util.h>
+#include <openswitch-idl.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_util.h"
+#include "sysd_fru.h"
+#include "sysd_ovsdb_if.h"
+#include "sysd_bench.h"
+
+#define BENCH_DFLT_ITERATIONS   100000
+
+struct bench_case {
+    const char  *name;
+    void        (*run)(void);
+};
+
+static unsigned char    fru_image[SYSD_BENCH_FRU_MAX_LEN];
+static int              fru_total_len;
+static struct json      *manifest;
+
+static int  speeds_storage[] = { 1000, 10000, 25000, 40000, 50000, 100000 };
+static int  *speeds[] = {
+    &speeds_storage[0], &speeds_storage[1], &speeds_storage[2],
+    &speeds_storage[3], &speeds_storage[4], &speeds_storage[5], NULL
+};
+static char *capabilities[] = {
+    INTERFACE_HW_INTF_INFO_MAP_SPLIT_4, INTERFACE_HW_INTF_INFO_MAP_ENET10G,
+    INTERFACE_HW_INTF_INFO_MAP_ENET40G, INTERFACE_HW_INTF_INFO_MAP_ENET100G,
+    NULL
+};
+static sysd_intf_info_t     intf;
+static sysd_subsystem_t     subsys;
+
+static const char *pkg_info_tokens[] = {
+    "PKG", "ops-sysd", "PV", "git999", "SRCREV",
+    "0123456789abcdef0123456789abcdef01234567", "SRC_URL",
+    "git://git.openswitch.net/openswitch/ops-sysd", "TYPE", "git", "values",
+};
+
+static void
+bench_process_eeprom(void)
+{
+    fru_eeprom_t fru;
+
+    memset(&fru, 0, sizeof(fru));
+    if (!sysd_process_eeprom(fru_image, &fru, fru_total_len)) {
+        ovs_fatal(0, "FRU fixture failed to decode");
+    }
+    sysd_bench_fru_free(&fru);
+}
+
+static void
+bench_process_json(void)
+{
+    if (sysd_process_json(manifest)) {
+        ovs_fatal(0, "manifest fixture failed to process");
+    }
+    sysd_bench_manifest_reset();
+}
+
+static void
+bench_package_info_check_key(void)
+{
+    static volatile int sink;
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(pkg_info_tokens); i++) {
+        sink += package_info_mapping_check_key(pkg_info_tokens[i]);
+    }
+}
+
+/* The speeds formatter sysd used before hw_intf_info templates, kept so
+ * get_speeds_string numbers stay comparable with older runs. The templates
+ * now format the list once per port type, inside build_hw_intf_info. */
+static void
+get_speeds_string(char *speed_str, int len, int **speeds)
+{
+    int     i = 0;
+    char    buf[16];
+
+    while(speeds[i] != NULL) {
+        int used = strlen(speed_str);
+
+        if (i == 0) {
+            snprintf(buf, sizeof(buf), "%d", *speeds[i]);
+        } else {
+            snprintf(buf, sizeof(buf), ",%d", *speeds[i]);
+        }
+        if (used + strlen(buf) >= len) {
+            break;
+        }
+        strcpy(speed_str + used, buf);
+        i++;
+    }
+}
+
+static void
+bench_get_speeds_string(void)
+{
+    char buf[128];
+
+    memset(buf, 0, sizeof(buf));
+    get_speeds_string(buf, sizeof(buf), speeds);
+}
+
+static void
+bench_build_hw_intf_info(void)
+{
+    struct smap hw_intf_info;
+
+    smap_init(&hw_intf_info);
+    sysd_build_hw_intf_info(&hw_intf_info, &subsys, &intf);
+    smap_destroy(&hw_intf_info);
+}
+
+static const struct bench_case bench_cases[] = {
+    { "process_eeprom",         bench_process_eeprom },
+    { "process_json",           bench_process_json },
+    { "package_info_check_key", bench_package_info_check_key },
+    { "get_speeds_string",      bench_get_speeds_string },
+    { "build_hw_intf_info",     bench_build_hw_intf_info },
+};
+
+static void
+bench_setup(void)
+{
+    const fru_header_t *header = (const fru_header_t *) fru_image;
+
+    sysd_bench_fru_image(fru_image, sizeof(fru_image));
+    fru_total_len = (header->total_length[0] << 8) | header->total_length[1];
+
+    manifest = json_from_string(sysd_bench_manifest);
+    if (manifest->type != JSON_OBJECT) {
+        ovs_fatal(0, "manifest fixture does not parse");
+    }
+
+    intf.name = "1";
+    intf.device = 0;
+    intf.device_port = 1;
+    intf.max_speed = 100000;
+    intf.speeds = speeds;
+    intf.capabilities = capabilities;
+    intf.connector = "QSFP28";
+    intf.pluggable = true;
+
+    strcpy(subsys.name, SYSD_BASE_SUBSYSTEM);
+    subsys.system_mac_addr = 0x7072cf123456ULL;
+}
+
+static long long
+bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static bool
+bench_selected(const char *name, int argc, char *argv[])
+{
+    int i;
+
+    if (argc == 0) {
+        return true;
+    }
+    for (i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int
+main(int argc, char *argv[])
+{
+    long iterations = BENCH_DFLT_ITERATIONS;
+    long long start;
+    long long elapsed;
+    size_t i;
+    long j;
+    int c;
+
+    set_program_name(argv[0]);
+
+    while ((c = getopt(argc, argv, "n:h")) != -1) {
+        switch (c) {
+        case 'n':
+            iterations = strtol(optarg, NULL, 10);
+            if (iterations <= 0) {
+                ovs_fatal(0, "invalid iteration count %s", optarg);
+            }
+            break;
+        default:
+            printf("usage: %s [-n ITERATIONS] [CASE...]\ncases:",
+                   program_name);
+            for (i = 0; i < ARRAY_SIZE(bench_cases); i++) {
+                printf(" %s", bench_cases[i].name);
+            }
+            printf("\n");
+            exit(c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+    }
+    argc -= optind;
+    argv += optind;
+
+    /* Keep logging out of the measurements. */
+    vlog_set_levels(NULL, VLF_ANY_DESTINATION, VLL_OFF);
+
+    bench_setup();
+
+    for (i = 0; i < ARRAY_SIZE(bench_cases); i++) {
+        const struct bench_case *bench = &bench_cases[i];
+
+        if (!bench_selected(bench->name, argc, argv)) {
+            continue;
+        }
+
+        /* Warm up caches and allocator. */
+        for (j = 0; j < iterations / 100 + 1; j++) {
+            bench->run();
+        }
+
+        start = bench_now_ns();
+        for (j = 0; j < iterations; j++) {
+            bench->run();
+        }
+        elapsed = bench_now_ns() - start;
+
+        printf("%-24s %10ld iterations %12.1f ns/op\n", bench->name,
+               iterations, (double) elapsed / iterations);
+    }
+
+    json_destroy(manifest);
+
+    return 0;
+}
@@ -0,0 +1,364 @@
+#!/usr/bin/env python3
+# (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+
+"""
+OVSDB JSON-RPC proxy that injects latency and faults, for testing how
+ops-sysd copes with a slow or misbehaving ovsdb-server.
+
+    sysd_ovsdb_proxy.py --listen punix:/tmp/proxy.sock \\
+        --upstream unix:/var/run/openvswitch/db.sock \\
+        --delay 20 --jitter 10 --try-again 2 --stats stats.json
+
+Every client connection gets its own upstream connection. Messages keep
+their order in each direction; --delay and --jitter hold each one back
+before it is passed on. Faults:
+
+  --transact-delay MS   additionally hold back replies to "transact"
+  --lock-delay MS       hold back lock grants (a "lock" reply with
+                        locked=true, or a "locked" notification)
+  --lock-drop           never pass lock grants on; the client stays unlocked
+  --try-again N         answer the first N transactions with a "timed out"
+                        error, which the IDL reports as TXN_TRY_AGAIN
+  --try-again-rate P    answer a fraction P of transactions that way
+  --disconnect-on N     drop both connections while the Nth transaction
+                        (counting from 1, after forwarding it) is in flight;
+                        may be given more than once
+
+With --stats, every transaction seen is written to FILE as JSON on exit
+(SIGTERM or SIGINT), including the tables it touched, the sysd call site
+guessed from them, the injected fault and the round trip through the proxy.
+"""
+
+import argparse
+import asyncio
+import codecs
+import json
+import random
+import signal
+import sys
+import time
+
+
+def parse_remote(remote):
+    """Splits an OVS style remote into ('unix', path) or ('tcp', host, port).
+    """
+    kind, _, rest = remote.partition(':')
+    if kind in ('unix', 'punix'):
+        return ('unix', rest)
+    if kind == 'tcp':
+        host, _, port = rest.rpartition(':')
+        return ('tcp', host, int(port))
+    if kind == 'ptcp':
+        port, _, host = rest.partition(':')
+        return ('tcp', host or '127.0.0.1', int(port))
+    raise ValueError('unsupported remote "%s"' % remote)
+
+
+def call_site(ops):
+    """Guesses which ops-sysd transaction a list of operations came from."""
+    tables = {}
+    for op in ops:
+        if isinstance(op, dict) and 'table' in op:
+            tables.setdefault(op['table'], set()).add(op.get('op'))
+    if 'Package_Info' in tables:
+        return 'sysd_add_package_info'
+    if 'insert' in tables.get('System', ()):
+        return 'sysd_initial_configure'
+    if 'insert' in tables.get('Interface', ()):
+        return 'sysd_interface_batch'
+    if 'System' in tables and any(
+            'cur_hw' in op.get('row', {}) for op in ops
+            if isinstance(op, dict) and op.get('table') == 'System'):
+        return 'sysd_set_hw_done'
+    if 'Daemon' in tables:
+        return 'daemon_update'
+    return 'other'
+
+
+class JsonStream(object):
+    """Splits a byte stream into JSON-RPC messages. OVSDB sends bare JSON
+    objects back to back, so parse as far as a whole object allows."""
+
+    def __init__(self):
+        self.buf = ''
+        self.decoder = json.JSONDecoder()
+        self.utf8 = codecs.getincrementaldecoder('utf-8')()
+
+    def feed(self, data):
+        self.buf += self.utf8.decode(data)
+        msgs = []
+        while True:
+            self.buf = self.buf.lstrip()
+            if not self.buf:
+                break
+            try:
+                msg, end = self.decoder.raw_decode(self.buf)
+            except ValueError:
+                break
+            msgs.append(msg)
+            self.buf = self.buf[end:]
+        return msgs
+
+
+class Stats(object):
+    def __init__(self):
+        self.transactions = []
+        self.connections = 0
+        self.disconnects = 0
+        self.lock_grants = 0
+        self.lock_grants_dropped = 0
+
+    def to_json(self):
+        sites = {}
+        for txn in self.transactions:
+            site = sites.setdefault(txn['site'], {'count': 0, 'faults': 0,
+                                                  'rtt_ms': []})
+            site['count'] += 1
+            if txn['fault']:
+                site['faults'] += 1
+            if txn.get('rtt_ms') is not None:
+                site['rtt_ms'].append(txn['rtt_ms'])
+        return {'connections': self.connections,
+                'disconnects': self.disconnects,
+                'lock_grants': self.lock_grants,
+                'lock_grants_dropped': self.lock_grants_dropped,
+                'sites': sites,
+                'transactions': self.transactions}
+
+
+class Direction(object):
+    """One direction of a proxied connection. Messages are released in
+    order, each no earlier than its own due time."""
+
+    def __init__(self, writer):
+        self.writer = writer
+        self.queue = asyncio.Queue()
+        self.last_due = 0.0
+
+    def send(self, msg, delay):
+        due = max(time.monotonic() + delay, self.last_due)
+        self.last_due = due
+        self.queue.put_nowait((due, msg))
+
+    async def run(self):
+        while True:
+            due, msg = await self.queue.get()
+            if msg is None:
+                break
+            wait = due - time.monotonic()
+            if wait > 0:
+                await asyncio.sleep(wait)
+            self.writer.write(json.dumps(msg).encode('utf-8'))
+            await self.writer.drain()
+
+
+class Session(object):
+    def __init__(self, proxy, client_reader, client_writer):
+        self.proxy = proxy
+        self.opts = proxy.opts
+        self.client_reader = client_reader
+        self.client_writer = client_writer
+        self.pending = {}           # transact id -> stats entry
+        self.lock_ids = set()       # ids of outstanding lock/steal requests
+        self.closed = False
+
+    def delay(self, extra=0):
+        jitter = random.uniform(0, self.opts.jitter) if self.opts.jitter else 0
+        return (self.opts.delay + jitter + extra) / 1000.0
+
+    async def run(self):
+        upstream = self.proxy.upstream
+        if upstream[0] == 'unix':
+            up_reader, up_writer = await asyncio.open_unix_connection(
+                upstream[1])
+        else:
+            up_reader, up_writer = await asyncio.open_connection(
+                upstream[1], upstream[2])
+        self.up_writer = up_writer
+        self.to_server = Direction(up_writer)
+        self.to_client = Direction(self.client_writer)
+        self.proxy.stats.connections += 1
+
+        tasks = [asyncio.ensure_future(t) for t in (
+            self.pump(self.client_reader, self.from_client),
+            self.pump(up_reader, self.from_server),
+            self.to_server.run(), self.to_client.run())]
+        await asyncio.wait(tasks, return_when=asyncio.FIRST_COMPLETED)
+        for task in tasks:
+            task.cancel()
+        self.close()
+
+    def close(self):
+        if not self.closed:
+            self.closed = True
+            self.client_writer.close()
+            self.up_writer.close()
+
+    async def pump(self, reader, handler):
+        stream = JsonStream()
+        while not self.closed:
+            data = await reader.read(65536)
+            if not data:
+                break
+            for msg in stream.feed(data):
+                handler(msg)
+
+    def from_client(self, msg):
+        method = msg.get('method')
+        if method in ('lock', 'steal'):
+            self.lock_ids.add(json.dumps(msg.get('id')))
+        elif method == 'transact':
+            if self.transact(msg):
+                return
+        self.to_server.send(msg, self.delay())
+
+    def transact(self, msg):
+        """Handles a transaction from the client. Returns True if it must
+        not be forwarded."""
+        stats = self.proxy.stats
+        ops = msg.get('params', [])[1:]
+        n = len(stats.transactions) + 1
+        entry = {'n': n, 'site': call_site(ops), 'ops': len(ops),
+                 'tables': sorted({op['table'] for op in ops
+                                   if isinstance(op, dict) and 'table' in op}),
+                 'fault': None, 'start': time.monotonic()}
+        stats.transactions.append(entry)
+
+        if (n <= self.opts.try_again
+                or random.random() < self.opts.try_again_rate):
+            # What ovsdb-server sends when a "wait" operation times out.
+            entry['fault'] = 'try_again'
+            result = [{'error': 'timed out',
+                       'details': 'injected by sysd_ovsdb_proxy'}]
+            result += [None] * (len(ops) - 1)
+            self.to_client.send({'id': msg.get('id'), 'result': result,
+                                 'error': None}, self.delay())
+            return True
+
+        if n in self.opts.disconnect_on:
+            entry['fault'] = 'disconnect'
+            stats.disconnects += 1
+            # The upstream writer stops once the transaction is written,
+            # which tears the session down.
+            self.to_server.send(msg, 0)
+            self.to_server.send(None, 0)
+            return True
+
+        self.pending[json.dumps(msg.get('id'))] = entry
+        return False
+
+    def from_server(self, msg):
+        stats = self.proxy.stats
+        key = json.dumps(msg.get('id'))
+        extra = 0
+        entry = None
+
+        if key in self.pending and 'method' not in msg:
+            entry = self.pending.pop(key)
+            extra = self.opts.transact_delay
+        elif (key in self.lock_ids and 'method' not in msg) \
+                or msg.get('method') == 'locked':
+            self.lock_ids.discard(key)
+            result = msg.get('result')
+            granted = msg.get('method') == 'locked' or (
+                isinstance(result, dict) and result.get('locked'))
+            if granted:
+                stats.lock_grants += 1
+                if self.opts.lock_drop:
+                    stats.lock_grants_dropped += 1
+                    if 'method' in msg:
+                        return
+                    msg = dict(msg, result={'locked': False})
+                else:
+                    extra = self.opts.lock_delay
+
+        delay = self.delay(extra)
+        if entry:
+            # Round trip as the client will see it.
+            entry['rtt_ms'] = round((time.monotonic() - entry['start']
+                                     + delay) * 1000, 3)
+        self.to_client.send(msg, delay)
+
+
+class Proxy(object):
+    def __init__(self, opts):
+        self.opts = opts
+        self.upstream = parse_remote(opts.upstream)
+        self.stats = Stats()
+
+    async def handle(self, reader, writer):
+        session = Session(self, reader, writer)
+        try:
+            await session.run()
+        except (OSError, asyncio.CancelledError):
+            session.closed = True
+            writer.close()
+
+    def write_stats(self):
+        if not self.opts.stats:
+            return
+        for txn in self.stats.transactions:
+            txn.pop('start', None)
+        with open(self.opts.stats, 'w') as f:
+            json.dump(self.stats.to_json(), f, indent=4, sort_keys=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Latency and fault injecting OVSDB proxy.')
+    parser.add_argument('--listen', required=True,
+                        help='punix:PATH or ptcp:PORT[:IP]')
+    parser.add_argument('--upstream', required=True,
+                        help='unix:PATH or tcp:IP:PORT of ovsdb-server')
+    parser.add_argument('--delay', type=float, default=0,
+                        help='msec added to every message')
+    parser.add_argument('--jitter', type=float, default=0,
+                        help='up to this many random msec more')
+    parser.add_argument('--transact-delay', type=float, default=0)
+    parser.add_argument('--lock-delay', type=float, default=0)
+    parser.add_argument('--lock-drop', action='store_true')
+    parser.add_argument('--try-again', type=int, default=0, metavar='N')
+    parser.add_argument('--try-again-rate', type=float, default=0,
+                        metavar='P')
+    parser.add_argument('--disconnect-on', type=int, action='append',
+                        default=[], metavar='N')
+    parser.add_argument('--seed', type=int, help='random seed')
+    parser.add_argument('--stats', metavar='FILE',
+                        help='write per transaction statistics on exit')
+    opts = parser.parse_args()
+    random.seed(opts.seed)
+
+    proxy = Proxy(opts)
+    loop = asyncio.get_event_loop()
+    listen = parse_remote(opts.listen)
+    if listen[0] == 'unix':
+        server = loop.run_until_complete(
+            asyncio.start_unix_server(proxy.handle, listen[1]))
+    else:
+        server = loop.run_until_complete(
+            asyncio.start_server(proxy.handle, listen[1], listen[2]))
+
+    for signum in (signal.SIGTERM, signal.SIGINT):
+        loop.add_signal_handler(signum, loop.stop)
+    try:
+        loop.run_forever()
+    finally:
+        server.close()
+        proxy.write_stats()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
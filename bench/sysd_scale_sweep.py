@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+# (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+
+"""
+Boots ops-sysd on generated platforms of increasing size and reports time
+and memory per scale point, as JSON.
+
+For each --scales entry a platform with that many interfaces is generated by
+sysd_hwdesc_gen.py and booted --runs times through sysd-bootbench, each run
+against its own ovsdb-server (see sysd_bootbench_run.py). Besides wall time,
+CPU and peak RSS, the summary carries the time ops-sysd spent building and
+committing the initial configuration and populating Package_Info.
+
+    sysd_scale_sweep.py --sysd build/ops-sysd \\
+        --bootbench build/bench/sysd-bootbench --scales 64,512,4096
+"""
+
+import argparse
+import json
+import os
+import shutil
+import sys
+import tempfile
+
+import sysd_bootbench_run
+import sysd_hwdesc_gen
+
+DFLT_SCALES = '64,128,256,512,1024,2048,4096,8192'
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='ops-sysd boot time and memory across platform sizes.')
+    parser.add_argument('--sysd', default='ops-sysd',
+                        help='ops-sysd binary (default: %(default)s)')
+    parser.add_argument('--bootbench', default='sysd-bootbench',
+                        help='sysd-bootbench binary (default: %(default)s)')
+    parser.add_argument('--schema', default=sysd_bootbench_run.DFLT_SCHEMA,
+                        help='vswitch schema (default: %(default)s)')
+    parser.add_argument('--scales', default=DFLT_SCALES,
+                        help='comma separated interface counts (default: '
+                             '%(default)s)')
+    parser.add_argument('--qsfp-every', type=int, default=4,
+                        help='every Nth front panel port is a splittable '
+                             'QSFP28 port (default: %(default)s)')
+    parser.add_argument('--daemons', type=int, default=120)
+    parser.add_argument('--hw-daemons', type=int, default=8)
+    parser.add_argument('--packages', type=int, default=2000,
+                        help='version_detail.yaml entries (default: '
+                             '%(default)s)')
+    parser.add_argument('--delay', action='append', default=[],
+                        metavar='[NAME=]MSEC',
+                        help='time before a h/w daemon reports ready')
+    parser.add_argument('--proxy', metavar='OPTIONS',
+                        help='connect ops-sysd through sysd_ovsdb_proxy.py '
+                             'with these options')
+    parser.add_argument('--runs', type=int, default=3)
+    parser.add_argument('--timeout', type=int, default=600,
+                        help='per run timeout in seconds')
+    parser.add_argument('--keep', action='store_true',
+                        help='keep the work directory and logs')
+    args = parser.parse_args()
+    # Each run starts from a cold FRU cache.
+    args.warm_fru_cache = False
+
+    scales = [int(s) for s in args.scales.split(',') if s]
+    workdir = tempfile.mkdtemp(prefix='sysd-scale-')
+    try:
+        points = []
+        for ports in scales:
+            scaledir = os.path.join(workdir, 'ports-%d' % ports)
+            os.makedirs(scaledir)
+            gen_dir, manifest, version_detail = sysd_hwdesc_gen.generate(
+                os.path.join(scaledir, 'gen'), ports, args.qsfp_every,
+                args.daemons, args.hw_daemons, args.packages)
+            hw_desc_dir = os.path.join(scaledir, 'hwdesc')
+            sysd_bootbench_run.prepare_hw_desc(
+                gen_dir, hw_desc_dir, os.path.join(scaledir, 'fru.bin'))
+
+            runs = [sysd_bootbench_run.run_once(
+                        args, scaledir, hw_desc_dir, manifest,
+                        os.path.join(scaledir, 'fru_cache.json'),
+                        version_detail)
+                    for _ in range(args.runs)]
+            point = {'ports': ports,
+                     'summary': sysd_bootbench_run.summarize(runs),
+                     'runs': runs}
+            points.append(point)
+            sys.stderr.write('%d ports: %s\n'
+                             % (ports, json.dumps(point['summary'],
+                                                  sort_keys=True)))
+
+        json.dump({'config': {'qsfp_every': args.qsfp_every,
+                              'daemons': args.daemons,
+                              'hw_daemons': args.hw_daemons,
+                              'packages': args.packages,
+                              'delay': args.delay,
+                              'proxy': args.proxy,
+                              'runs': args.runs},
+                   'scales': points},
+                  sys.stdout, indent=4, sort_keys=True)
+        sys.stdout.write('\n')
+        return 0 if all(p['summary']['failed'] == 0 for p in points) else 1
+    finally:
+        if args.keep:
+            sys.stderr.write('work directory: %s\n' % workdir)
+        else:
+            shutil.rmtree(workdir, ignore_errors=True)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,57 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the ops-sysd arena allocator.
+ *
+ * An arena hands out zeroed memory from a few large chunks and frees it
+ * all at once. sysd keeps the state it builds at boot and never frees
+ * (daemons, subsystems, interfaces and the hardware description it still
+ * needs after boot) in sysd_state_arena, which packs it densely instead of
+ * spreading it over many small heap blocks.
+ */
+
+#ifndef __SYSD_ARENA_H__
+#define __SYSD_ARENA_H__
+
+/** @ingroup ops-sysd
+ * @{ */
+
+#include <stddef.h>
+
+#define SYSD_ARENA_CHUNK_SIZE   4096
+
+struct sysd_arena_chunk;
+
+struct sysd_arena {
+    struct sysd_arena_chunk *chunks;    /* Chunk being filled first. */
+    size_t                  chunk_size;
+    size_t                  n_chunks;
+    size_t                  n_bytes;    /* Obtained from malloc. */
+    size_t                  n_used;     /* Handed out, with alignment. */
+};
+
+#define SYSD_ARENA_INITIALIZER(CHUNK_SIZE) { NULL, CHUNK_SIZE, 0, 0, 0 }
+
+void *sysd_arena_alloc(struct sysd_arena *arena, size_t size);
+void *sysd_arena_memdup(struct sysd_arena *arena, const void *p, size_t size);
+char *sysd_arena_strdup(struct sysd_arena *arena, const char *s);
+void sysd_arena_destroy(struct sysd_arena *arena);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_ARENA_H__ */
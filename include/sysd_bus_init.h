@@ -0,0 +1,55 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for ops-sysd concurrent per-bus device initialization.
+ *
+ * Each I2C bus that has entries in the devices.yaml 'init' section gets a
+ * worker thread that runs that bus's entries in file order, so transactions
+ * on a bus stay serialized while separate buses proceed in parallel. The
+ * FRU EEPROM is read on its bus's worker once that bus is initialized.
+ *
+ * sysd only runs an init entry itself when it is a plain write:
+ *
+ *      device      device name from the 'devices' section
+ *      register    register address (one byte), or NONE to write the
+ *                  data bytes alone, as for an I2C mux
+ *      data        list of bytes to write
+ *
+ * Anything else (other keys, mux 'pre'/'post' operations on the device, a
+ * bus without 'dev_name', a single bus) makes sysd fall back to config-yaml's
+ * serial yaml_init_devices().
+ */
+
+#ifndef __SYSD_BUS_INIT_H__
+#define __SYSD_BUS_INIT_H__
+
+/** @ingroup ops-sysd
+ * @{ */
+
+#include <stdbool.h>
+
+/* Return values of sysd_bus_init_devices(). */
+#define SYSD_BUS_INIT_OK        0
+#define SYSD_BUS_INIT_FAILED    (-1)
+#define SYSD_BUS_INIT_SERIAL    1   /* Use yaml_init_devices() instead. */
+
+int sysd_bus_init_devices(const char *hw_desc_dir, bool read_fru);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_BUS_INIT_H__ */
@@ -0,0 +1,74 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the ops-sysd default topology template.
+ *
+ * The bridges, with their VLANs and internal ports, and the VRFs that the
+ * initial configuration creates are described by defaults.yaml in the
+ * hardware description directory. Without it, sysd creates the default
+ * bridge with its internal port and the default VRF, as it always has.
+ */
+
+#ifndef __SYSD_DEFAULTS_H__
+#define __SYSD_DEFAULTS_H__
+
+/** @ingroup ops-sysd
+ * @{ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SYSD_DEFAULTS_FILE      "defaults.yaml"
+
+#define SYSD_DEFAULTS_MIN_VLAN  1
+#define SYSD_DEFAULTS_MAX_VLAN  4094
+
+typedef struct sysd_default_vlan {
+    int64_t     id;
+    const char  *name;          /* NULL for "VLAN<id>". */
+    bool        admin_up;
+} sysd_default_vlan_t;
+
+typedef struct sysd_default_bridge {
+    const char          *name;
+    bool                internal_port;  /* Interface and port named after
+                                         * the bridge, for VLAN interfaces. */
+    size_t              n_vlans;
+    sysd_default_vlan_t *vlans;
+} sysd_default_bridge_t;
+
+typedef struct sysd_default_vrf {
+    const char  *name;
+    bool        has_table_id;
+    int64_t     table_id;
+} sysd_default_vrf_t;
+
+typedef struct sysd_defaults {
+    size_t                  n_bridges;
+    sysd_default_bridge_t   *bridges;
+    size_t                  n_vrfs;
+    sysd_default_vrf_t      *vrfs;
+} sysd_defaults_t;
+
+int sysd_defaults_load(const char *hw_desc_dir);
+const sysd_defaults_t *sysd_defaults_get(void);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_DEFAULTS_H__ */
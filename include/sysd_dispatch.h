@@ -0,0 +1,50 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for ops-sysd column change dispatch.
+ *
+ * Work that depends on a few database columns, such as applying the
+ * timezone, is registered here as a handler for those columns instead of
+ * being run on every IDL sequence number change. The IDL tracks changes to
+ * the registered columns, and sysd_dispatch_run() calls each handler whose
+ * columns changed, or whose table gained a row, since the last call.
+ * Handlers run in the order they were registered.
+ */
+
+#ifndef __SYSD_DISPATCH_H__
+#define __SYSD_DISPATCH_H__
+
+/** @ingroup ops-sysd
+ * @{ */
+
+#include <ovsdb-idl.h>
+
+#define SYSD_DISPATCH_MAX_HANDLERS  8
+#define SYSD_DISPATCH_MAX_COLUMNS   4   /* Per handler. */
+
+typedef void sysd_dispatch_cb(void);
+
+void sysd_dispatch_register(const char *name, sysd_dispatch_cb *cb,
+                            const struct ovsdb_idl_table_class *table,
+                            const struct ovsdb_idl_column *column);
+void sysd_dispatch_run(void);
+void sysd_dispatch_reset(void);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_DISPATCH_H__ */
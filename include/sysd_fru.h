@@ -26,10 +26,15 @@
 /** @ingroup ops-sysd
  * @{ */
 
+#include <stdbool.h>
 #include <stdint.h>
 
+struct json;
+
 #define SUPPORTED_OCP_FRU_EEPROM_VERSION    0x01
 
+#define FRU_EEPROM_DEVICE_NAME          "fru_eeprom"
+
 #define FRU_COUNTRY_CODE_LEN            2
 #define FRU_COUNTRY_CODE_TYPE           0x2c
 #define FRU_DEVICE_VERSION_LEN          1
@@ -51,10 +56,18 @@
 #define FRU_SERVICE_TAG_TYPE            0x2f
 #define FRU_VENDOR_TYPE                 0x2d
 #define FRU_VENDOR_EXTENSION_TYPE       0xfd
+#define FRU_VENDOR_EXT_IANA_LEN         4
 #define FRU_CRC_TYPE                    0xfe
 
 #define FRU_CRC_LEN                     6
 
+/* Vendor extension TLV, keyed by the vendor's IANA enterprise number. */
+typedef struct fru_vendor_ext {
+    uint32_t        iana;
+    uint8_t         len;
+    const uint8_t   *data;
+} fru_vendor_ext_t;
+
 typedef struct fru_eeprom {
     char        country_code[FRU_COUNTRY_CODE_LEN+1];
     char        device_version;
@@ -71,6 +84,11 @@ typedef struct fru_eeprom {
     char        *serial_number;
     char        *service_tag;
     char        *vendor;
+    fru_vendor_ext_t    *vendor_exts;
+    int                 n_vendor_exts;
+    /* Single allocation backing the strings and vendor extensions decoded
+     * from the EEPROM. NULL when the fields came from fru.yaml. */
+    char        *arena;
 } fru_eeprom_t;
 
 /* local structs */
@@ -86,7 +104,11 @@ typedef struct fru_tlv {
     char            value[255];
 } fru_tlv_t;
 
+bool sysd_process_eeprom(unsigned char *buf, fru_eeprom_t *fru_eeprom, int len);
 int sysd_read_fru_eeprom(fru_eeprom_t *fru_eeprom);
+void sysd_fru_prefetch(void);
+void sysd_fru_set_cache_file(const char *path);
+struct json *sysd_fru_to_json(const fru_eeprom_t *fru_eeprom);
 
 /** @} end of group ops-sysd */
 #endif /* __SYSD_FRU_H__ */
@@ -0,0 +1,82 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for ops-sysd FRU EEPROM transports.
+ *
+ * The transport used to read a FRU EEPROM is chosen per device with the
+ * optional 'transport' key of its devices.yaml entry:
+ *
+ *      config_yaml   config-yaml's i2c_data_read() (default)
+ *      sysfs         kernel at24 'eeprom' file, read with one pread().
+ *                    'path' defaults to
+ *                    /sys/bus/i2c/devices/<bus>-<address>/eeprom
+ *      i2c_dev       i2c-dev I2C_RDWR transfers of at most 'max_xfer'
+ *                    bytes (default 32), with an 'offset_width' byte
+ *                    (1 or 2, default 1) offset write before each read
+ *      file          plain file at 'path', for tests and simulation
+ */
+
+#ifndef __SYSD_FRU_XPORT_H__
+#define __SYSD_FRU_XPORT_H__
+
+/** @ingroup ops-sysd
+ * @{ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct smap;
+
+#define FRU_XPORT_KEY               "transport"
+#define FRU_XPORT_PATH_KEY          "path"
+#define FRU_XPORT_MAX_XFER_KEY      "max_xfer"
+#define FRU_XPORT_OFFSET_WIDTH_KEY  "offset_width"
+
+#define FRU_XPORT_DFLT_MAX_XFER     32
+
+struct sysd_fru_xport;
+
+struct sysd_fru_xport_class {
+    const char *name;
+
+    /* Returns a new transport for the device described by 'dev_cfg' and
+     * 'bus_cfg', or NULL if the device cannot be accessed this way. */
+    struct sysd_fru_xport *(*open)(const struct smap *dev_cfg,
+                                   const struct smap *bus_cfg);
+
+    /* Reads 'len' bytes at 'offset' into 'buf'. */
+    bool (*read)(struct sysd_fru_xport *, size_t offset, void *buf,
+                 size_t len);
+
+    void (*close)(struct sysd_fru_xport *);
+};
+
+struct sysd_fru_xport {
+    const struct sysd_fru_xport_class *class;
+    size_t bytes_read;          /* Total of successful reads. */
+};
+
+struct sysd_fru_xport *sysd_fru_xport_open(const char *hw_desc_dir,
+                                           const char *dev_name);
+bool sysd_fru_xport_read(struct sysd_fru_xport *, size_t offset, void *buf,
+                         size_t len);
+void sysd_fru_xport_close(struct sysd_fru_xport *);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_FRU_XPORT_H__ */
@@ -0,0 +1,59 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the ops-sysd initial configuration snapshot.
+ *
+ * After sysd writes the initial configuration to an empty database, it
+ * saves the rows of that transaction to a file together with a fingerprint
+ * of everything they were built from: the hardware description files, the
+ * FRU EEPROM contents, the image manifest and os-release. When sysd later
+ * finds an empty database and the fingerprint still matches, for instance
+ * after a factory reset, it sends the saved rows to ovsdb-server as one
+ * transact request instead of building the transaction again. Any failure
+ * falls back to building it.
+ */
+
+#ifndef __SYSD_GOLDEN_H__
+#define __SYSD_GOLDEN_H__
+
+/** @ingroup ops-sysd
+ * @{ */
+
+#include <stdbool.h>
+#include <ovsdb-idl.h>
+
+/* Bumped whenever the snapshot layout changes. */
+#define SYSD_GOLDEN_VERSION     1
+
+void sysd_golden_set_file(const char *path);
+void sysd_golden_init(const char *remote, const char *manifest_file);
+
+void sysd_golden_capture_begin(void);
+void sysd_golden_note_insert(const struct ovsdb_idl_table_class *table,
+                             const struct ovsdb_idl_row *row);
+void sysd_golden_capture(void);
+void sysd_golden_capture_done(enum ovsdb_idl_txn_status status);
+
+bool sysd_golden_replay_start(void);
+bool sysd_golden_replay_pending(void);
+bool sysd_golden_run(void);
+void sysd_golden_wait(void);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_GOLDEN_H__ */
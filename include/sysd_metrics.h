@@ -0,0 +1,90 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for ops-sysd runtime metrics.
+ *
+ * Counters, gauges and histograms kept by the main loop and the OVSDB and
+ * FRU code, reported in Prometheus text format by 'ops-sysd/metrics'.
+ * Everything is updated from the main thread, except for the FRU read,
+ * which may run on a bus init worker before it is joined.
+ */
+
+#ifndef __SYSD_METRICS_H__
+#define __SYSD_METRICS_H__
+
+/** @ingroup ops-sysd
+ * @{ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <ovsdb-idl.h>
+
+struct ds;
+
+/* Places sysd commits OVSDB transactions from. */
+enum sysd_txn_site {
+    SYSD_TXN_INITIAL_CONFIG,
+    SYSD_TXN_HW_DONE,
+    SYSD_TXN_PACKAGE_INFO,
+    SYSD_TXN_SW_INFO,
+    SYSD_TXN_INTERFACES,
+    SYSD_TXN_RECONCILE,
+    SYSD_TXN_N_SITES
+};
+
+void sysd_metrics_loop_woke(void);
+void sysd_metrics_loop_sleeping(void);
+void sysd_metrics_run_time(long long msec);
+void sysd_metrics_seqno_changed(void);
+
+/* Commits taking at least this long are logged, unless it is 0. */
+#define SYSD_SLOW_COMMIT_MSEC_DFLT  1000
+
+void sysd_metrics_set_slow_commit_msec(long long msec);
+
+const char *sysd_metrics_txn_site_name(enum sysd_txn_site site);
+
+/* Returns the rows counted by sysd_metrics_rows_written() since the last
+ * call. */
+unsigned int sysd_metrics_txn_rows_take(void);
+
+/* Records a commit against 'site' that reached 'status': built from
+ * 'build_ns' to 'commit_ns' (sysd_trace_now() values), committed from then
+ * until now, writing 'rows' rows. */
+void sysd_metrics_txn_done(enum sysd_txn_site site,
+                           enum ovsdb_idl_txn_status status, uint64_t build_ns,
+                           uint64_t commit_ns, unsigned int rows);
+void sysd_metrics_rows_written(const struct ovsdb_idl_table_class *table,
+                               unsigned int n);
+void sysd_metrics_rows_settle(bool committed);
+void sysd_metrics_txn_coalesced(unsigned int n);
+void sysd_metrics_txn_retry(enum sysd_txn_site site);
+void sysd_metrics_package_info_rows(unsigned int n);
+void sysd_metrics_fru_read(size_t bytes, long long msec);
+void sysd_metrics_timezone_applied(void);
+
+/* Resident set and malloc heap sizes in bytes, or -1 if unknown. */
+long long sysd_metrics_rss_bytes(void);
+long long sysd_metrics_heap_bytes(void);
+
+void sysd_metrics_format(struct ds *ds);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_METRICS_H__ */
@@ -0,0 +1,66 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for ops-sysd conditional OVSDB monitoring.
+ *
+ * sysd reads only a few of the Interface and Daemon rows it replicates, and
+ * only while it boots. Other daemons keep updating those tables, so sysd
+ * asks ovsdb-server to send it just the rows its current phase needs:
+ *
+ *   RECONCILE  Interface rows of type "system", which are the ones sysd
+ *              creates, and every Daemon row. Reconciliation rewrites
+ *              Subsystem:interfaces and System:daemons from these, so none
+ *              may be missing.
+ *   HW_WAIT    Interface rows of type "system", still needed by interface
+ *              batches, and the Daemon rows of h/w daemons, whose cur_hw
+ *              sysd waits for.
+ *   RUNNING    No Interface or Daemon rows at all.
+ *
+ * sysd goes back to RECONCILE when it loses its lock.
+ *
+ * Package_Info rows are replicated, in any phase, only while sysd replaces
+ * rows written from another version_detail file. sysd only writes the
+ * other Package_Info columns and the Interface user_config column, so
+ * they are not monitored at all.
+ *
+ * Conditions need an OVS 2.8 or later IDL (HAVE_OVSDB_IDL_CONDITIONS).
+ * Without one, whole tables are replicated, Package_Info included, and
+ * each phase is synced as soon as the IDL is.
+ */
+
+#ifndef __SYSD_MONITOR_H__
+#define __SYSD_MONITOR_H__
+
+/** @ingroup ops-sysd
+ * @{ */
+
+#include <stdbool.h>
+
+enum sysd_monitor_phase {
+    SYSD_MONITOR_RECONCILE,
+    SYSD_MONITOR_HW_WAIT,
+    SYSD_MONITOR_RUNNING,
+};
+
+void sysd_monitor_init(void);
+bool sysd_monitor_run(enum sysd_monitor_phase phase, bool packages);
+bool sysd_monitor_synced(void);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_MONITOR_H__ */
@@ -26,12 +26,44 @@
 /** @ingroup ops-sysd
  * @{ */
 
+#include <stdbool.h>
+
 #define SYSD_MAC_FORMAT(a)	a[0], a[1], a[2], a[3], a[4], a[5]
 
 #define SYSD_OVS_PTR_CALLOC(OVS_STR, count)		\
 			(struct  OVS_STR *) calloc(sizeof(struct OVS_STR), count)
 
-void sysd_dump(char* buf, int buflen);
+/* Chassis with more interfaces than this add them to the db in batches of
+ * this many rows after the rest of the initial configuration. */
+#define SYSD_INTF_BATCH_SIZE_DFLT   512
+
+struct ds;
+struct smap;
+struct ovsdb_idl_txn;
+struct ovsrec_daemon;
+struct ovsrec_interface;
+struct ovsrec_subsystem;
+
+void sysd_build_hw_intf_info(struct smap *hw_intf_info,
+                             const sysd_subsystem_t *subsys_ptr,
+                             const sysd_intf_info_t *intf_ptr);
+void sysd_hw_intf_templates_clear(void);
+void sysd_build_subsystem_other_info(struct smap *other_info,
+                                     const sysd_subsystem_t *subsys_ptr);
+struct ovsrec_interface *sysd_initial_interface_add(
+    struct ovsdb_idl_txn *txn, sysd_subsystem_t *subsys_ptr,
+    sysd_intf_info_t *intf_ptr);
+struct ovsrec_subsystem *sysd_initial_subsystem_add(
+    struct ovsdb_idl_txn *txn, sysd_subsystem_t *subsys_ptr,
+    bool add_interfaces);
+struct ovsrec_daemon *sysd_initial_daemon_add(struct ovsdb_idl_txn *txn,
+                                              daemon_info_t *daemon_ptr);
+int package_info_mapping_check_key(const char *data);
+void sysd_set_version_detail_file(const char *path);
+void sysd_set_intf_batch_size(int n);
+void sysd_register_change_handlers(void);
+
+void sysd_dump(struct ds *ds, bool json);
 void sysd_run(void);
 void sysd_wait(void);
 
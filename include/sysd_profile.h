@@ -0,0 +1,49 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the ops-sysd sampling CPU profiler.
+ *
+ * 'ops-sysd/profile start' arms an ITIMER_PROF timer whose SIGPROF
+ * handler records the interrupted call stack by walking frame pointers.
+ * 'ops-sysd/profile stop' writes the samples as folded stacks, one
+ * "caller;callee count" line per distinct stack, which flamegraph.pl and
+ * similar tools read directly. Functions are named through dladdr(), so
+ * ops-sysd is linked with -rdynamic; addresses that cannot be named are
+ * written as module+offset for addr2line.
+ */
+
+#ifndef __SYSD_PROFILE_H__
+#define __SYSD_PROFILE_H__
+
+/** @ingroup ops-sysd
+ * @{ */
+
+struct ds;
+
+#define SYSD_PROFILE_DFLT_HZ        99
+#define SYSD_PROFILE_MAX_HZ         1000
+#define SYSD_PROFILE_MAX_SAMPLES    8192
+#define SYSD_PROFILE_MAX_DEPTH      32
+
+/* Both return NULL on success or an error message the caller frees. */
+char *sysd_profile_start(unsigned int hz);
+char *sysd_profile_stop(const char *file, struct ds *summary);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_PROFILE_H__ */
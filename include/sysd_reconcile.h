@@ -0,0 +1,45 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for ops-sysd restart reconciliation.
+ *
+ * When sysd starts against a database that already has a System row, left
+ * by an earlier run or by the image before an upgrade, it compares what the
+ * hardware description, FRU EEPROM and image manifest call for with the
+ * rows in the IDL replica, and writes only the differences: missing
+ * subsystems, interfaces and daemons are added, changed hardware columns
+ * are updated, and rows that are no longer described are dropped.
+ */
+
+#ifndef __SYSD_RECONCILE_H__
+#define __SYSD_RECONCILE_H__
+
+/** @ingroup ops-sysd
+ * @{ */
+
+#include <stdbool.h>
+
+void sysd_reconcile_run(void);
+void sysd_reconcile_reset(void);
+void sysd_reconcile_skip(void);
+bool sysd_reconcile_pending(void);
+bool sysd_reconcile_done(void);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_RECONCILE_H__ */
@@ -0,0 +1,69 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the ops-sysd flight recorder.
+ *
+ * A fixed size ring of binary events with CLOCK_MONOTONIC nanosecond
+ * timestamps. Recording takes no lock, so it is safe from the bus init
+ * workers as well as the main loop; once the ring is full the oldest
+ * events are overwritten. 'ops-sysd/trace' prints it, and it is written
+ * to <rundir>/ops-sysd.trace when sysd dies on a signal or exits
+ * without going through sysd_trace_clean_exit().
+ */
+
+#ifndef __SYSD_TRACE_H__
+#define __SYSD_TRACE_H__
+
+/** @ingroup ops-sysd
+ * @{ */
+
+#include <stdint.h>
+
+struct ds;
+
+/* Number of events kept. Must be a power of two. */
+#define SYSD_TRACE_RING_SIZE    4096
+
+enum sysd_trace_type {
+    SYSD_TRACE_PHASE_START,     /* name */
+    SYSD_TRACE_PHASE_STOP,      /* name, a = usec since the start */
+    SYSD_TRACE_TXN_COMMIT,      /* call site, a = rows, b = usec,
+                                 * c = enum ovsdb_idl_txn_status */
+    SYSD_TRACE_DAEMON,          /* daemon, a = cur_hw, b = is_hw_handler */
+    SYSD_TRACE_FILE,            /* path, a = entries read, c = rc */
+    SYSD_TRACE_ERROR,           /* where, c = rc or errno */
+    SYSD_TRACE_N_TYPES
+};
+
+void sysd_trace_init(void);
+void sysd_trace_clean_exit(void);
+
+uint64_t sysd_trace_now(void);
+void sysd_trace(enum sysd_trace_type type, const char *name, int64_t a,
+                int64_t b, int32_t c);
+
+/* Records the start of phase 'name' and returns the time to pass to
+ * sysd_trace_phase_stop(). */
+uint64_t sysd_trace_phase_start(const char *name);
+void sysd_trace_phase_stop(const char *name, uint64_t start);
+
+void sysd_trace_format(struct ds *ds, unsigned int max_events);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_TRACE_H__ */
@@ -0,0 +1,78 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the ops-sysd OVSDB transaction queue.
+ *
+ * Every write sysd makes to OVSDB is a job on a FIFO queue. The job at the
+ * head is built into a transaction and committed with the non-blocking
+ * ovsdb_idl_txn_commit() from sysd_run(), so the main loop keeps serving
+ * IDL updates and ovs-appctl while the commit is in flight. A job whose
+ * commit fails is built again from the current IDL contents after a
+ * jittered exponential backoff: after TXN_TRY_AGAIN once the database has
+ * also changed, after TXN_NOT_LOCKED once sysd holds its lock again. Both
+ * are retried until the commit goes through; TXN_ERROR is retried a few
+ * times before the job is given up.
+ *
+ * Jobs that only update a few columns (software info, h/w done) are built
+ * into the same transaction as the jobs queued around them, so everything
+ * queued during one sysd_run() pass is committed in as few round trips as
+ * possible. Each bulk job (initial configuration, a batch of interfaces or
+ * packages, reconciliation) still gets a transaction of its own.
+ */
+
+#ifndef __SYSD_TXN_H__
+#define __SYSD_TXN_H__
+
+/** @ingroup ops-sysd
+ * @{ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <ovsdb-idl.h>
+
+#include "sysd_metrics.h"
+
+/* Backoff before the first retry, doubled for each one after it. */
+#define SYSD_TXN_BACKOFF_MIN_MSEC   50
+#define SYSD_TXN_BACKOFF_MAX_MSEC   5000
+
+/* Attempts at a job whose commits fail with TXN_ERROR. */
+#define SYSD_TXN_MAX_ERROR_ATTEMPTS 8
+
+/* Adds the job's changes to 'txn', reading the current IDL contents. May
+ * run more than once for a job, including after a commit whose outcome was
+ * lost with the connection, so it must not add what is already there.
+ * Returns false if there turns out to be nothing to write, which completes
+ * the job with TXN_UNCHANGED. */
+typedef bool sysd_txn_build_cb(struct ovsdb_idl_txn *txn, void *aux);
+
+/* Called once with the job's final status, never TXN_INCOMPLETE,
+ * TXN_TRY_AGAIN or TXN_NOT_LOCKED. A job that added nothing gets
+ * TXN_UNCHANGED even if the transaction it shared committed other jobs'
+ * changes. May free 'aux' and submit further jobs. */
+typedef void sysd_txn_done_cb(enum ovsdb_idl_txn_status status, void *aux);
+
+void sysd_txn_submit(enum sysd_txn_site site, sysd_txn_build_cb *build,
+                     sysd_txn_done_cb *done, void *aux);
+void sysd_txn_run(void);
+void sysd_txn_wait(void);
+size_t sysd_txn_n_pending(void);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_TXN_H__ */
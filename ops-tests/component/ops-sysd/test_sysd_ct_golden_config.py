@@ -0,0 +1,105 @@
+# (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+
+TOPOLOGY = """
+#
+# +-------+
+# |  sw1  |
+# +-------+
+#
+
+# Nodes
+[type=openswitch name="Switch 1"] sw1
+"""
+
+from pytest import mark
+from time import sleep
+import json
+
+
+ovs_vsctl = "/usr/bin/ovs-vsctl "
+ovs_appctl = "/usr/bin/ovs-appctl "
+ovsdb_tool = "/usr/bin/ovsdb-tool "
+golden_file = "/var/lib/ops-sysd/golden_config.json"
+
+# Columns sysd writes in the initial configuration. References are left
+# out, since their uuids differ from one database to the next.
+sysd_columns = {
+    "System": "switch_version,software_info,management_mac,system_mac,"
+              "mgmt_intf",
+    "Subsystem": "name,asset_tag_number,hw_desc_dir,other_info,"
+                 "next_mac_address,macs_remaining",
+    "Interface": "name,type,hw_intf_info,user_config",
+}
+
+
+def restart_with_empty_db(dut):
+    """Restart sysd on a new, empty database."""
+    dut(ovs_appctl + "-t ops-sysd exit", shell="bash")
+    dut(ovs_appctl + "-t ovsdb-server ovsdb-server/remove-db "
+        "OpenSwitch", shell="bash")
+    dut("/bin/rm -f /var/run/openvswitch/ovsdb.db", shell="bash")
+    sleep(3)
+
+    dut(ovsdb_tool + "create /var/run/openvswitch/ovsdb.db "
+        "/usr/share/openvswitch/vswitch.ovsschema", shell="bash")
+    dut(ovs_appctl + "-t ovsdb-server ovsdb-server/add-db "
+        "/var/run/openvswitch/ovsdb.db", shell="bash")
+    sleep(3)
+    dut("/bin/systemctl start ops-sysd", shell="bash")
+
+    wait_count = 20
+    while wait_count > 0:
+        if "_uuid" in dut(ovs_vsctl + "list System | grep uuid",
+                          shell="bash"):
+            break
+        wait_count -= 1
+        sleep(1)
+    assert wait_count != 0
+
+
+def sysd_rows(dut):
+    """Return the sysd columns of the System, Subsystem and Interface
+    rows, sorted so that two databases can be compared."""
+    rows = {}
+    for table, columns in sysd_columns.items():
+        out = dut(ovs_vsctl + "--format=json --columns=" + columns +
+                  " list " + table, shell="bash")
+        rows[table] = sorted(json.dumps(row, sort_keys=True)
+                             for row in json.loads(out)["data"])
+    return rows
+
+
+@mark.gate
+def test_golden_config_replay_sysd_ct(topology, step):
+    sw1 = topology.get('sw1')
+
+    assert sw1 is not None
+
+    step("Build the initial configuration and keep a snapshot of it")
+    sw1("/bin/rm -f " + golden_file, shell="bash")
+    restart_with_empty_db(sw1)
+    built = sysd_rows(sw1)
+    assert built["Interface"]
+    # The snapshot is written once sysd sees its transaction commit.
+    sleep(3)
+    assert golden_file in sw1("ls " + golden_file, shell="bash")
+
+    step("Restart with an empty database on the same platform and image")
+    restart_with_empty_db(sw1)
+    trace = sw1(ovs_appctl + "-t ops-sysd ops-sysd/trace", shell="bash")
+    assert "golden_replay" in trace
+
+    step("Compare the replayed rows with the built ones")
+    assert sysd_rows(sw1) == built
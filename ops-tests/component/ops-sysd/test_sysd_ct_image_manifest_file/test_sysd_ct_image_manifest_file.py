@@ -45,26 +45,51 @@ image_manifest_files_dir = "test_manifest_files"
 system_image_manifest_files = "/etc/openswitch/image.manifest"
 
 
-def image_manifest_read(dut, file_name):
+def image_manifest_read(dut, file_name, keep_db=False):
     """Testing ops-sysd correctly parse image manifest file
 
     Test if the ops-sysd correctly parse the image manifest file and stores
-    the information in the OVSDB.
+    the information in the OVSDB. With keep_db, only ops-sysd is started,
+    on the database it left behind.
     """
     # Copy a new image.manifest file to the switch
     copy_image_manifest_file(dut, file_name)
 
-    # Restart the ovsdb-server and sysd
-    start(dut)
+    # Restart the ovsdb-server and sysd, or sysd alone
+    if keep_db:
+        start_sysd(dut)
+    else:
+        start(dut)
 
     # Make sure that the data in ovsdb-server matches the local file.
-    ovsdb_daemons_list = list_daemons(dut)
     file_daemons_list = read_image_manifest_file(dut, file_name)
+    wait_count = 20
+    while wait_count > 0:
+        ovsdb_daemons_list = list_daemons(dut)
+        if ovsdb_daemons_list == file_daemons_list:
+            break
+
+        wait_count -= 1
+        sleep(1)
     print(ovsdb_daemons_list)
     print(file_daemons_list)
     assert ovsdb_daemons_list == file_daemons_list
 
 
+def image_manifest_upgrade(dut, file_name):
+    """Testing ops-sysd reconciles the Daemon table after an upgrade
+
+    Boot with the default image.manifest, then restart ops-sysd alone with
+    a new image.manifest, keeping the database. The Daemon table must match
+    the new file without the database being cleared.
+    """
+    start(dut)
+
+    stop_sysd(dut)
+    sleep(3)
+    image_manifest_read(dut, file_name, keep_db=True)
+
+
 def list_daemons(dut):
     """Get daemon table from ovsdb-server."""
     daemon_list = {}
@@ -217,3 +242,13 @@ def test_sysd_ct_image_add_random_stuff(topology, step, main_setup, setup):
     assert ops1 is not None
 
     image_manifest_read(ops1, "image.manifest3")
+
+
+@pytest.mark.platform_incompatible(['ostl'])
+@mark.gate
+def test_sysd_ct_image_upgrade_reconciles_daemons(topology, step, main_setup,
+                                                  setup):
+    ops1 = topology.get("ops1")
+    assert ops1 is not None
+
+    image_manifest_upgrade(ops1, "image.manifest1")
@@ -34,3 +34,17 @@ def test_show_version_detail_sysd_ct(topology):
 
     output = sw1('ovsdb-client dump Package_Info', shell='bash')
     assert "ops-sysd" in output
+
+
+@mark.gate
+def test_package_info_source_recorded_sysd_ct(topology):
+    sw1 = topology.get('sw1')
+
+    assert sw1 is not None
+
+    # sysd records the file Package_Info was written from, so it is not
+    # written again on restart.
+    recorded = sw1('ovs-vsctl get System . '
+                   'other_info:sysd_package_info_sha1', shell='bash')
+    digest = sw1('sha1sum /var/lib/version_detail.yaml', shell='bash')
+    assert recorded.strip().strip('"') == digest.split()[0]
@@ -41,14 +41,13 @@
 VLOG_DEFINE_THIS_MODULE(acl_init_limits);
 
 /**
- * Initializes acl max acls and max aces for the given txn and system_row.
+ * Sets the acl limits from the hardware description in 'smap', a copy of
+ * the System other_info column.
  */
 void
-acl_init_limits(struct ovsdb_idl_txn *txn,
-                struct ovsrec_system *system_row)
+acl_limits_to_smap(struct smap *smap)
 {
     YamlAclInfo *acl_info;
-    struct smap smap;
     char max_acls_str[ACL_LIMIT_BUFFER_SIZE];
     char max_aces_str[ACL_LIMIT_BUFFER_SIZE];
     char max_aces_per_acl_str[ACL_LIMIT_BUFFER_SIZE];
@@ -60,11 +59,23 @@ acl_init_limits(struct ovsdb_idl_txn *txn,
     snprintf(max_aces_str, ACL_LIMIT_BUFFER_SIZE, "%d", acl_info->max_aces);
     snprintf(max_aces_per_acl_str, ACL_LIMIT_BUFFER_SIZE, "%d", acl_info->max_aces_per_acl);
 
+    smap_replace(smap, ACL_LIMIT_KEY_MAX_ACLS, max_acls_str);
+    smap_replace(smap, ACL_LIMIT_KEY_MAX_ACES, max_aces_str);
+    smap_replace(smap, ACL_LIMIT_KEY_MAX_ACES_PER_ACL, max_aces_per_acl_str);
+}
+
+/**
+ * Initializes acl max acls and max aces for the given txn and system_row.
+ */
+void
+acl_init_limits(struct ovsdb_idl_txn *txn,
+                struct ovsrec_system *system_row)
+{
+    struct smap smap;
+
     /* Store acl limitations in other_info column */
     smap_clone(&smap, &system_row->other_info);
-    smap_replace(&smap, ACL_LIMIT_KEY_MAX_ACLS, max_acls_str);
-    smap_replace(&smap, ACL_LIMIT_KEY_MAX_ACES, max_aces_str);
-    smap_replace(&smap, ACL_LIMIT_KEY_MAX_ACES_PER_ACL, max_aces_per_acl_str);
+    acl_limits_to_smap(&smap);
     ovsrec_system_set_other_info(system_row, &smap);
     smap_destroy(&smap);
     return;
@@ -29,3 +29,8 @@
  */
 void acl_init_limits(struct ovsdb_idl_txn *txn,
                      struct ovsrec_system *system_row);
+
+/**
+ * Sets the acl limits in a copy of System other_info.
+ */
+void acl_limits_to_smap(struct smap *smap);
@@ -25,6 +25,8 @@
 
 #include "config-yaml.h"
 #include "sysd_cfg_yaml.h"
+#include "sysd_golden.h"
+#include "sysd_metrics.h"
 #include "sysd_qos_utils.h"
 #include "smap.h"
 #include "util.h"
@@ -103,6 +105,9 @@ insert_queue_profile_queue_row(struct ovsrec_q_profile *profile_row,
     /* Create the queue row. */
     struct ovsrec_q_profile_entry *queue_row =
         ovsrec_q_profile_entry_insert(txn);
+    sysd_golden_note_insert(&ovsrec_table_q_profile_entry,
+                            &queue_row->header_);
+    sysd_metrics_rows_written(&ovsrec_table_q_profile_entry, 1);
 
     /* Update the profile row. */
     int64_t *key_list =
@@ -140,6 +145,9 @@ qos_queue_profile_command(struct ovsdb_idl_txn *txn,
     if (profile_row == NULL) {
         /* Create a new row. */
         profile_row = ovsrec_q_profile_insert(txn);
+        sysd_golden_note_insert(&ovsrec_table_q_profile,
+                                &profile_row->header_);
+        sysd_metrics_rows_written(&ovsrec_table_q_profile, 1);
         ovsrec_q_profile_set_name(profile_row, profile_name);
     }
 
@@ -286,6 +294,8 @@ insert_schedule_profile_queue_row(struct ovsrec_qos *profile_row,
     /* Create the queue row. */
     struct ovsrec_queue *queue_row =
         ovsrec_queue_insert(txn);
+    sysd_golden_note_insert(&ovsrec_table_queue, &queue_row->header_);
+    sysd_metrics_rows_written(&ovsrec_table_queue, 1);
 
     /* Update the profile row. */
     int64_t *key_list =
@@ -323,6 +333,8 @@ qos_schedule_profile_command(struct ovsdb_idl_txn *txn,
     if (profile_row == NULL) {
         /* Create a new row. */
         profile_row = ovsrec_qos_insert(txn);
+        sysd_golden_note_insert(&ovsrec_table_qos, &profile_row->header_);
+        sysd_metrics_rows_written(&ovsrec_table_qos, 1);
         ovsrec_qos_set_name(profile_row, profile_name);
     }
 
@@ -507,8 +519,12 @@ qos_init_cos_map(struct ovsdb_idl_txn *txn,
     for (i = 0; i < QOS_COS_MAP_ENTRY_COUNT; i++) {
         struct ovsrec_qos_cos_map_entry *cos_map_row =
             ovsrec_qos_cos_map_entry_insert(txn);
+        sysd_golden_note_insert(&ovsrec_table_qos_cos_map_entry,
+                                &cos_map_row->header_);
         cos_map_rows[i] = cos_map_row;
     }
+    sysd_metrics_rows_written(&ovsrec_table_qos_cos_map_entry,
+                              QOS_COS_MAP_ENTRY_COUNT);
 
     /* Update the cos-map rows. */
     qos_init_default_cos_map(cos_map_rows);
@@ -634,8 +650,12 @@ qos_init_dscp_map(struct ovsdb_idl_txn *txn,
     for (i = 0; i < QOS_DSCP_MAP_ENTRY_COUNT; i++) {
         struct ovsrec_qos_dscp_map_entry *dscp_map_row =
             ovsrec_qos_dscp_map_entry_insert(txn);
+        sysd_golden_note_insert(&ovsrec_table_qos_dscp_map_entry,
+                                &dscp_map_row->header_);
         dscp_map_rows[i] = dscp_map_row;
     }
+    sysd_metrics_rows_written(&ovsrec_table_qos_dscp_map_entry,
+                              QOS_DSCP_MAP_ENTRY_COUNT);
 
     /* Update the dscp-map rows. */
     qos_init_default_dscp_map(dscp_map_rows);
@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <getopt.h>
+#include <malloc.h>
 
 #include <command-line.h>
 #include <dirs.h>
@@ -36,6 +37,7 @@
 #include <daemon.h>
 #include <fatal-signal.h>
 #include <dynamic-string.h>
+#include <timeval.h>
 
 #include <ops-utils.h>
 #include <config-yaml.h>
@@ -43,6 +45,13 @@
 #include "sysd.h"
 #include "sysd_util.h"
 #include "sysd_ovsdb_if.h"
+#include "sysd_defaults.h"
+#include "sysd_fru.h"
+#include "sysd_golden.h"
+#include "sysd_metrics.h"
+#include "sysd_monitor.h"
+#include "sysd_profile.h"
+#include "sysd_trace.h"
 
 #include "eventlog.h"
 #include "diag_dump.h"
@@ -52,23 +61,19 @@ VLOG_DEFINE_THIS_MODULE(ops_sysd);
 /** @ingroup ops-sysd
  * @{ */
 
-#define BUF_LEN 16000
-#define MAX_ERR_STR_LEN 255
+extern char *g_hw_desc_dir;
 
-/* OVSDB IDL used to obtain configuration. */
-struct ovsdb_idl *idl;
-uint32_t         idl_seqno = 0;
-int              num_subsystems = 0;
-sysd_subsystem_t **subsystems = NULL;
+/* Image manifest to process, overridable with --manifest. */
+static const char *manifest_file = IMAGE_MANIFEST_FILE_PATH;
 
-char *g_hw_desc_dir = "/";
+/* Set by --hw-desc-dir; skips the dmidecode based platform lookup. */
+static bool hw_desc_dir_set = false;
 
-daemon_info_t **daemons = NULL;
-int num_daemons = 0;
-int num_hw_daemons = 0;
-
-/* Structure to store management info read */
-mgmt_intf_info_t *mgmt_intf = NULL;
+/* Heap and RSS before and after sysd_compact_boot_state(). */
+static struct {
+    long long   heap;
+    long long   rss;
+} mem_boot, mem_compacted;
 
 /*
  * Function       : sysd_diag_dump_basic_cb
@@ -82,41 +87,131 @@ mgmt_intf_info_t *mgmt_intf = NULL;
 static void
 sysd_diag_dump_basic_cb(const char *feature , char **buf)
 {
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
     if (!buf)
         return;
-    *buf =  xcalloc(1, BUF_LEN);
-    if (*buf) {
-        /* populate basic diagnostic data to buffer  */
-        sysd_dump(*buf, BUF_LEN);
-        VLOG_DBG("basic diag-dump data populated for feature %s",
-                feature);
-    } else{
-        VLOG_ERR("Memory allocation failed for feature %s, %d bytes",
-                feature, BUF_LEN);
-    }
+    /* populate basic diagnostic data to buffer  */
+    sysd_dump(&ds, false);
+    *buf = ds_steal_cstr(&ds);
+    VLOG_DBG("basic diag-dump data populated for feature %s", feature);
 }
 
 /* Dumps debug data for entire daemon */
 static void
-sysd_unixctl_dump(struct unixctl_conn *conn, int argc OVS_UNUSED,
-                          const char *argv[] OVS_UNUSED, void *aux OVS_UNUSED)
+sysd_unixctl_dump(struct unixctl_conn *conn, int argc,
+                  const char *argv[], void *aux OVS_UNUSED)
 {
-    char err_str[MAX_ERR_STR_LEN];
-    char *buf = xcalloc(1, BUF_LEN);
+    struct ds   ds = DS_EMPTY_INITIALIZER;
+    bool        json = false;
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "--json")) {
+            unixctl_command_reply_error(conn, "usage: ops-sysd/dump [--json]");
+            return;
+        }
+        json = true;
+    }
 
     /* Dump the daemon info */
-    if (buf){
-        strcpy(buf, "Support Dump for Platform SYS Daemon (ops-sysd)\n\n");
-        sysd_dump(buf, BUF_LEN);
-        unixctl_command_reply(conn, buf);
-        free(buf);
-    } else {
-        snprintf(err_str, sizeof(err_str),
-                "sysd daemon failed to allocate %d bytes\n", BUF_LEN);
-        unixctl_command_reply(conn, err_str);
+    if (!json) {
+        ds_put_cstr(&ds, "Support Dump for Platform SYS Daemon (ops-sysd)\n\n");
     }
+    sysd_dump(&ds, json);
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
 } /* sysd_unixctl_dump */
 
+/* Reports runtime metrics in Prometheus text format. */
+static void
+sysd_unixctl_metrics(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                     const char *argv[] OVS_UNUSED, void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    sysd_metrics_format(&ds);
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+
+} /* sysd_unixctl_metrics */
+
+/* Prints the last COUNT (default all) flight recorder events. */
+static void
+sysd_unixctl_trace(struct unixctl_conn *conn, int argc,
+                   const char *argv[], void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    unsigned int count = SYSD_TRACE_RING_SIZE;
+
+    if (argc > 1) {
+        count = strtoul(argv[1], NULL, 10);
+    }
+    sysd_trace_format(&ds, count);
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+
+} /* sysd_unixctl_trace */
+
+/* Reports memory use at the end of boot, after the hardware description
+ * was released, and now. */
+static void
+sysd_unixctl_memory(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                    const char *argv[] OVS_UNUSED, void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    ds_put_format(&ds, "%-12s %14s %14s\n", "", "heap bytes", "rss bytes");
+    ds_put_format(&ds, "%-12s %14lld %14lld\n", "boot",
+                  mem_boot.heap, mem_boot.rss);
+    ds_put_format(&ds, "%-12s %14lld %14lld\n", "compacted",
+                  mem_compacted.heap, mem_compacted.rss);
+    ds_put_format(&ds, "%-12s %14lld %14lld\n", "now",
+                  sysd_metrics_heap_bytes(), sysd_metrics_rss_bytes());
+    ds_put_format(&ds, "state arena: %"PRIuSIZE" bytes in %"PRIuSIZE
+                  " chunks, %"PRIuSIZE" used\n",
+                  sysd_state_arena.n_bytes, sysd_state_arena.n_chunks,
+                  sysd_state_arena.n_used);
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+
+} /* sysd_unixctl_memory */
+
+/* Starts the CPU profiler, or stops it and writes the folded stacks to
+ * FILE, by default <rundir>/ops-sysd.folded. */
+static void
+sysd_unixctl_profile(struct unixctl_conn *conn, int argc,
+                     const char *argv[], void *aux OVS_UNUSED)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    char *error;
+
+    if (!strcmp(argv[1], "start")) {
+        error = sysd_profile_start(argc > 2 ? strtoul(argv[2], NULL, 10)
+                                            : SYSD_PROFILE_DFLT_HZ);
+        if (!error) {
+            ds_put_cstr(&ds, "profiler started");
+        }
+    } else if (!strcmp(argv[1], "stop")) {
+        char *file = argc > 2 ? xstrdup(argv[2])
+                              : xasprintf("%s/%s.folded", ovs_rundir(),
+                                          program_name);
+
+        error = sysd_profile_stop(file, &ds);
+        free(file);
+    } else {
+        error = xasprintf("unknown command '%s'", argv[1]);
+    }
+
+    if (error) {
+        unixctl_command_reply_error(conn, error);
+        free(error);
+    } else {
+        unixctl_command_reply(conn, ds_cstr(&ds));
+    }
+    ds_destroy(&ds);
+
+} /* sysd_unixctl_profile */
+
 static int
 sysd_get_subsystem_info(void)
 {
@@ -132,18 +227,11 @@ sysd_get_subsystem_info(void)
 
     num_subsystems = 1;
 
-    subsystems = (sysd_subsystem_t **) calloc(num_subsystems, sizeof(sysd_subsystem_t *));
-    if (subsystems == (sysd_subsystem_t **)NULL) {
-        VLOG_ERR("Unable to allocate memory for subsystems, terminating");
-        return -1;
-    }
-
+    subsystems = sysd_arena_alloc(&sysd_state_arena,
+                                  num_subsystems * sizeof(sysd_subsystem_t *));
     for (i = 0; i < num_subsystems; i++) {
-        subsystems[i] = (sysd_subsystem_t *) calloc(1, sizeof(sysd_subsystem_t));
-        if (subsystems[i] == (sysd_subsystem_t *)NULL) {
-            VLOG_ERR("Unable to allocate memory for subsystems, terminating");
-            return -1;
-        }
+        subsystems[i] = sysd_arena_alloc(&sysd_state_arena,
+                                         sizeof(sysd_subsystem_t));
     }
 
     rc = sysd_read_fru_eeprom(&(subsystems[0]->fru_eeprom));
@@ -203,20 +291,14 @@ sysd_get_interface_info(void)
     }
 
     /* Allocate memory for 'intf_count' number of sysd_intf_info_t pointers. */
-    interfaces = (sysd_intf_info_t **) calloc(intf_count, sizeof(sysd_intf_info_t *));
-    if (interfaces == (sysd_intf_info_t **)NULL) {
-        VLOG_ERR("Failed to allocate memory for interface strcture.");
-        log_event("SYS_ALLOCATE_MEMORY_FAILURE", EV_KV("value",
-            "%s", "interface structure"));
-        return -1;
-    }
+    interfaces = sysd_arena_alloc(&sysd_state_arena,
+                                  intf_count * sizeof(sysd_intf_info_t *));
 
     /* Get info for each interface. */
     for (idx = 0 ; idx < intf_count; idx++) {
         interfaces[idx] = sysd_cfg_yaml_get_port_info(idx);
         if (NULL == interfaces[idx]) {
             VLOG_ERR("Unable to get interface info for interface index %d", idx);
-            free(interfaces);
             return -1;
         }
     }
@@ -231,6 +313,36 @@ sysd_get_interface_info(void)
 
 } /* sysd_get_interface_info */
 
+/* Once the interfaces are known, the YAML handle is only needed for the
+ * few fields sysd still reads. Moves those into sysd_state_arena, frees
+ * the handle and hands the freed heap back to the system. */
+static void
+sysd_compact_boot_state(void)
+{
+    sysd_subsystem_t    *ptr = subsystems[0];
+    int                 idx;
+
+    mem_boot.heap = sysd_metrics_heap_bytes();
+    mem_boot.rss = sysd_metrics_rss_bytes();
+
+    sysd_hw_intf_templates_clear();
+    sysd_cfg_yaml_compact();
+    ptr->intf_cmn_info = sysd_cfg_yaml_get_port_subsys_info();
+    for (idx = 0; idx < ptr->intf_count; idx++) {
+        ptr->interfaces[idx] = sysd_cfg_yaml_get_port_info(idx);
+    }
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+
+    mem_compacted.heap = sysd_metrics_heap_bytes();
+    mem_compacted.rss = sysd_metrics_rss_bytes();
+    VLOG_INFO("Released hardware description: heap %lld -> %lld bytes, "
+              "RSS %lld -> %lld bytes", mem_boot.heap, mem_compacted.heap,
+              mem_boot.rss, mem_compacted.rss);
+
+} /* sysd_compact_boot_state */
+
 static int
 sysd_find_hw_desc_files(void)
 {
@@ -265,10 +377,10 @@ sysd_ovsdb_conn_init(char *remote)
     ovsdb_idl_add_column(idl, &ovsrec_system_col_other_info);
     ovsdb_idl_omit_alert(idl, &ovsrec_system_col_other_info);
     ovsdb_idl_add_column(idl, &ovsrec_system_col_software_info);
-    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_software_info);
     ovsdb_idl_add_column(idl, &ovsrec_system_col_switch_version);
-    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_switch_version);
     ovsdb_idl_add_column(idl, &ovsrec_system_col_timezone);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_daemons);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_daemons);
 
     ovsdb_idl_add_table(idl, &ovsrec_table_subsystem);
     ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_name);
@@ -279,6 +391,8 @@ sysd_ovsdb_conn_init(char *remote)
     ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_hw_desc_dir);
     ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_other_config);
     ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_other_config);
+    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_other_info);
+    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_other_info);
     ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_interfaces);
     ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_interfaces);
 
@@ -289,8 +403,10 @@ sysd_ovsdb_conn_init(char *remote)
     ovsdb_idl_omit_alert(idl, &ovsrec_interface_col_hw_intf_info);
     ovsdb_idl_add_column(idl, &ovsrec_interface_col_type);
     ovsdb_idl_omit_alert(idl, &ovsrec_interface_col_type);
-    ovsdb_idl_add_column(idl, &ovsrec_interface_col_user_config);
-    ovsdb_idl_omit_alert(idl, &ovsrec_interface_col_user_config);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_split_parent);
+    ovsdb_idl_omit_alert(idl, &ovsrec_interface_col_split_parent);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_split_children);
+    ovsdb_idl_omit_alert(idl, &ovsrec_interface_col_split_children);
 
     /* Daemon Table */
     ovsdb_idl_add_table(idl, &ovsrec_table_daemon);
@@ -307,12 +423,14 @@ sysd_ovsdb_conn_init(char *remote)
     ovsdb_idl_add_table(idl, &ovsrec_table_package_info);
     ovsdb_idl_add_column(idl, &ovsrec_package_info_col_name);
     ovsdb_idl_omit_alert(idl, &ovsrec_package_info_col_name);
-    ovsdb_idl_add_column(idl, &ovsrec_package_info_col_src_type);
-    ovsdb_idl_omit_alert(idl, &ovsrec_package_info_col_src_type);
-    ovsdb_idl_add_column(idl, &ovsrec_package_info_col_src_url);
-    ovsdb_idl_omit_alert(idl, &ovsrec_package_info_col_src_url);
-    ovsdb_idl_add_column(idl, &ovsrec_package_info_col_version);
-    ovsdb_idl_omit_alert(idl, &ovsrec_package_info_col_version);
+
+    /* Interface user_config and the other Package_Info columns are only
+     * written, on insert, so they are not replicated. Interface, Daemon
+     * and Package_Info rows are filtered by boot phase. */
+    sysd_monitor_init();
+
+    /* Track the columns that have change handlers. */
+    sysd_register_change_handlers();
 
     INIT_DIAG_DUMP_BASIC(sysd_diag_dump_basic_cb);
 
@@ -332,7 +450,19 @@ usage(void)
     vlog_usage();
     printf("\nOther options:\n"
            "  --unixctl=SOCKET        override default control socket name\n"
-           "  -h, --help              display this help message\n");
+           "  --hw-desc-dir=DIR       use hardware description files in DIR\n"
+           "  --manifest=FILE         read the image manifest from FILE\n"
+           "  --fru-cache=FILE        keep the FRU EEPROM cache in FILE\n"
+           "  --golden-config=FILE    keep the initial configuration snapshot\n"
+           "                          in FILE, empty to disable\n"
+           "  --version-detail=FILE   read package versions from FILE\n"
+           "  --slow-commit-ms=MSEC   warn about OVSDB commits slower than\n"
+           "                          MSEC, 0 to disable (default: %d)\n"
+           "  --intf-batch-size=N     add interfaces N at a time after the\n"
+           "                          rest of the initial configuration on\n"
+           "                          chassis with more than N (default: %d)\n"
+           "  -h, --help              display this help message\n",
+           SYSD_SLOW_COMMIT_MSEC_DFLT, SYSD_INTF_BATCH_SIZE_DFLT);
     exit(EXIT_SUCCESS);
 
 } /* usage */
@@ -343,6 +473,13 @@ parse_options(int argc, char *argv[], char **unixctl_pathp)
     enum {
         OPT_PEER_CA_CERT = UCHAR_MAX + 1,
         OPT_UNIXCTL,
+        OPT_HW_DESC_DIR,
+        OPT_MANIFEST,
+        OPT_FRU_CACHE,
+        OPT_GOLDEN_CONFIG,
+        OPT_VERSION_DETAIL,
+        OPT_SLOW_COMMIT_MS,
+        OPT_INTF_BATCH_SIZE,
         VLOG_OPTION_ENUMS,
         OPT_BOOTSTRAP_CA_CERT,
         OPT_ENABLE_DUMMY,
@@ -353,6 +490,13 @@ parse_options(int argc, char *argv[], char **unixctl_pathp)
     static const struct option long_options[] = {
         {"help",        no_argument, NULL, 'h'},
         {"unixctl",     required_argument, NULL, OPT_UNIXCTL},
+        {"hw-desc-dir", required_argument, NULL, OPT_HW_DESC_DIR},
+        {"manifest",    required_argument, NULL, OPT_MANIFEST},
+        {"fru-cache",   required_argument, NULL, OPT_FRU_CACHE},
+        {"golden-config", required_argument, NULL, OPT_GOLDEN_CONFIG},
+        {"version-detail", required_argument, NULL, OPT_VERSION_DETAIL},
+        {"slow-commit-ms", required_argument, NULL, OPT_SLOW_COMMIT_MS},
+        {"intf-batch-size", required_argument, NULL, OPT_INTF_BATCH_SIZE},
         DAEMON_LONG_OPTIONS,
         VLOG_LONG_OPTIONS,
         {NULL, 0, NULL, 0},
@@ -375,6 +519,49 @@ parse_options(int argc, char *argv[], char **unixctl_pathp)
             *unixctl_pathp = optarg;
             break;
 
+        case OPT_HW_DESC_DIR:
+            g_hw_desc_dir = optarg;
+            hw_desc_dir_set = true;
+            break;
+
+        case OPT_MANIFEST:
+            manifest_file = optarg;
+            break;
+
+        case OPT_FRU_CACHE:
+            sysd_fru_set_cache_file(optarg);
+            break;
+
+        case OPT_GOLDEN_CONFIG:
+            sysd_golden_set_file(optarg);
+            break;
+
+        case OPT_VERSION_DETAIL:
+            sysd_set_version_detail_file(optarg);
+            break;
+
+        case OPT_SLOW_COMMIT_MS: {
+            long long msec;
+
+            if (!str_to_llong(optarg, 10, &msec) || msec < 0) {
+                VLOG_FATAL("--slow-commit-ms requires a number of "
+                           "milliseconds, 0 or more; use --help for usage");
+            }
+            sysd_metrics_set_slow_commit_msec(msec);
+            break;
+        }
+
+        case OPT_INTF_BATCH_SIZE: {
+            int n;
+
+            if (!str_to_int(optarg, 10, &n) || n <= 0) {
+                VLOG_FATAL("--intf-batch-size requires a positive number "
+                           "of interfaces; use --help for usage");
+            }
+            sysd_set_intf_batch_size(n);
+            break;
+        }
+
         VLOG_OPTION_HANDLERS
         DAEMON_OPTION_HANDLERS
 
@@ -410,7 +597,6 @@ sysd_exit(struct unixctl_conn *conn, int argc OVS_UNUSED,
     bool *exiting = exiting_;
     *exiting = true;
     sysd_cfg_yaml_set_system_status_led(0);
-    free(subsystems);
     unixctl_command_reply(conn, NULL);
 
 } /* sysd_exit */
@@ -423,6 +609,7 @@ main(int argc, char *argv[])
     int     rc = 0;
     int     exiting = 0;
     int     retval;
+    uint64_t phase;
 
     struct unixctl_server   *appctl = NULL;
 
@@ -439,6 +626,8 @@ main(int argc, char *argv[])
      * startup completion yet. */
     daemonize_start();
 
+    sysd_trace_init();
+
     retval = event_log_init("SYS");
     if(retval < 0) {
         VLOG_ERR("Event log initialization failed for SYS");
@@ -451,78 +640,116 @@ main(int argc, char *argv[])
     }
 
     /* Register ovs-appctl commands for this daemon. */
-    unixctl_command_register("ops-sysd/dump", "", 0, 0, sysd_unixctl_dump, NULL);
+    unixctl_command_register("ops-sysd/dump", "[--json]", 0, 1,
+                             sysd_unixctl_dump, NULL);
+    unixctl_command_register("ops-sysd/metrics", "", 0, 0,
+                             sysd_unixctl_metrics, NULL);
+    unixctl_command_register("ops-sysd/trace", "[COUNT]", 0, 1,
+                             sysd_unixctl_trace, NULL);
+    unixctl_command_register("ops-sysd/memory", "", 0, 0,
+                             sysd_unixctl_memory, NULL);
+    unixctl_command_register("ops-sysd/profile", "start [HZ] | stop [FILE]",
+                             1, 2, sysd_unixctl_profile, NULL);
 
     /* Register the ovs-appctl "exit" command for this daemon. */
     unixctl_command_register("exit", "", 0, 0, sysd_exit, &exiting);
 
     sysd_ovsdb_conn_init(ovsdb_sock);
-    free(ovsdb_sock);
 
     /* Process the manifest file */
-    rc = sysd_read_manifest_file();
+    phase = sysd_trace_phase_start("manifest");
+    rc = sysd_read_manifest_file(manifest_file);
+    sysd_trace(SYSD_TRACE_FILE, manifest_file, num_daemons, 0, rc);
     if (rc) {
         VLOG_ERR("Unable to process image.manifest file.");
         exit(-1);
     }
+    sysd_trace_phase_stop("manifest", phase);
 
     /* Determine the platform we are on and
      * locate H/W desc files. */
-    rc = sysd_find_hw_desc_files();
+    phase = sysd_trace_phase_start("hw_desc_find");
+    rc = hw_desc_dir_set ? 0 : sysd_find_hw_desc_files();
     if (rc) {
         VLOG_ERR("Unable to find HW descriptor files.");
+        sysd_trace(SYSD_TRACE_ERROR, "hw_desc_find", 0, 0, rc);
         exit(-1);
     }
+    sysd_trace_phase_stop("hw_desc_find", phase);
 
     /* OPS_TODO: Need to refactor to not die if h/w desc info
      * is not available. Can do this when adding subsystem support. */
 
     /* Initialize and parse needed yaml files. */
+    phase = sysd_trace_phase_start("cfg_yaml_init");
     rc = sysd_cfg_yaml_init(g_hw_desc_dir);
     if (!rc) {
         VLOG_ERR("Unable to initialize YAML config files.");
+        sysd_trace(SYSD_TRACE_ERROR, "cfg_yaml_init", 0, 0, rc);
         exit(-1);
     }
+    sysd_trace_phase_stop("cfg_yaml_init", phase);
 
+    phase = sysd_trace_phase_start("subsystem_info");
     rc = sysd_get_subsystem_info();
     if (rc) {
         VLOG_ERR("Unable to enumerate subsystems in the system.");
+        sysd_trace(SYSD_TRACE_ERROR, "subsystem_info", 0, 0, rc);
         exit(-1);
     }
+    sysd_trace_phase_stop("subsystem_info", phase);
 
+    phase = sysd_trace_phase_start("interface_info");
     rc = sysd_get_interface_info();
     if (rc) {
         VLOG_ERR("Unable to enumerate interfaces in the system.");
+        sysd_trace(SYSD_TRACE_ERROR, "interface_info", 0, 0, rc);
         exit(-1);
     }
+    sysd_trace_phase_stop("interface_info", phase);
+
+    phase = sysd_trace_phase_start("defaults");
+    if (sysd_defaults_load(g_hw_desc_dir)) {
+        VLOG_ERR("Unable to use %s, creating the built-in default topology",
+                 SYSD_DEFAULTS_FILE);
+        sysd_trace(SYSD_TRACE_ERROR, "defaults", 0, 0, -1);
+    }
+    sysd_trace_phase_stop("defaults", phase);
+
+    /* Fingerprint what the initial configuration is built from. */
+    phase = sysd_trace_phase_start("golden_fingerprint");
+    sysd_golden_init(ovsdb_sock, manifest_file);
+    free(ovsdb_sock);
+    sysd_trace_phase_stop("golden_fingerprint", phase);
 
     /* Set the system status LED to 'good' after successfully
      * initializing the hardware descriptors.
      */
     sysd_cfg_yaml_set_system_status_led(1);
 
+    phase = sysd_trace_phase_start("compact");
+    sysd_compact_boot_state();
+    sysd_trace_phase_stop("compact", phase);
+
     while (!exiting) {
+        long long run_start = time_msec();
+
         sysd_run();
+        sysd_metrics_run_time(time_msec() - run_start);
         unixctl_server_run(appctl);
         sysd_wait();
         unixctl_server_wait(appctl);
-        if (idl_seqno != ovsdb_idl_get_seqno(idl)) {
-            /* IDL seqno could have changed because of the ovsdb_idl_run()
-             * called from the ovsdb_idl_txn_commit_block() calls inside
-             * sysd. This could happen when DB transactions get posted
-             * while sysd is inside sysd_run(). When this happens,
-             * ovsdb_idl_txn_commit_block() could clear any pending fd poll
-             * status and could cause the poll_block() below to wait
-             * until the next DB transaction happened, if any at all..
-             */
-            VLOG_ERR("IDL has changed. Continue to see what changed..");
-        } else if (exiting) {
+        if (exiting) {
             poll_immediate_wake();
         } else {
+            sysd_metrics_loop_sleeping();
             poll_block();
+            sysd_metrics_loop_woke();
         }
     }
 
+    sysd_trace_clean_exit();
+
     return 0;
 
 } /* main */
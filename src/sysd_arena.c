@@ -0,0 +1,131 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup sysd
+ *
+ * @file
+ * Source for the sysd arena allocator.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util.h>
+
+#include "sysd_arena.h"
+
+/** @ingroup sysd
+ * @{ */
+
+/* Every allocation is aligned for any of the types sysd keeps. */
+#define ARENA_ALIGN     (2 * sizeof(void *))
+
+struct sysd_arena_chunk {
+    struct sysd_arena_chunk *next;
+    size_t                  size;
+    size_t                  used;
+};
+
+#define ARENA_CHUNK_HDR ROUND_UP(sizeof(struct sysd_arena_chunk), ARENA_ALIGN)
+
+static struct sysd_arena_chunk *
+arena_chunk_create(struct sysd_arena *arena, size_t size)
+{
+    struct sysd_arena_chunk *chunk = xzalloc(ARENA_CHUNK_HDR + size);
+
+    chunk->size = size;
+    arena->n_chunks++;
+    arena->n_bytes += ARENA_CHUNK_HDR + size;
+
+    return chunk;
+
+} /* arena_chunk_create */
+
+/* Returns 'size' bytes of zeroed memory that lives until the arena is
+ * destroyed. */
+void *
+sysd_arena_alloc(struct sysd_arena *arena, size_t size)
+{
+    struct sysd_arena_chunk *chunk = arena->chunks;
+    void                    *p;
+
+    size = ROUND_UP(MAX(size, 1), ARENA_ALIGN);
+
+    if (chunk == NULL || chunk->size - chunk->used < size) {
+        if (size > arena->chunk_size / 4) {
+            /* Large blocks get a chunk of their own, queued behind the
+             * current one so its free space is not wasted. */
+            struct sysd_arena_chunk *big = arena_chunk_create(arena, size);
+
+            if (chunk) {
+                big->next = chunk->next;
+                chunk->next = big;
+            } else {
+                arena->chunks = big;
+            }
+            big->used = size;
+            arena->n_used += size;
+            return (char *) big + ARENA_CHUNK_HDR;
+        }
+        chunk = arena_chunk_create(arena, arena->chunk_size);
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+
+    p = (char *) chunk + ARENA_CHUNK_HDR + chunk->used;
+    chunk->used += size;
+    arena->n_used += size;
+
+    return p;
+
+} /* sysd_arena_alloc */
+
+void *
+sysd_arena_memdup(struct sysd_arena *arena, const void *p, size_t size)
+{
+    void *copy = sysd_arena_alloc(arena, size);
+
+    memcpy(copy, p, size);
+    return copy;
+
+} /* sysd_arena_memdup */
+
+/* Returns a copy of 's', or NULL if 's' is NULL. */
+char *
+sysd_arena_strdup(struct sysd_arena *arena, const char *s)
+{
+    return s ? sysd_arena_memdup(arena, s, strlen(s) + 1) : NULL;
+
+} /* sysd_arena_strdup */
+
+void
+sysd_arena_destroy(struct sysd_arena *arena)
+{
+    struct sysd_arena_chunk *chunk;
+    struct sysd_arena_chunk *next;
+
+    for (chunk = arena->chunks; chunk; chunk = next) {
+        next = chunk->next;
+        free(chunk);
+    }
+    arena->chunks = NULL;
+    arena->n_chunks = 0;
+    arena->n_bytes = 0;
+    arena->n_used = 0;
+
+} /* sysd_arena_destroy */
+/** @} end of group sysd */
@@ -0,0 +1,478 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup sysd
+ *
+ * @file
+ * Source for sysd concurrent per-bus device initialization.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include <openvswitch/vlog.h>
+#include <ovs-thread.h>
+#include <shash.h>
+#include <smap.h>
+#include <util.h>
+
+#include <config-yaml.h>
+#include "sysd_cfg_yaml.h"
+#include "sysd_fru.h"
+#include "sysd_trace.h"
+#include "sysd_bus_init.h"
+
+VLOG_DEFINE_THIS_MODULE(bus_init);
+
+/** @ingroup sysd
+ * @{ */
+
+#define BUS_INIT_MAX_DATA_LEN   32
+#define BUS_INIT_NO_REGISTER    "NONE"
+
+/* Keys sysd understands in an 'init' entry. */
+static const char *bus_init_op_keys[] = {
+    "device", "register", "data",
+};
+
+struct bus_init_op {
+    const char  *device;        /* Owned by the sysd_cfg_yaml_devices. */
+    uint16_t    address;
+    bool        has_reg;
+    uint8_t     reg;
+    uint8_t     data[BUS_INIT_MAX_DATA_LEN];
+    size_t      data_len;
+};
+
+struct bus_worker {
+    const char          *name;
+    const char          *dev_name;
+    unsigned long       funcs;      /* I2C_FUNCS of the adapter. */
+    int                 fd;
+    struct bus_init_op  *ops;
+    size_t              n_ops;
+    size_t              allocated_ops;
+    bool                read_fru;
+    bool                ok;
+    pthread_t           thread;
+};
+
+static bool
+bus_init_parse_u32(const char *str, uint32_t max, uint32_t *value)
+{
+    unsigned long ul;
+    char *end;
+
+    errno = 0;
+    ul = strtoul(str, &end, 0);
+    if (errno || !*str || *end || ul > max) {
+        return false;
+    }
+    *value = ul;
+
+    return true;
+
+} /* bus_init_parse_u32 */
+
+/* Parses the comma separated byte list of an 'init' entry's 'data'. */
+static bool
+bus_init_parse_data(const char *str, struct bus_init_op *op)
+{
+    char *copy = xstrdup(str);
+    char *save_ptr = NULL;
+    char *token;
+    uint32_t byte;
+    bool ok = true;
+
+    op->data_len = 0;
+    for (token = strtok_r(copy, ",", &save_ptr); token && ok;
+         token = strtok_r(NULL, ",", &save_ptr)) {
+        ok = op->data_len < BUS_INIT_MAX_DATA_LEN
+             && bus_init_parse_u32(token, UINT8_MAX, &byte);
+        if (ok) {
+            op->data[op->data_len++] = byte;
+        }
+    }
+    free(copy);
+
+    return ok && op->data_len;
+
+} /* bus_init_parse_data */
+
+/* Reads the I2C_FUNCS of the adapter at 'dev_name' into 'funcs'. */
+static bool
+bus_init_adapter_funcs(const char *dev_name, unsigned long *funcs)
+{
+    bool ok;
+    int fd;
+
+    fd = open(dev_name, O_RDWR);
+    if (fd < 0) {
+        VLOG_DBG("Unable to open %s. Error %s", dev_name, ovs_strerror(errno));
+        return false;
+    }
+    ok = ioctl(fd, I2C_FUNCS, funcs) >= 0;
+    if (!ok) {
+        VLOG_DBG("I2C_FUNCS on %s failed. Error %s",
+                 dev_name, ovs_strerror(errno));
+    }
+    close(fd);
+
+    return ok;
+
+} /* bus_init_adapter_funcs */
+
+/* Whether the adapter has I2C_RDWR, else only SMBus transfers. */
+static bool
+bus_init_worker_is_smbus(const struct bus_worker *worker)
+{
+    return !(worker->funcs & I2C_FUNC_I2C);
+
+} /* bus_init_worker_is_smbus */
+
+/* Whether an SMBus-only adapter with 'funcs' has a transfer for 'op'. */
+static bool
+bus_init_smbus_can_run(unsigned long funcs, const struct bus_init_op *op)
+{
+    if (!op->has_reg) {
+        /* Send byte. There is no transfer for several bytes without a
+         * command byte. */
+        return op->data_len == 1 && (funcs & I2C_FUNC_SMBUS_WRITE_BYTE);
+    } else if (op->data_len == 1) {
+        return funcs & I2C_FUNC_SMBUS_WRITE_BYTE_DATA;
+    } else {
+        return funcs & I2C_FUNC_SMBUS_WRITE_I2C_BLOCK;
+    }
+
+} /* bus_init_smbus_can_run */
+
+/* Returns the worker for the bus 'device' sits on, creating it if needed,
+ * or NULL if sysd cannot drive that bus or device directly. */
+static struct bus_worker *
+bus_init_worker_for_device(struct shash *workers,
+                           const struct sysd_cfg_yaml_devices *cfg,
+                           const char *device, uint16_t *address)
+{
+    const struct smap *dev_cfg = shash_find_data(&cfg->devices, device);
+    const struct smap *bus_cfg;
+    struct bus_worker *worker;
+    const char *bus;
+    const char *addr;
+    uint32_t value;
+
+    if (dev_cfg == NULL || smap_get(dev_cfg, SYSD_CFG_YAML_NESTED_KEY)) {
+        return NULL;
+    }
+
+    bus = smap_get(dev_cfg, "bus");
+    bus_cfg = bus ? shash_find_data(&cfg->buses, bus) : NULL;
+    addr = smap_get(dev_cfg, "address");
+    if (bus_cfg == NULL || smap_get(bus_cfg, "dev_name") == NULL
+        || addr == NULL || !bus_init_parse_u32(addr, 0x7f, &value)) {
+        return NULL;
+    }
+    *address = value;
+
+    worker = shash_find_data(workers, bus);
+    if (worker == NULL) {
+        const char *dev_name = smap_get(bus_cfg, "dev_name");
+        unsigned long funcs;
+
+        if (!bus_init_adapter_funcs(dev_name, &funcs)) {
+            return NULL;
+        }
+        worker = xzalloc(sizeof *worker);
+        worker->name = bus;
+        worker->dev_name = dev_name;
+        worker->funcs = funcs;
+        worker->fd = -1;
+        shash_add(workers, bus, worker);
+    }
+
+    return worker;
+
+} /* bus_init_worker_for_device */
+
+static bool
+bus_init_add_op(struct shash *workers, const struct sysd_cfg_yaml_devices *cfg,
+                const struct smap *entry)
+{
+    const struct smap_node *node;
+    struct bus_worker *worker;
+    struct bus_init_op op;
+    const char *reg;
+    const char *data;
+    uint32_t value;
+    size_t i;
+
+    SMAP_FOR_EACH (node, entry) {
+        for (i = 0; i < ARRAY_SIZE(bus_init_op_keys); i++) {
+            if (!strcmp(node->key, bus_init_op_keys[i])) {
+                break;
+            }
+        }
+        if (i == ARRAY_SIZE(bus_init_op_keys)) {
+            VLOG_DBG("init entry key '%s' not handled by sysd", node->key);
+            return false;
+        }
+    }
+
+    memset(&op, 0, sizeof op);
+    op.device = smap_get(entry, "device");
+    reg = smap_get(entry, "register");
+    data = smap_get(entry, "data");
+    if (op.device == NULL || reg == NULL || data == NULL
+        || !bus_init_parse_data(data, &op)) {
+        return false;
+    }
+
+    if (strcmp(reg, BUS_INIT_NO_REGISTER)) {
+        if (!bus_init_parse_u32(reg, UINT8_MAX, &value)) {
+            return false;
+        }
+        op.has_reg = true;
+        op.reg = value;
+    }
+
+    worker = bus_init_worker_for_device(workers, cfg, op.device, &op.address);
+    if (worker == NULL) {
+        VLOG_DBG("init entry for device %s not handled by sysd", op.device);
+        return false;
+    }
+
+    if (bus_init_worker_is_smbus(worker)
+        && !bus_init_smbus_can_run(worker->funcs, &op)) {
+        VLOG_DBG("init entry for device %s has no SMBus transfer on %s",
+                 op.device, worker->name);
+        return false;
+    }
+
+    if (worker->n_ops >= worker->allocated_ops) {
+        worker->ops = x2nrealloc(worker->ops, &worker->allocated_ops,
+                                 sizeof *worker->ops);
+    }
+    worker->ops[worker->n_ops++] = op;
+
+    return true;
+
+} /* bus_init_add_op */
+
+static bool
+bus_init_run_smbus_op(struct bus_worker *worker, const struct bus_init_op *op)
+{
+    union i2c_smbus_data data;
+    struct i2c_smbus_ioctl_data args;
+
+    if (ioctl(worker->fd, I2C_SLAVE, op->address) < 0) {
+        return false;
+    }
+
+    args.read_write = I2C_SMBUS_WRITE;
+    args.data = &data;
+    if (!op->has_reg) {
+        /* Send byte, as for mux channel selection. */
+        args.command = op->data[0];
+        args.size = I2C_SMBUS_BYTE;
+        args.data = NULL;
+    } else if (op->data_len == 1) {
+        args.command = op->reg;
+        args.size = I2C_SMBUS_BYTE_DATA;
+        data.byte = op->data[0];
+    } else {
+        args.command = op->reg;
+        args.size = I2C_SMBUS_I2C_BLOCK_DATA;
+        data.block[0] = op->data_len;
+        memcpy(&data.block[1], op->data, op->data_len);
+    }
+
+    return ioctl(worker->fd, I2C_SMBUS, &args) >= 0;
+
+} /* bus_init_run_smbus_op */
+
+static bool
+bus_init_run_i2c_op(struct bus_worker *worker, const struct bus_init_op *op)
+{
+    uint8_t buf[1 + BUS_INIT_MAX_DATA_LEN];
+    struct i2c_msg msg;
+    struct i2c_rdwr_ioctl_data xfer;
+    size_t len = 0;
+
+    if (op->has_reg) {
+        buf[len++] = op->reg;
+    }
+    memcpy(&buf[len], op->data, op->data_len);
+    len += op->data_len;
+
+    msg.addr = op->address;
+    msg.flags = 0;
+    msg.len = len;
+    msg.buf = buf;
+
+    xfer.msgs = &msg;
+    xfer.nmsgs = 1;
+
+    return ioctl(worker->fd, I2C_RDWR, &xfer) >= 0;
+
+} /* bus_init_run_i2c_op */
+
+static bool
+bus_init_run_op(struct bus_worker *worker, const struct bus_init_op *op)
+{
+    bool ok;
+
+    ok = bus_init_worker_is_smbus(worker) ? bus_init_run_smbus_op(worker, op)
+                                          : bus_init_run_i2c_op(worker, op);
+    if (!ok) {
+        VLOG_ERR("Failed to initialize device %s on %s. Error %s",
+                 op->device, worker->name, ovs_strerror(errno));
+        sysd_trace(SYSD_TRACE_ERROR, op->device, 0, 0, errno);
+    }
+
+    return ok;
+
+} /* bus_init_run_op */
+
+static void *
+bus_init_worker_main(void *worker_)
+{
+    struct bus_worker *worker = worker_;
+    uint64_t phase = sysd_trace_phase_start(worker->name);
+    size_t i;
+
+    worker->ok = true;
+
+    if (worker->n_ops) {
+        worker->fd = open(worker->dev_name, O_RDWR);
+        if (worker->fd < 0) {
+            VLOG_ERR("Unable to open %s. Error %s",
+                     worker->dev_name, ovs_strerror(errno));
+            sysd_trace(SYSD_TRACE_ERROR, worker->dev_name, 0, 0, errno);
+            worker->ok = false;
+            return NULL;
+        }
+
+        for (i = 0; i < worker->n_ops && worker->ok; i++) {
+            worker->ok = bus_init_run_op(worker, &worker->ops[i]);
+        }
+
+        close(worker->fd);
+        worker->fd = -1;
+    }
+
+    /* The FRU EEPROM can only be read once its bus is set up. */
+    if (worker->ok && worker->read_fru) {
+        sysd_fru_prefetch();
+    }
+
+    VLOG_DBG("Bus %s: %"PRIuSIZE" init operations %s", worker->name,
+             worker->n_ops, worker->ok ? "done" : "failed");
+    sysd_trace_phase_stop(worker->name, phase);
+
+    return NULL;
+
+} /* bus_init_worker_main */
+
+/*
+ * Runs the devices.yaml 'init' section with one worker thread per bus and,
+ * if 'read_fru' is set, reads the FRU EEPROM on its bus's worker. Returns
+ * SYSD_BUS_INIT_SERIAL without touching the hardware if any part of the
+ * init section cannot be handled this way.
+ */
+int
+sysd_bus_init_devices(const char *hw_desc_dir, bool read_fru)
+{
+    struct sysd_cfg_yaml_devices cfg;
+    struct shash workers = SHASH_INITIALIZER(&workers);
+    struct shash_node *node;
+    struct bus_worker *worker;
+    int rc = SYSD_BUS_INIT_SERIAL;
+    size_t n_busy = 0;
+    uint16_t address;
+    size_t i;
+
+    if (!sysd_cfg_yaml_load_devices(hw_desc_dir, &cfg)) {
+        goto out;
+    }
+
+    for (i = 0; i < cfg.n_init; i++) {
+        if (smap_get(cfg.init[i], SYSD_CFG_YAML_NESTED_KEY)
+            || !bus_init_add_op(&workers, &cfg, cfg.init[i])) {
+            goto out;
+        }
+    }
+
+    if (read_fru) {
+        worker = bus_init_worker_for_device(&workers, &cfg,
+                                            FRU_EEPROM_DEVICE_NAME, &address);
+        if (worker != NULL) {
+            worker->read_fru = true;
+        }
+    }
+
+    /* With init operations on a single bus there is nothing to overlap.
+     * A bus that only holds the FRU EEPROM does not count. */
+    SHASH_FOR_EACH (node, &workers) {
+        worker = node->data;
+        if (worker->n_ops) {
+            n_busy++;
+        }
+    }
+    if (n_busy < 2) {
+        goto out;
+    }
+
+    SHASH_FOR_EACH (node, &workers) {
+        worker = node->data;
+        worker->thread = ovs_thread_create("sysd_bus", bus_init_worker_main,
+                                           worker);
+    }
+
+    rc = SYSD_BUS_INIT_OK;
+    SHASH_FOR_EACH (node, &workers) {
+        worker = node->data;
+        xpthread_join(worker->thread, NULL);
+        if (!worker->ok) {
+            rc = SYSD_BUS_INIT_FAILED;
+        }
+    }
+
+    VLOG_INFO("Initialized devices on %"PRIuSIZE" buses concurrently",
+              shash_count(&workers));
+
+out:
+    if (rc == SYSD_BUS_INIT_SERIAL) {
+        VLOG_INFO("Using serial device initialization");
+    }
+
+    SHASH_FOR_EACH (node, &workers) {
+        worker = node->data;
+        free(worker->ops);
+    }
+    shash_destroy_free_data(&workers);
+    sysd_cfg_yaml_devices_destroy(&cfg);
+
+    return rc;
+
+} /* sysd_bus_init_devices */
+/** @} end of group sysd */
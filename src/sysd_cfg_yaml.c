@@ -27,12 +27,19 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <yaml.h>
 
 #include <openvswitch/vlog.h>
+#include <smap.h>
+#include <shash.h>
+#include <dynamic-string.h>
+#include <util.h>
 
 #include <config-yaml.h>
 #include "sysd.h"
+#include "sysd_arena.h"
 #include "sysd_cfg_yaml.h"
+#include "sysd_bus_init.h"
 #include "string.h"
 #include "eventlog.h"
 
@@ -41,17 +48,42 @@ VLOG_DEFINE_THIS_MODULE(cfg_yaml);
 /** @ingroup sysd
  * @{ */
 
-#define FRU_EEPROM_NAME "fru_eeprom"
+#define DEVICES_YAML_FILE "devices.yaml"
 
 static YamlConfigHandle cfg_yaml_handle = (YamlConfigHandle *)NULL;
 static const YamlDevice *fru_dev = NULL;
+static char *cfg_hw_desc_dir = NULL;
 bool fru_yaml = true;
 
+/* What sysd still reads from the hardware description after boot, copied
+ * into sysd_state_arena by sysd_cfg_yaml_compact(). Once it is set, the
+ * getters below read from it instead of cfg_yaml_handle. */
+struct cfg_yaml_snapshot {
+    YamlPortInfo                port_info;
+    YamlPort                    *ports;
+    int                         n_ports;
+    YamlQosInfo                 *qos_info;
+    YamlCosMapEntry             *cos_map;
+    int                         n_cos_map;
+    YamlDscpMapEntry            *dscp_map;
+    int                         n_dscp_map;
+    YamlScheduleProfileEntry    *schedule_profile;
+    int                         n_schedule_profile;
+    YamlQueueProfileEntry       *queue_profile;
+    int                         n_queue_profile;
+    YamlAclInfo                 *acl_info;
+};
+
+static struct cfg_yaml_snapshot *cfg_snapshot = NULL;
+
 bool
 sysd_cfg_yaml_open(char *hw_desc_dir)
 {
     int rc = 0;
 
+    if (cfg_hw_desc_dir == NULL) {
+        cfg_hw_desc_dir = xstrdup(hw_desc_dir);
+    }
     cfg_yaml_handle = yaml_new_config_handle();
 
     rc = yaml_add_subsystem(cfg_yaml_handle, BASE_SUBSYSTEM, hw_desc_dir);
@@ -103,17 +135,23 @@ sysd_cfg_yaml_init(char *hw_desc_dir)
         VLOG_ERR("Unable to parse acl yaml config file.");
     }
 
-    rc = yaml_init_devices(cfg_yaml_handle, BASE_SUBSYSTEM);
+    /* Looked up first, the FRU EEPROM may be read while the other
+     * buses are still being initialized. */
+    fru_dev = yaml_find_device(cfg_yaml_handle, BASE_SUBSYSTEM, FRU_EEPROM_DEVICE_NAME);
+    if (fru_dev == (YamlDevice *)NULL) {
+        VLOG_ERR("unable to find device %s in YAML description.", FRU_EEPROM_DEVICE_NAME);
+        return (false);
+    }
+
+    rc = sysd_bus_init_devices(hw_desc_dir, !fru_yaml);
+    if (SYSD_BUS_INIT_SERIAL == rc) {
+        rc = yaml_init_devices(cfg_yaml_handle, BASE_SUBSYSTEM);
+    }
     if (0 > rc) {
         VLOG_ERR("Failed to intialize devices");
         log_event("SYS_INITIALIZE_DEVICE_FAILURE", NULL);
         return (false);
     }
-    fru_dev = yaml_find_device(cfg_yaml_handle, BASE_SUBSYSTEM, FRU_EEPROM_NAME);
-    if (fru_dev == (YamlDevice *)NULL) {
-        VLOG_ERR("unable to find device %s in YAML description.", FRU_EEPROM_NAME);
-        return (false);
-    }
 
     return (true);
 
@@ -122,6 +160,9 @@ sysd_cfg_yaml_init(char *hw_desc_dir)
 int
 sysd_cfg_yaml_get_port_count(void)
 {
+    if (cfg_snapshot) {
+        return cfg_snapshot->n_ports;
+    }
     return (int) yaml_get_port_count(cfg_yaml_handle, BASE_SUBSYSTEM);
 
 } /* sysd_cfg_yaml_get_port_count */
@@ -129,6 +170,10 @@ sysd_cfg_yaml_get_port_count(void)
 YamlPort *
 sysd_cfg_yaml_get_port_info(int index)
 {
+    if (cfg_snapshot) {
+        return (index >= 0 && index < cfg_snapshot->n_ports)
+               ? &cfg_snapshot->ports[index] : NULL;
+    }
     return (YamlPort *) yaml_get_port(cfg_yaml_handle, BASE_SUBSYSTEM, index);
 
 } /* sysd_cfg_yaml_get_port_info */
@@ -136,6 +181,9 @@ sysd_cfg_yaml_get_port_info(int index)
 YamlPortInfo *
 sysd_cfg_yaml_get_port_subsys_info(void)
 {
+    if (cfg_snapshot) {
+        return &cfg_snapshot->port_info;
+    }
     return yaml_get_port_info(cfg_yaml_handle, BASE_SUBSYSTEM);
 
 } /* sysd_cfg_yaml_get_port_subsys_info */
@@ -150,12 +198,15 @@ sysd_cfg_yaml_get_fru_info(fru_eeprom_t *fru_eeprom)
     if (!fru_info) {
        return -1;
     }
+    /* The strings are copied, fru_info goes away with the YAML handle. */
     VLOG_INFO("diag_version: %s", fru_info->diag_version);
     strncpy(fru_eeprom->country_code, fru_info->country_code,
                                        FRU_COUNTRY_CODE_LEN);
     fru_eeprom->country_code[FRU_COUNTRY_CODE_LEN] = '\0';
-    fru_eeprom->diag_version = fru_info->diag_version;
-    fru_eeprom->label_revision = fru_info->label_revision;
+    fru_eeprom->diag_version = sysd_arena_strdup(&sysd_state_arena,
+                                                 fru_info->diag_version);
+    fru_eeprom->label_revision = sysd_arena_strdup(&sysd_state_arena,
+                                                   fru_info->label_revision);
     sscanf(fru_info->base_mac_address, "%x:%x:%x:%x:%x:%x",
        (unsigned int *) &fru_eeprom->base_mac_address[0],
        (unsigned int *) &fru_eeprom->base_mac_address[1],
@@ -178,92 +229,449 @@ sysd_cfg_yaml_get_fru_info(fru_eeprom_t *fru_eeprom)
     strncpy(fru_eeprom->manufacture_date, fru_info->manufacture_date,
             FRU_MANUFACTURE_DATE_LEN);
     fru_eeprom->manufacture_date[FRU_MANUFACTURE_DATE_LEN] = '\0';
-    fru_eeprom->manufacturer = fru_info->manufacturer;
+    fru_eeprom->manufacturer = sysd_arena_strdup(&sysd_state_arena,
+                                                 fru_info->manufacturer);
     fru_eeprom->num_macs = fru_info->num_macs;
-    fru_eeprom->onie_version = fru_info->onie_version;
-    fru_eeprom->part_number = fru_info->part_number;
-    fru_eeprom->platform_name = fru_info->platform_name;
-    fru_eeprom->product_name = fru_info->product_name;
-    fru_eeprom->serial_number = fru_info->serial_number;
-    fru_eeprom->service_tag = fru_info->service_tag;
-    fru_eeprom->vendor = fru_info->vendor;
+    fru_eeprom->onie_version = sysd_arena_strdup(&sysd_state_arena,
+                                                 fru_info->onie_version);
+    fru_eeprom->part_number = sysd_arena_strdup(&sysd_state_arena,
+                                                fru_info->part_number);
+    fru_eeprom->platform_name = sysd_arena_strdup(&sysd_state_arena,
+                                                  fru_info->platform_name);
+    fru_eeprom->product_name = sysd_arena_strdup(&sysd_state_arena,
+                                                 fru_info->product_name);
+    fru_eeprom->serial_number = sysd_arena_strdup(&sysd_state_arena,
+                                                  fru_info->serial_number);
+    fru_eeprom->service_tag = sysd_arena_strdup(&sysd_state_arena,
+                                                fru_info->service_tag);
+    fru_eeprom->vendor = sysd_arena_strdup(&sysd_state_arena,
+                                           fru_info->vendor);
     return 0;
 
 } /* sysd_cfg_yaml_get_fru_info  */
 
 bool
-sysd_cfg_yaml_fru_read(unsigned char *fru_hdr, int hdr_len)
+sysd_cfg_yaml_fru_read_at(unsigned char *buf, int offset, int len)
 {
     int         rc;
 
-    rc = i2c_data_read(cfg_yaml_handle, fru_dev, BASE_SUBSYSTEM, 0, hdr_len, fru_hdr);
+    if (fru_dev == NULL) {
+        VLOG_ERR("FRU EEPROM device is no longer available.");
+        return (false);
+    }
+
+    rc = i2c_data_read(cfg_yaml_handle, fru_dev, BASE_SUBSYSTEM, offset, len, buf);
     if (0 != rc) {
-        VLOG_ERR("Failed to read FRU header.");
+        VLOG_ERR("Failed to read %d bytes of FRU EEPROM at offset %d.", len, offset);
         log_event("SYS_FRU_HEADER_READ_FAILURE", NULL);
         return (false);
     }
 
     return (true);
 
-} /* sysd_cfg_yaml_fru_read */
+} /* sysd_cfg_yaml_fru_read_at */
+
+/*
+ * libyaml document helpers used to pick up sysd specific keys from
+ * devices.yaml that config-yaml does not know about.
+ */
+static const char *
+cfg_yaml_scalar(yaml_node_t *node)
+{
+    if (node == NULL || node->type != YAML_SCALAR_NODE) {
+        return NULL;
+    }
+    return (const char *) node->data.scalar.value;
+
+} /* cfg_yaml_scalar */
+
+static yaml_node_t *
+cfg_yaml_mapping_get(yaml_document_t *doc, yaml_node_t *map, const char *key)
+{
+    yaml_node_pair_t *pair;
+
+    if (map == NULL || map->type != YAML_MAPPING_NODE) {
+        return NULL;
+    }
+
+    for (pair = map->data.mapping.pairs.start;
+         pair < map->data.mapping.pairs.top; pair++) {
+        const char *name = cfg_yaml_scalar(yaml_document_get_node(doc, pair->key));
+
+        if (name && !strcmp(name, key)) {
+            return yaml_document_get_node(doc, pair->value);
+        }
+    }
+
+    return NULL;
+
+} /* cfg_yaml_mapping_get */
+
+static yaml_node_t *
+cfg_yaml_sequence_find(yaml_document_t *doc, yaml_node_t *seq, const char *name)
+{
+    yaml_node_item_t *item;
+
+    if (seq == NULL || seq->type != YAML_SEQUENCE_NODE) {
+        return NULL;
+    }
+
+    for (item = seq->data.sequence.items.start;
+         item < seq->data.sequence.items.top; item++) {
+        yaml_node_t *entry = yaml_document_get_node(doc, *item);
+        const char *entry_name = cfg_yaml_scalar(cfg_yaml_mapping_get(doc, entry, "name"));
+
+        if (entry_name && !strcmp(entry_name, name)) {
+            return entry;
+        }
+    }
+
+    return NULL;
+
+} /* cfg_yaml_sequence_find */
+
+/* Returns the scalars of sequence 'seq' joined with commas, or NULL if
+ * 'seq' is not a sequence of scalars. */
+static char *
+cfg_yaml_scalar_list(yaml_document_t *doc, yaml_node_t *seq)
+{
+    yaml_node_item_t *item;
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    if (seq == NULL || seq->type != YAML_SEQUENCE_NODE) {
+        return NULL;
+    }
+
+    for (item = seq->data.sequence.items.start;
+         item < seq->data.sequence.items.top; item++) {
+        const char *value = cfg_yaml_scalar(yaml_document_get_node(doc, *item));
+
+        if (value == NULL) {
+            ds_destroy(&ds);
+            return NULL;
+        }
+        if (ds.length) {
+            ds_put_char(&ds, ',');
+        }
+        ds_put_cstr(&ds, value);
+    }
+
+    return ds_steal_cstr(&ds);
+
+} /* cfg_yaml_scalar_list */
+
+/* Copies the scalar values of 'map' into 'smap', with lists of scalars
+ * such as "data: [ 0x01, 0x02 ]" joined with commas. Returns false if
+ * 'map' also had other values, which are skipped. */
+static bool
+cfg_yaml_mapping_to_smap(yaml_document_t *doc, yaml_node_t *map, struct smap *smap)
+{
+    yaml_node_pair_t *pair;
+    bool scalar_only = true;
+
+    if (map == NULL || map->type != YAML_MAPPING_NODE) {
+        return true;
+    }
+
+    for (pair = map->data.mapping.pairs.start;
+         pair < map->data.mapping.pairs.top; pair++) {
+        yaml_node_t *node = yaml_document_get_node(doc, pair->value);
+        const char *key = cfg_yaml_scalar(yaml_document_get_node(doc, pair->key));
+        const char *value = cfg_yaml_scalar(node);
+        char *list;
+
+        /* Skip pre/post lists and anything else that is not flat. */
+        if (key && value) {
+            smap_replace(smap, key, value);
+        } else if (key && (list = cfg_yaml_scalar_list(doc, node)) != NULL) {
+            smap_replace(smap, key, list);
+            free(list);
+        } else {
+            scalar_only = false;
+        }
+    }
+
+    return scalar_only;
+
+} /* cfg_yaml_mapping_to_smap */
+
+/* Parses devices.yaml under 'hw_desc_dir' into 'doc'. */
+static bool
+cfg_yaml_load_devices_doc(const char *hw_desc_dir, yaml_document_t *doc)
+{
+    char            *path;
+    FILE            *fh;
+    bool            rc = false;
+    yaml_parser_t   parser;
+
+    path = xasprintf("%s/%s", hw_desc_dir, DEVICES_YAML_FILE);
+    fh = fopen(path, "r");
+    if (fh == NULL) {
+        VLOG_ERR("Failed to open file %s", path);
+        free(path);
+        return false;
+    }
+
+    if (!yaml_parser_initialize(&parser)) {
+        VLOG_ERR("Failed to initialize parser");
+    } else {
+        yaml_parser_set_input_file(&parser, fh);
+        rc = yaml_parser_load(&parser, doc);
+        if (!rc) {
+            VLOG_ERR("Failed to parse %s", path);
+        }
+        yaml_parser_delete(&parser);
+    }
+
+    fclose(fh);
+    free(path);
+
+    return rc;
+
+} /* cfg_yaml_load_devices_doc */
+
+/*
+ * Returns the scalar attributes of device 'name' and of the bus it is
+ * attached to, as listed in devices.yaml under 'hw_desc_dir'.
+ */
+bool
+sysd_cfg_yaml_get_device_cfg(const char *hw_desc_dir, const char *name,
+                             struct smap *dev_cfg, struct smap *bus_cfg)
+{
+    bool            found = false;
+    yaml_document_t doc;
+    yaml_node_t     *root;
+    yaml_node_t     *dev;
+
+    if (!cfg_yaml_load_devices_doc(hw_desc_dir, &doc)) {
+        return false;
+    }
+
+    root = yaml_document_get_root_node(&doc);
+    dev = cfg_yaml_sequence_find(&doc, cfg_yaml_mapping_get(&doc, root, "devices"),
+                                 name);
+    if (dev != NULL) {
+        const char *bus_name;
+
+        found = true;
+        cfg_yaml_mapping_to_smap(&doc, dev, dev_cfg);
+
+        bus_name = smap_get(dev_cfg, "bus");
+        if (bus_name && bus_cfg) {
+            cfg_yaml_mapping_to_smap(&doc,
+                cfg_yaml_sequence_find(&doc, cfg_yaml_mapping_get(&doc, root, "buses"),
+                                       bus_name),
+                bus_cfg);
+        }
+    }
+
+    yaml_document_delete(&doc);
+
+    return found;
+
+} /* sysd_cfg_yaml_get_device_cfg */
+
+static struct smap *
+cfg_yaml_entry_to_smap(yaml_document_t *doc, yaml_node_t *entry)
+{
+    struct smap *smap = xmalloc(sizeof *smap);
+
+    smap_init(smap);
+    if (entry == NULL || entry->type != YAML_MAPPING_NODE
+        || !cfg_yaml_mapping_to_smap(doc, entry, smap)) {
+        smap_replace(smap, SYSD_CFG_YAML_NESTED_KEY, "true");
+    }
+
+    return smap;
+
+} /* cfg_yaml_entry_to_smap */
+
+static void
+cfg_yaml_sequence_to_shash(yaml_document_t *doc, yaml_node_t *seq,
+                           struct shash *shash)
+{
+    yaml_node_item_t *item;
+
+    if (seq == NULL || seq->type != YAML_SEQUENCE_NODE) {
+        return;
+    }
+
+    for (item = seq->data.sequence.items.start;
+         item < seq->data.sequence.items.top; item++) {
+        struct smap *smap = cfg_yaml_entry_to_smap(doc,
+                                    yaml_document_get_node(doc, *item));
+        const char *name = smap_get(smap, "name");
+
+        if (name == NULL || !shash_add_once(shash, name, smap)) {
+            smap_destroy(smap);
+            free(smap);
+        }
+    }
+
+} /* cfg_yaml_sequence_to_shash */
+
+/*
+ * Loads the 'devices' and 'buses' sections of devices.yaml, keyed by name,
+ * and the 'init' section in file order. Every entry is an smap of its
+ * scalar attributes. Entries that also have list or mapping values, such
+ * as a device's mux 'pre'/'post' operations, get SYSD_CFG_YAML_NESTED_KEY.
+ */
+bool
+sysd_cfg_yaml_load_devices(const char *hw_desc_dir,
+                           struct sysd_cfg_yaml_devices *cfg)
+{
+    yaml_document_t     doc;
+    yaml_node_t         *root;
+    yaml_node_t         *init;
+    yaml_node_item_t    *item;
+
+    shash_init(&cfg->devices);
+    shash_init(&cfg->buses);
+    cfg->init = NULL;
+    cfg->n_init = 0;
+
+    if (!cfg_yaml_load_devices_doc(hw_desc_dir, &doc)) {
+        return false;
+    }
+
+    root = yaml_document_get_root_node(&doc);
+    cfg_yaml_sequence_to_shash(&doc, cfg_yaml_mapping_get(&doc, root, "devices"),
+                               &cfg->devices);
+    cfg_yaml_sequence_to_shash(&doc, cfg_yaml_mapping_get(&doc, root, "buses"),
+                               &cfg->buses);
+
+    init = cfg_yaml_mapping_get(&doc, root, "init");
+    if (init != NULL && init->type == YAML_SEQUENCE_NODE) {
+        cfg->n_init = init->data.sequence.items.top - init->data.sequence.items.start;
+        cfg->init = xcalloc(cfg->n_init, sizeof *cfg->init);
+        cfg->n_init = 0;
+        for (item = init->data.sequence.items.start;
+             item < init->data.sequence.items.top; item++) {
+            cfg->init[cfg->n_init++] =
+                cfg_yaml_entry_to_smap(&doc, yaml_document_get_node(&doc, *item));
+        }
+    }
+
+    yaml_document_delete(&doc);
+
+    return true;
+
+} /* sysd_cfg_yaml_load_devices */
+
+static void
+cfg_yaml_smap_shash_destroy(struct shash *shash)
+{
+    struct shash_node *node;
+
+    SHASH_FOR_EACH (node, shash) {
+        smap_destroy(node->data);
+    }
+    shash_destroy_free_data(shash);
+
+} /* cfg_yaml_smap_shash_destroy */
+
+void
+sysd_cfg_yaml_devices_destroy(struct sysd_cfg_yaml_devices *cfg)
+{
+    size_t i;
+
+    cfg_yaml_smap_shash_destroy(&cfg->devices);
+    cfg_yaml_smap_shash_destroy(&cfg->buses);
+    for (i = 0; i < cfg->n_init; i++) {
+        smap_destroy(cfg->init[i]);
+        free(cfg->init[i]);
+    }
+    free(cfg->init);
+
+} /* sysd_cfg_yaml_devices_destroy */
 
 YamlQosInfo *
 sysd_cfg_yaml_get_qos_info(void)
 {
+    if (cfg_snapshot) {
+        return cfg_snapshot->qos_info;
+    }
     return yaml_get_qos_info(cfg_yaml_handle, BASE_SUBSYSTEM);
 }
 
 int
 sysd_cfg_yaml_get_cos_map_entry_count(void)
 {
+    if (cfg_snapshot) {
+        return cfg_snapshot->n_cos_map;
+    }
     return yaml_get_cos_map_entry_count(cfg_yaml_handle, BASE_SUBSYSTEM);
 }
 
 const YamlCosMapEntry *
 sysd_cfg_yaml_get_cos_map_entry(unsigned int idx)
 {
+    if (cfg_snapshot) {
+        return idx < cfg_snapshot->n_cos_map ? &cfg_snapshot->cos_map[idx] : NULL;
+    }
     return yaml_get_cos_map_entry(cfg_yaml_handle, BASE_SUBSYSTEM, idx);
 }
 
 int
 sysd_cfg_yaml_get_dscp_map_entry_count(void)
 {
+    if (cfg_snapshot) {
+        return cfg_snapshot->n_dscp_map;
+    }
     return yaml_get_dscp_map_entry_count(cfg_yaml_handle, BASE_SUBSYSTEM);
 }
 
 const YamlDscpMapEntry *
 sysd_cfg_yaml_get_dscp_map_entry(unsigned int idx)
 {
+    if (cfg_snapshot) {
+        return idx < cfg_snapshot->n_dscp_map ? &cfg_snapshot->dscp_map[idx] : NULL;
+    }
     return yaml_get_dscp_map_entry(cfg_yaml_handle, BASE_SUBSYSTEM, idx);
 }
 
 int
 sysd_cfg_yaml_get_schedule_profile_entry_count(void)
 {
+    if (cfg_snapshot) {
+        return cfg_snapshot->n_schedule_profile;
+    }
     return yaml_get_schedule_profile_entry_count(cfg_yaml_handle, BASE_SUBSYSTEM);
 }
 
 const YamlScheduleProfileEntry *
 sysd_cfg_yaml_get_schedule_profile_entry(unsigned int idx)
 {
+    if (cfg_snapshot) {
+        return idx < cfg_snapshot->n_schedule_profile ? &cfg_snapshot->schedule_profile[idx] : NULL;
+    }
     return yaml_get_schedule_profile_entry(cfg_yaml_handle, BASE_SUBSYSTEM, idx);
 }
 
 int
 sysd_cfg_yaml_get_queue_profile_entry_count(void)
 {
+    if (cfg_snapshot) {
+        return cfg_snapshot->n_queue_profile;
+    }
     return yaml_get_queue_profile_entry_count(cfg_yaml_handle, BASE_SUBSYSTEM);
 }
 
 const YamlQueueProfileEntry *
 sysd_cfg_yaml_get_queue_profile_entry(unsigned int idx)
 {
+    if (cfg_snapshot) {
+        return idx < cfg_snapshot->n_queue_profile ? &cfg_snapshot->queue_profile[idx] : NULL;
+    }
     return yaml_get_queue_profile_entry(cfg_yaml_handle, BASE_SUBSYSTEM, idx);
 }
 
 YamlAclInfo *
 sysd_cfg_yaml_get_acl_info(void)
 {
+    if (cfg_snapshot) {
+        return cfg_snapshot->acl_info;
+    }
     return yaml_get_acl_info(cfg_yaml_handle, BASE_SUBSYSTEM);
 }
 
@@ -271,11 +679,261 @@ void
 sysd_cfg_yaml_set_system_status_led(int good)
 {
     const YamlSystemLedInfo *system_led;
+    bool                    reopened = false;
+
+    /* After sysd_cfg_yaml_compact() this only runs on exit, which can
+     * afford to parse devices.yaml again. */
+    if (cfg_yaml_handle == NULL) {
+        if (!sysd_cfg_yaml_open(cfg_hw_desc_dir)
+            || 0 > yaml_parse_devices(cfg_yaml_handle, BASE_SUBSYSTEM)) {
+            VLOG_ERR("Unable to reparse devices yaml config file.");
+            yaml_free_config_handle(cfg_yaml_handle);
+            cfg_yaml_handle = NULL;
+            return;
+        }
+        reopened = true;
+    }
+
     system_led = yaml_get_system_led_info(cfg_yaml_handle, BASE_SUBSYSTEM);
     if (system_led && system_led->status_led) {
         i2c_reg_write(cfg_yaml_handle, BASE_SUBSYSTEM, system_led->status_led,
                       good ? system_led->status_led_settings.on :
                              system_led->status_led_settings.flashing);
     }
+
+    if (reopened) {
+        yaml_free_config_handle(cfg_yaml_handle);
+        cfg_yaml_handle = NULL;
+    }
 }
+
+/* Copies a NULL terminated array of strings into sysd_state_arena. */
+static char **
+cfg_yaml_strv_copy(char **strv)
+{
+    char    **copy;
+    size_t  n = 0;
+    size_t  i;
+
+    if (strv == NULL) {
+        return NULL;
+    }
+    while (strv[n]) {
+        n++;
+    }
+    copy = sysd_arena_alloc(&sysd_state_arena, (n + 1) * sizeof *copy);
+    for (i = 0; i < n; i++) {
+        copy[i] = sysd_arena_strdup(&sysd_state_arena, strv[i]);
+    }
+
+    return copy;
+
+} /* cfg_yaml_strv_copy */
+
+/* Same for the NULL terminated array of speeds of a port. */
+static int **
+cfg_yaml_intv_copy(int **intv)
+{
+    int     **copy;
+    size_t  n = 0;
+    size_t  i;
+
+    if (intv == NULL) {
+        return NULL;
+    }
+    while (intv[n]) {
+        n++;
+    }
+    copy = sysd_arena_alloc(&sysd_state_arena, (n + 1) * sizeof *copy);
+    for (i = 0; i < n; i++) {
+        copy[i] = sysd_arena_memdup(&sysd_state_arena, intv[i], sizeof **intv);
+    }
+
+    return copy;
+
+} /* cfg_yaml_intv_copy */
+
+/*
+ * Ports of the same type have the same connector, speeds and capabilities.
+ * Each distinct value is copied once and shared by all the ports that have
+ * it, found in 'interned' by a key that spells out its content.
+ */
+static const char *
+cfg_yaml_intern_key(struct ds *key, char type, char **strv, int **intv,
+                    const char *str)
+{
+    size_t i;
+
+    ds_clear(key);
+    ds_put_char(key, type);
+    for (i = 0; strv && strv[i]; i++) {
+        ds_put_format(key, "%s\n", strv[i]);
+    }
+    for (i = 0; intv && intv[i]; i++) {
+        ds_put_format(key, "%d,", *intv[i]);
+    }
+    if (str) {
+        ds_put_cstr(key, str);
+    }
+
+    return ds_cstr(key);
+
+} /* cfg_yaml_intern_key */
+
+static void
+cfg_yaml_port_copy(YamlPort *copy, const YamlPort *port,
+                   struct shash *interned)
+{
+    struct ds   key = DS_EMPTY_INITIALIZER;
+    void        *p;
+
+    *copy = *port;
+    copy->name = sysd_arena_strdup(&sysd_state_arena, port->name);
+    copy->subports = cfg_yaml_strv_copy(port->subports);
+    copy->parent_port = sysd_arena_strdup(&sysd_state_arena, port->parent_port);
+
+    if (port->speeds) {
+        cfg_yaml_intern_key(&key, 's', NULL, port->speeds, NULL);
+        p = shash_find_data(interned, ds_cstr(&key));
+        if (p == NULL) {
+            p = cfg_yaml_intv_copy(port->speeds);
+            shash_add(interned, ds_cstr(&key), p);
+        }
+        copy->speeds = p;
+    }
+    if (port->capabilities) {
+        cfg_yaml_intern_key(&key, 'c', port->capabilities, NULL, NULL);
+        p = shash_find_data(interned, ds_cstr(&key));
+        if (p == NULL) {
+            p = cfg_yaml_strv_copy(port->capabilities);
+            shash_add(interned, ds_cstr(&key), p);
+        }
+        copy->capabilities = p;
+    }
+    if (port->connector) {
+        cfg_yaml_intern_key(&key, 'n', NULL, NULL, port->connector);
+        p = shash_find_data(interned, ds_cstr(&key));
+        if (p == NULL) {
+            p = sysd_arena_strdup(&sysd_state_arena, port->connector);
+            shash_add(interned, ds_cstr(&key), p);
+        }
+        copy->connector = p;
+    }
+    ds_destroy(&key);
+
+} /* cfg_yaml_port_copy */
+
+/*
+ * Moves what sysd reads from the hardware description after boot (ports,
+ * QoS and ACL defaults) into sysd_state_arena and frees the YAML handle,
+ * with everything config-yaml parsed. Pointers previously returned by the
+ * getters are invalid afterwards and must be fetched again.
+ */
+void
+sysd_cfg_yaml_compact(void)
+{
+    struct cfg_yaml_snapshot    *snap;
+    const YamlPortInfo          *port_info;
+    const YamlQosInfo           *qos_info;
+    const YamlAclInfo           *acl_info;
+    struct shash                interned = SHASH_INITIALIZER(&interned);
+    int                         i;
+
+    if (cfg_snapshot || cfg_yaml_handle == NULL) {
+        return;
+    }
+
+    snap = sysd_arena_alloc(&sysd_state_arena, sizeof *snap);
+
+    port_info = sysd_cfg_yaml_get_port_subsys_info();
+    if (port_info) {
+        snap->port_info = *port_info;
+    }
+    snap->n_ports = MAX(sysd_cfg_yaml_get_port_count(), 0);
+    snap->ports = sysd_arena_alloc(&sysd_state_arena,
+                                   snap->n_ports * sizeof *snap->ports);
+    for (i = 0; i < snap->n_ports; i++) {
+        const YamlPort *port = sysd_cfg_yaml_get_port_info(i);
+
+        if (port) {
+            cfg_yaml_port_copy(&snap->ports[i], port, &interned);
+        }
+    }
+    shash_destroy(&interned);
+
+    qos_info = sysd_cfg_yaml_get_qos_info();
+    if (qos_info) {
+        snap->qos_info = sysd_arena_memdup(&sysd_state_arena, qos_info,
+                                           sizeof *qos_info);
+        snap->qos_info->trust =
+            sysd_arena_strdup(&sysd_state_arena, qos_info->trust);
+        snap->qos_info->default_name =
+            sysd_arena_strdup(&sysd_state_arena, qos_info->default_name);
+        snap->qos_info->factory_default_name =
+            sysd_arena_strdup(&sysd_state_arena,
+                              qos_info->factory_default_name);
+    }
+
+    snap->n_cos_map = MAX(sysd_cfg_yaml_get_cos_map_entry_count(), 0);
+    snap->cos_map = sysd_arena_alloc(&sysd_state_arena,
+                                     snap->n_cos_map * sizeof *snap->cos_map);
+    for (i = 0; i < snap->n_cos_map; i++) {
+        YamlCosMapEntry *entry = &snap->cos_map[i];
+
+        *entry = *sysd_cfg_yaml_get_cos_map_entry(i);
+        entry->color = sysd_arena_strdup(&sysd_state_arena, entry->color);
+        entry->description = sysd_arena_strdup(&sysd_state_arena,
+                                               entry->description);
+    }
+
+    snap->n_dscp_map = MAX(sysd_cfg_yaml_get_dscp_map_entry_count(), 0);
+    snap->dscp_map = sysd_arena_alloc(&sysd_state_arena,
+                                      snap->n_dscp_map * sizeof *snap->dscp_map);
+    for (i = 0; i < snap->n_dscp_map; i++) {
+        YamlDscpMapEntry *entry = &snap->dscp_map[i];
+
+        *entry = *sysd_cfg_yaml_get_dscp_map_entry(i);
+        entry->color = sysd_arena_strdup(&sysd_state_arena, entry->color);
+        entry->description = sysd_arena_strdup(&sysd_state_arena,
+                                               entry->description);
+    }
+
+    snap->n_schedule_profile =
+        MAX(sysd_cfg_yaml_get_schedule_profile_entry_count(), 0);
+    snap->schedule_profile =
+        sysd_arena_alloc(&sysd_state_arena, snap->n_schedule_profile
+                                            * sizeof *snap->schedule_profile);
+    for (i = 0; i < snap->n_schedule_profile; i++) {
+        YamlScheduleProfileEntry *entry = &snap->schedule_profile[i];
+
+        *entry = *sysd_cfg_yaml_get_schedule_profile_entry(i);
+        entry->algorithm = sysd_arena_strdup(&sysd_state_arena,
+                                             entry->algorithm);
+    }
+
+    snap->n_queue_profile =
+        MAX(sysd_cfg_yaml_get_queue_profile_entry_count(), 0);
+    snap->queue_profile =
+        sysd_arena_alloc(&sysd_state_arena, snap->n_queue_profile
+                                            * sizeof *snap->queue_profile);
+    for (i = 0; i < snap->n_queue_profile; i++) {
+        YamlQueueProfileEntry *entry = &snap->queue_profile[i];
+
+        *entry = *sysd_cfg_yaml_get_queue_profile_entry(i);
+        entry->description = sysd_arena_strdup(&sysd_state_arena,
+                                               entry->description);
+    }
+
+    acl_info = sysd_cfg_yaml_get_acl_info();
+    if (acl_info) {
+        snap->acl_info = sysd_arena_memdup(&sysd_state_arena, acl_info,
+                                           sizeof *acl_info);
+    }
+
+    cfg_snapshot = snap;
+    fru_dev = NULL;
+    yaml_free_config_handle(cfg_yaml_handle);
+    cfg_yaml_handle = NULL;
+
+} /* sysd_cfg_yaml_compact */
 /** @} end of group sysd */
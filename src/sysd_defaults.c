@@ -0,0 +1,500 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup sysd
+ *
+ * @file
+ * Source for the sysd default topology template.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util.h>
+#include <openswitch-idl.h>
+#include <vrf-utils.h>
+#include <openvswitch/vlog.h>
+
+#include <config-yaml.h>
+#include <yaml.h>
+#include "sysd.h"
+#include "sysd_arena.h"
+#include "sysd_defaults.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_defaults);
+
+/** @ingroup sysd
+ * @{ */
+
+static sysd_default_bridge_t builtin_bridges[] = {
+    { DEFAULT_BRIDGE_NAME, true, 0, NULL },
+};
+
+static sysd_default_vrf_t builtin_vrfs[] = {
+    { DEFAULT_VRF_NAME, true, 0 },
+};
+
+static sysd_defaults_t builtin_defaults = {
+    ARRAY_SIZE(builtin_bridges), builtin_bridges,
+    ARRAY_SIZE(builtin_vrfs), builtin_vrfs,
+};
+
+static const sysd_defaults_t *defaults = &builtin_defaults;
+
+/* A template being read. Names point into 'doc' until the result is copied
+ * into sysd_state_arena. */
+struct defaults_parse {
+    yaml_document_t *doc;
+    char            *file;
+    sysd_defaults_t result;
+    size_t          allocated_bridges;
+    size_t          allocated_vrfs;
+    bool            vlan_used[SYSD_DEFAULTS_MAX_VLAN + 1];
+};
+
+const sysd_defaults_t *
+sysd_defaults_get(void)
+{
+    return defaults;
+
+} /* sysd_defaults_get */
+
+static const char *
+defaults_scalar(const struct defaults_parse *p, int idx)
+{
+    yaml_node_t *node = yaml_document_get_node(p->doc, idx);
+
+    return node && node->type == YAML_SCALAR_NODE
+           ? (const char *) node->data.scalar.value : NULL;
+
+} /* defaults_scalar */
+
+/* Returns the value of 'key' in mapping 'map', or NULL. */
+static yaml_node_t *
+defaults_find(const struct defaults_parse *p, yaml_node_t *map,
+              const char *key)
+{
+    yaml_node_pair_t *pair;
+
+    if (map == NULL || map->type != YAML_MAPPING_NODE) {
+        return NULL;
+    }
+    for (pair = map->data.mapping.pairs.start;
+         pair < map->data.mapping.pairs.top; pair++) {
+        const char *name = defaults_scalar(p, pair->key);
+
+        if (name && !strcmp(name, key)) {
+            return yaml_document_get_node(p->doc, pair->value);
+        }
+    }
+
+    return NULL;
+
+} /* defaults_find */
+
+static const char *
+defaults_find_scalar(const struct defaults_parse *p, yaml_node_t *map,
+                     const char *key)
+{
+    yaml_node_t *node = defaults_find(p, map, key);
+
+    return node && node->type == YAML_SCALAR_NODE
+           ? (const char *) node->data.scalar.value : NULL;
+
+} /* defaults_find_scalar */
+
+/* Parses 's' as an integer from 'min' to 'max'. */
+static bool
+defaults_parse_int(const char *s, long long min, long long max,
+                   long long *value)
+{
+    return s && str_to_llong(s, 10, value) && *value >= min && *value <= max;
+
+} /* defaults_parse_int */
+
+/* Parses 'key' of 'map' as a boolean, which is 'dflt' if absent. */
+static bool
+defaults_parse_bool(const struct defaults_parse *p, yaml_node_t *map,
+                    const char *key, bool dflt, bool *value)
+{
+    const char *s = defaults_find_scalar(p, map, key);
+
+    if (s == NULL) {
+        *value = dflt;
+    } else if (!strcmp(s, "true") || !strcmp(s, "yes")) {
+        *value = true;
+    } else if (!strcmp(s, "false") || !strcmp(s, "no")) {
+        *value = false;
+    } else {
+        VLOG_ERR("%s: %s must be true or false, not \"%s\"",
+                 p->file, key, s);
+        return false;
+    }
+
+    return true;
+
+} /* defaults_parse_bool */
+
+static bool
+defaults_add_vlan(struct defaults_parse *p, sysd_default_bridge_t *bridge,
+                  size_t *allocated, long long id, const char *name,
+                  bool admin_up)
+{
+    sysd_default_vlan_t *vlan;
+
+    if (p->vlan_used[id]) {
+        VLOG_ERR("%s: VLAN %lld is listed more than once", p->file, id);
+        return false;
+    }
+    p->vlan_used[id] = true;
+
+    if (bridge->n_vlans >= *allocated) {
+        bridge->vlans = x2nrealloc(bridge->vlans, allocated,
+                                   sizeof *bridge->vlans);
+    }
+    vlan = &bridge->vlans[bridge->n_vlans++];
+    vlan->id = id;
+    vlan->name = name;
+    vlan->admin_up = admin_up;
+
+    return true;
+
+} /* defaults_add_vlan */
+
+/* Parses a bridge's VLANs, each either "id: N" with an optional name, or
+ * "ids: FIRST-LAST" named VLAN<id>. Both take "admin: up|down". */
+static bool
+defaults_parse_vlans(struct defaults_parse *p, sysd_default_bridge_t *bridge,
+                     yaml_node_t *seq)
+{
+    yaml_node_item_t    *item;
+    size_t              allocated = 0;
+
+    if (seq->type != YAML_SEQUENCE_NODE) {
+        VLOG_ERR("%s: vlans of bridge %s must be a list",
+                 p->file, bridge->name);
+        return false;
+    }
+
+    for (item = seq->data.sequence.items.start;
+         item < seq->data.sequence.items.top; item++) {
+        yaml_node_t *node = yaml_document_get_node(p->doc, *item);
+        const char  *id = defaults_find_scalar(p, node, "id");
+        const char  *ids = defaults_find_scalar(p, node, "ids");
+        const char  *admin = defaults_find_scalar(p, node, "admin");
+        bool        admin_up = true;
+        long long   first;
+        long long   last;
+        long long   i;
+
+        if (admin) {
+            if (!strcmp(admin, "down")) {
+                admin_up = false;
+            } else if (strcmp(admin, "up")) {
+                VLOG_ERR("%s: VLAN admin must be up or down, not \"%s\"",
+                         p->file, admin);
+                return false;
+            }
+        }
+
+        if (id) {
+            if (!defaults_parse_int(id, SYSD_DEFAULTS_MIN_VLAN,
+                                    SYSD_DEFAULTS_MAX_VLAN, &first)
+                || !defaults_add_vlan(p, bridge, &allocated, first,
+                                      defaults_find_scalar(p, node, "name"),
+                                      admin_up)) {
+                VLOG_ERR("%s: bad VLAN id \"%s\"", p->file, id);
+                return false;
+            }
+        } else if (ids) {
+            char *s = xstrdup(ids);
+            char *dash = strchr(s, '-');
+            bool ok;
+
+            if (dash) {
+                *dash = '\0';
+            }
+            ok = dash
+                 && defaults_parse_int(s, SYSD_DEFAULTS_MIN_VLAN,
+                                       SYSD_DEFAULTS_MAX_VLAN, &first)
+                 && defaults_parse_int(dash + 1, first,
+                                       SYSD_DEFAULTS_MAX_VLAN, &last);
+            free(s);
+            if (!ok) {
+                VLOG_ERR("%s: bad VLAN range \"%s\"", p->file, ids);
+                return false;
+            }
+            for (i = first; i <= last; i++) {
+                if (!defaults_add_vlan(p, bridge, &allocated, i, NULL,
+                                       admin_up)) {
+                    return false;
+                }
+            }
+        } else {
+            VLOG_ERR("%s: each VLAN of bridge %s needs an id or ids",
+                     p->file, bridge->name);
+            return false;
+        }
+    }
+
+    return true;
+
+} /* defaults_parse_vlans */
+
+static bool
+defaults_parse_bridges(struct defaults_parse *p, yaml_node_t *seq)
+{
+    yaml_node_item_t *item;
+
+    if (seq->type != YAML_SEQUENCE_NODE) {
+        VLOG_ERR("%s: bridges must be a list", p->file);
+        return false;
+    }
+
+    for (item = seq->data.sequence.items.start;
+         item < seq->data.sequence.items.top; item++) {
+        yaml_node_t             *node = yaml_document_get_node(p->doc, *item);
+        const char              *name = defaults_find_scalar(p, node, "name");
+        yaml_node_t             *vlans = defaults_find(p, node, "vlans");
+        sysd_default_bridge_t   *bridge;
+        size_t                  i;
+
+        if (name == NULL) {
+            VLOG_ERR("%s: each bridge needs a name", p->file);
+            return false;
+        }
+        for (i = 0; i < p->result.n_bridges; i++) {
+            if (!strcmp(p->result.bridges[i].name, name)) {
+                VLOG_ERR("%s: bridge %s is listed more than once",
+                         p->file, name);
+                return false;
+            }
+        }
+
+        if (p->result.n_bridges >= p->allocated_bridges) {
+            p->result.bridges = x2nrealloc(p->result.bridges,
+                                           &p->allocated_bridges,
+                                           sizeof *p->result.bridges);
+        }
+        bridge = &p->result.bridges[p->result.n_bridges++];
+        memset(bridge, 0, sizeof *bridge);
+        bridge->name = name;
+
+        if (!defaults_parse_bool(p, node, "internal_port", true,
+                                 &bridge->internal_port)
+            || (vlans && !defaults_parse_vlans(p, bridge, vlans))) {
+            return false;
+        }
+    }
+
+    return true;
+
+} /* defaults_parse_bridges */
+
+static bool
+defaults_parse_vrfs(struct defaults_parse *p, yaml_node_t *seq)
+{
+    yaml_node_item_t *item;
+
+    if (seq->type != YAML_SEQUENCE_NODE) {
+        VLOG_ERR("%s: vrfs must be a list", p->file);
+        return false;
+    }
+
+    for (item = seq->data.sequence.items.start;
+         item < seq->data.sequence.items.top; item++) {
+        yaml_node_t         *node = yaml_document_get_node(p->doc, *item);
+        const char          *name = defaults_find_scalar(p, node, "name");
+        const char          *table_id = defaults_find_scalar(p, node,
+                                                             "table_id");
+        sysd_default_vrf_t  *vrf;
+        long long           value = 0;
+        size_t              i;
+
+        if (name == NULL) {
+            VLOG_ERR("%s: each VRF needs a name", p->file);
+            return false;
+        }
+        for (i = 0; i < p->result.n_vrfs; i++) {
+            if (!strcmp(p->result.vrfs[i].name, name)) {
+                VLOG_ERR("%s: VRF %s is listed more than once",
+                         p->file, name);
+                return false;
+            }
+        }
+        if (table_id && !defaults_parse_int(table_id, 0, INT32_MAX, &value)) {
+            VLOG_ERR("%s: bad table_id \"%s\" for VRF %s",
+                     p->file, table_id, name);
+            return false;
+        }
+
+        if (p->result.n_vrfs >= p->allocated_vrfs) {
+            p->result.vrfs = x2nrealloc(p->result.vrfs, &p->allocated_vrfs,
+                                        sizeof *p->result.vrfs);
+        }
+        vrf = &p->result.vrfs[p->result.n_vrfs++];
+        vrf->name = name;
+        vrf->has_table_id = table_id != NULL;
+        vrf->table_id = value;
+    }
+
+    return true;
+
+} /* defaults_parse_vrfs */
+
+/* Copies the parsed template into sysd_state_arena, adding the default
+ * bridge and VRF that other daemons rely on if it leaves them out. */
+static sysd_defaults_t *
+defaults_commit(const struct defaults_parse *p)
+{
+    sysd_defaults_t *d = sysd_arena_alloc(&sysd_state_arena, sizeof *d);
+    bool            has_bridge = false;
+    bool            has_vrf = false;
+    size_t          i;
+
+    for (i = 0; i < p->result.n_bridges; i++) {
+        has_bridge |= !strcmp(p->result.bridges[i].name, DEFAULT_BRIDGE_NAME);
+    }
+    for (i = 0; i < p->result.n_vrfs; i++) {
+        has_vrf |= !strcmp(p->result.vrfs[i].name, DEFAULT_VRF_NAME);
+    }
+
+    d->bridges = sysd_arena_alloc(&sysd_state_arena,
+                                  (p->result.n_bridges + !has_bridge)
+                                  * sizeof *d->bridges);
+    if (!has_bridge) {
+        d->bridges[d->n_bridges++] = builtin_bridges[0];
+    }
+    for (i = 0; i < p->result.n_bridges; i++) {
+        const sysd_default_bridge_t *src = &p->result.bridges[i];
+        sysd_default_bridge_t       *dst = &d->bridges[d->n_bridges++];
+        size_t                      j;
+
+        dst->name = sysd_arena_strdup(&sysd_state_arena, src->name);
+        dst->internal_port = src->internal_port;
+        dst->n_vlans = src->n_vlans;
+        dst->vlans = sysd_arena_alloc(&sysd_state_arena,
+                                      src->n_vlans * sizeof *dst->vlans);
+        for (j = 0; j < src->n_vlans; j++) {
+            dst->vlans[j] = src->vlans[j];
+            dst->vlans[j].name = sysd_arena_strdup(&sysd_state_arena,
+                                                   src->vlans[j].name);
+        }
+    }
+
+    d->vrfs = sysd_arena_alloc(&sysd_state_arena,
+                               (p->result.n_vrfs + !has_vrf)
+                               * sizeof *d->vrfs);
+    if (!has_vrf) {
+        d->vrfs[d->n_vrfs++] = builtin_vrfs[0];
+    }
+    for (i = 0; i < p->result.n_vrfs; i++) {
+        sysd_default_vrf_t *dst = &d->vrfs[d->n_vrfs++];
+
+        *dst = p->result.vrfs[i];
+        dst->name = sysd_arena_strdup(&sysd_state_arena, dst->name);
+    }
+
+    return d;
+
+} /* defaults_commit */
+
+/* Reads SYSD_DEFAULTS_FILE from 'hw_desc_dir' if it is there. Returns 0 if
+ * it was read or is absent, or -1 if it is unusable, in which case the
+ * built-in defaults are kept. */
+int
+sysd_defaults_load(const char *hw_desc_dir)
+{
+    struct defaults_parse   *p;
+    yaml_parser_t           parser;
+    yaml_document_t         doc;
+    yaml_node_t             *root;
+    yaml_node_t             *bridges;
+    yaml_node_t             *vrfs;
+    size_t                  n_vlans = 0;
+    size_t                  i;
+    bool                    ok = false;
+    FILE                    *fp;
+    int                     error;
+
+    p = xzalloc(sizeof *p);
+    p->file = xasprintf("%s/%s", hw_desc_dir, SYSD_DEFAULTS_FILE);
+
+    fp = fopen(p->file, "r");
+    if (fp == NULL) {
+        error = errno;
+        if (error != ENOENT) {
+            VLOG_ERR("Unable to open %s. Error %s",
+                     p->file, ovs_strerror(error));
+        }
+        free(p->file);
+        free(p);
+        return error == ENOENT ? 0 : -1;
+    }
+
+    yaml_parser_initialize(&parser);
+    yaml_parser_set_input_file(&parser, fp);
+    if (!yaml_parser_load(&parser, &doc)) {
+        VLOG_ERR("%s: %s at line %"PRIuSIZE, p->file,
+                 parser.problem ? parser.problem : "parse error",
+                 parser.problem_mark.line + 1);
+        yaml_parser_delete(&parser);
+        fclose(fp);
+        free(p->file);
+        free(p);
+        return -1;
+    }
+    yaml_parser_delete(&parser);
+    fclose(fp);
+
+    p->doc = &doc;
+    root = yaml_document_get_root_node(&doc);
+    if (root == NULL || root->type != YAML_MAPPING_NODE) {
+        VLOG_ERR("%s: expected a mapping", p->file);
+    } else {
+        bridges = defaults_find(p, root, "bridges");
+        vrfs = defaults_find(p, root, "vrfs");
+        ok = (!bridges || defaults_parse_bridges(p, bridges))
+             && (!vrfs || defaults_parse_vrfs(p, vrfs));
+    }
+    if (ok) {
+        defaults = defaults_commit(p);
+    }
+
+    for (i = 0; i < p->result.n_bridges; i++) {
+        free(p->result.bridges[i].vlans);
+    }
+    free(p->result.bridges);
+    free(p->result.vrfs);
+    yaml_document_delete(&doc);
+
+    if (ok) {
+        for (i = 0; i < defaults->n_bridges; i++) {
+            n_vlans += defaults->bridges[i].n_vlans;
+        }
+        VLOG_INFO("%s: %"PRIuSIZE" bridges with %"PRIuSIZE" VLANs, "
+                  "%"PRIuSIZE" VRFs", p->file, defaults->n_bridges, n_vlans,
+                  defaults->n_vrfs);
+    }
+    free(p->file);
+    free(p);
+
+    return ok ? 0 : -1;
+
+} /* sysd_defaults_load */
+/** @} end of group sysd */
@@ -0,0 +1,160 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup sysd
+ *
+ * @file
+ * Source for sysd column change dispatch.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <ovsdb-idl.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include "sysd_dispatch.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_dispatch);
+
+/** @ingroup sysd
+ * @{ */
+
+extern struct ovsdb_idl *idl;
+
+struct dispatch_column {
+    const struct ovsdb_idl_table_class  *table;
+    const struct ovsdb_idl_column       *column;
+};
+
+struct dispatch_handler {
+    const char              *name;
+    sysd_dispatch_cb        *cb;
+    bool                    pending;    /* Run at the next dispatch. */
+    size_t                  n_columns;
+    struct dispatch_column  columns[SYSD_DISPATCH_MAX_COLUMNS];
+};
+
+static struct dispatch_handler  handlers[SYSD_DISPATCH_MAX_HANDLERS];
+static size_t                   n_handlers;
+
+/* IDL sequence number at the last dispatch. Rows inserted since count as
+ * changes to all of their columns. */
+static unsigned int             dispatch_seqno;
+
+/* Calls 'cb' when 'column' of a row of 'table' changes. Registering the same
+ * 'cb' again adds another column. Every handler also runs at the first
+ * dispatch, for the contents the IDL starts with. Must be called before the
+ * IDL first connects. */
+void
+sysd_dispatch_register(const char *name, sysd_dispatch_cb *cb,
+                       const struct ovsdb_idl_table_class *table,
+                       const struct ovsdb_idl_column *column)
+{
+    struct dispatch_handler *h;
+    size_t                  i;
+
+    for (i = 0; i < n_handlers && handlers[i].cb != cb; i++) {
+        continue;
+    }
+    if (i == n_handlers) {
+        ovs_assert(n_handlers < SYSD_DISPATCH_MAX_HANDLERS);
+        h = &handlers[n_handlers++];
+        h->name = name;
+        h->cb = cb;
+        h->pending = true;
+        h->n_columns = 0;
+    } else {
+        h = &handlers[i];
+    }
+
+    ovs_assert(h->n_columns < SYSD_DISPATCH_MAX_COLUMNS);
+    h->columns[h->n_columns].table = table;
+    h->columns[h->n_columns].column = column;
+    h->n_columns++;
+
+    /* Also puts the column back in the change alerts if it was omitted. */
+    ovsdb_idl_track_add_column(idl, column);
+
+} /* sysd_dispatch_register */
+
+/* Whether any tracked row of 'dc->table' has a change to 'dc->column'. */
+static bool
+dispatch_column_changed(const struct dispatch_column *dc)
+{
+    const struct ovsdb_idl_row *row;
+
+    for (row = ovsdb_idl_track_get_first(idl, dc->table); row;
+         row = ovsdb_idl_track_get_next(row)) {
+        if (ovsdb_idl_track_is_updated(row, dc->column)
+            || ovsdb_idl_row_get_seqno(row, OVSDB_IDL_CHANGE_INSERT)
+               > dispatch_seqno) {
+            return true;
+        }
+    }
+
+    return false;
+
+} /* dispatch_column_changed */
+
+/* Runs the handlers of the columns that changed, then forgets the changes.
+ * Called from sysd_run() while sysd holds its lock. Changes made while it
+ * does not are kept for the next call. */
+void
+sysd_dispatch_run(void)
+{
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < n_handlers; i++) {
+        struct dispatch_handler *h = &handlers[i];
+
+        for (j = 0; j < h->n_columns && !h->pending; j++) {
+            h->pending = dispatch_column_changed(&h->columns[j]);
+        }
+    }
+
+    /* Handlers may write through the transaction queue, but never change
+     * the replica themselves, so the changes can be forgotten first. */
+    ovsdb_idl_track_clear(idl);
+    dispatch_seqno = ovsdb_idl_get_seqno(idl);
+
+    for (i = 0; i < n_handlers; i++) {
+        struct dispatch_handler *h = &handlers[i];
+
+        if (h->pending) {
+            h->pending = false;
+            VLOG_DBG("Running the %s handler", h->name);
+            h->cb();
+        }
+    }
+
+} /* sysd_dispatch_run */
+
+/* Runs every handler at the next dispatch. Another process may have changed
+ * the database while sysd did not hold its lock. */
+void
+sysd_dispatch_reset(void)
+{
+    size_t i;
+
+    for (i = 0; i < n_handlers; i++) {
+        handlers[i].pending = true;
+    }
+
+} /* sysd_dispatch_reset */
+/** @} end of group sysd */
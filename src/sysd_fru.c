@@ -23,10 +23,16 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 #include <openvswitch/vlog.h>
 #include <util.h>
+#include <json.h>
+#include <shash.h>
+#include <timeval.h>
 
 #include <ops-utils.h>
 #include <config-yaml.h>
@@ -34,7 +40,9 @@
 
 #include "sysd_util.h"
 #include "sysd_fru.h"
+#include "sysd_fru_xport.h"
 #include "sysd_cfg_yaml.h"
+#include "sysd_metrics.h"
 #include "sysd.h"
 
 #include "eventlog.h"
@@ -42,179 +50,683 @@
 VLOG_DEFINE_THIS_MODULE(fru);
 
 extern bool fru_yaml;
+extern char *g_hw_desc_dir;
 
 /** @ingroup sysd
  * @{ */
 
+/*
+ * OCP FRU TLV decoder.
+ *
+ * Every TLV code sysd understands has an entry in fru_tlv_decoders[]
+ * describing how its value is stored in fru_eeprom_t. The same table
+ * drives the FRU cache, so a new field only needs to be added here.
+ *
+ * Decoding runs in two passes over the image. The first pass validates
+ * every TLV against the buffer length and sizes a single arena for all
+ * strings and vendor extensions; the second pass fills the arena. The
+ * arena is owned by fru_eeprom->arena.
+ */
+typedef enum fru_tlv_kind {
+    FRU_TLV_STRING,         /* char *, NUL terminated copy in the arena */
+    FRU_TLV_CHARS,          /* char[max_len + 1] in fru_eeprom_t */
+    FRU_TLV_U8,
+    FRU_TLV_U16,            /* big-endian */
+    FRU_TLV_MAC,
+    FRU_TLV_VENDOR_EXT,
+    FRU_TLV_CRC,
+} fru_tlv_kind_t;
+
+typedef struct fru_tlv_decoder {
+    uint8_t         code;
+    const char      *name;
+    fru_tlv_kind_t  kind;
+    size_t          offset;     /* Offset of the field in fru_eeprom_t. */
+    uint8_t         min_len;
+    uint8_t         max_len;
+} fru_tlv_decoder_t;
+
+#define FRU_TLV_FIELD(CODE, FIELD, KIND, MIN, MAX) \
+    { CODE, #FIELD, KIND, offsetof(fru_eeprom_t, FIELD), MIN, MAX }
+
+static const fru_tlv_decoder_t fru_tlv_decoders[] = {
+    FRU_TLV_FIELD(FRU_PRODUCT_NAME_TYPE, product_name, FRU_TLV_STRING, 0, 255),
+    FRU_TLV_FIELD(FRU_PART_NUMBER_TYPE, part_number, FRU_TLV_STRING, 0, 255),
+    FRU_TLV_FIELD(FRU_SERIAL_NUMBER_TYPE, serial_number, FRU_TLV_STRING, 0, 255),
+    FRU_TLV_FIELD(FRU_BASE_MAC_ADDRESS_TYPE, base_mac_address, FRU_TLV_MAC,
+                  FRU_BASE_MAC_ADDRESS_LEN, FRU_BASE_MAC_ADDRESS_LEN),
+    FRU_TLV_FIELD(FRU_MANUFACTURE_DATE_TYPE, manufacture_date, FRU_TLV_CHARS,
+                  0, FRU_MANUFACTURE_DATE_LEN),
+    FRU_TLV_FIELD(FRU_DEVICE_VERSION_TYPE, device_version, FRU_TLV_U8,
+                  FRU_DEVICE_VERSION_LEN, FRU_DEVICE_VERSION_LEN),
+    FRU_TLV_FIELD(FRU_LABEL_REVISION_TYPE, label_revision, FRU_TLV_STRING, 0, 255),
+    FRU_TLV_FIELD(FRU_PLATFORM_NAME_TYPE, platform_name, FRU_TLV_STRING, 0, 255),
+    FRU_TLV_FIELD(FRU_ONIE_VERSION_TYPE, onie_version, FRU_TLV_STRING, 0, 255),
+    FRU_TLV_FIELD(FRU_NUM_MAC_TYPE, num_macs, FRU_TLV_U16,
+                  FRU_NUM_MACS_LEN, FRU_NUM_MACS_LEN),
+    FRU_TLV_FIELD(FRU_MANUFACTURER_TYPE, manufacturer, FRU_TLV_STRING, 0, 255),
+    FRU_TLV_FIELD(FRU_COUNTRY_CODE_TYPE, country_code, FRU_TLV_CHARS,
+                  0, FRU_COUNTRY_CODE_LEN),
+    FRU_TLV_FIELD(FRU_VENDOR_TYPE, vendor, FRU_TLV_STRING, 0, 255),
+    FRU_TLV_FIELD(FRU_DIAG_VERSION_TYPE, diag_version, FRU_TLV_STRING, 0, 255),
+    FRU_TLV_FIELD(FRU_SERVICE_TAG_TYPE, service_tag, FRU_TLV_STRING, 0, 255),
+    FRU_TLV_FIELD(FRU_VENDOR_EXTENSION_TYPE, vendor_exts, FRU_TLV_VENDOR_EXT,
+                  FRU_VENDOR_EXT_IANA_LEN, 255),
+    { FRU_CRC_TYPE, "crc", FRU_TLV_CRC, 0, FRU_CRC_LEN - 2, FRU_CRC_LEN - 2 },
+};
+
+#define FRU_TLV_FIELD_PTR(FRU, DECODER) \
+            ((void *) ((char *) (FRU) + (DECODER)->offset))
+
+static const fru_tlv_decoder_t *
+fru_tlv_decoder_find(uint8_t code)
+{
+    static const fru_tlv_decoder_t *by_code[256];
+    static bool initialized = false;
+    size_t i;
+
+    if (!initialized) {
+        for (i = 0; i < ARRAY_SIZE(fru_tlv_decoders); i++) {
+            by_code[fru_tlv_decoders[i].code] = &fru_tlv_decoders[i];
+        }
+        initialized = true;
+    }
+
+    return by_code[code];
+
+} /* fru_tlv_decoder_find */
+
+/* Simple bump allocator over fru_eeprom->arena. */
+typedef struct fru_arena {
+    char    *base;
+    size_t  size;
+    size_t  used;
+} fru_arena_t;
+
+static void *
+fru_arena_alloc(fru_arena_t *arena, size_t len)
+{
+    void *p;
+
+    ovs_assert(arena->used + len <= arena->size);
+    p = arena->base + arena->used;
+    arena->used += len;
+
+    return p;
+
+} /* fru_arena_alloc */
+
+static char *
+fru_arena_strndup(fru_arena_t *arena, const char *s, size_t len)
+{
+    char *p = fru_arena_alloc(arena, len + 1);
+
+    memcpy(p, s, len);
+    p[len] = '\0';
+
+    return p;
+
+} /* fru_arena_strndup */
+
+/* Sets up the arena of 'fru_eeprom' to hold 'n_exts' vendor extensions
+ * followed by 'len' bytes of string and payload data. The extension array
+ * comes first so it gets malloc()'s alignment. */
+static void
+fru_arena_init(fru_arena_t *arena, fru_eeprom_t *fru_eeprom, size_t n_exts,
+               size_t len)
+{
+    arena->size = n_exts * sizeof(fru_vendor_ext_t) + len;
+    arena->base = xmalloc(arena->size ? arena->size : 1);
+    arena->used = 0;
+
+    fru_eeprom->arena = arena->base;
+    fru_eeprom->vendor_exts = fru_arena_alloc(arena,
+                                              n_exts * sizeof(fru_vendor_ext_t));
+    fru_eeprom->n_vendor_exts = 0;
+
+} /* fru_arena_init */
+
+static void
+fru_decode_tlv(const fru_tlv_decoder_t *decoder, const fru_tlv_t *fru_tlv,
+               fru_eeprom_t *fru_eeprom, fru_arena_t *arena)
+{
+    const unsigned char *value = (const unsigned char *) fru_tlv->value;
+    void                *field = FRU_TLV_FIELD_PTR(fru_eeprom, decoder);
+    fru_vendor_ext_t    *ext;
+    uint8_t             len = fru_tlv->length;
+    unsigned char       *data;
+
+    switch (decoder->kind) {
+        case FRU_TLV_STRING:
+            *(char **) field = fru_arena_strndup(arena, fru_tlv->value, len);
+            break;
+
+        case FRU_TLV_CHARS:
+            len = MIN(len, decoder->max_len);
+            memcpy(field, value, len);
+            ((char *) field)[len] = '\0';
+            break;
+
+        case FRU_TLV_U8:
+            *(char *) field = value[0];
+            break;
+
+        case FRU_TLV_U16:
+            *(uint16_t *) field = (uint16_t) ((value[0] << 8) | value[1]);
+            break;
+
+        case FRU_TLV_MAC:
+            memcpy(field, value, FRU_BASE_MAC_ADDRESS_LEN);
+            break;
+
+        case FRU_TLV_VENDOR_EXT:
+            /* 4 byte big-endian IANA enterprise number, then the payload. */
+            ext = &fru_eeprom->vendor_exts[fru_eeprom->n_vendor_exts++];
+            ext->iana = ((uint32_t) value[0] << 24 | (uint32_t) value[1] << 16 |
+                         (uint32_t) value[2] << 8 | (uint32_t) value[3]);
+            ext->len = len - FRU_VENDOR_EXT_IANA_LEN;
+            data = fru_arena_alloc(arena, ext->len);
+            memcpy(data, value + FRU_VENDOR_EXT_IANA_LEN, ext->len);
+            ext->data = data;
+            break;
+
+        case FRU_TLV_CRC:
+            /* Checked by sysd_process_eeprom() in the first pass. */
+            break;
+    }
+
+} /* fru_decode_tlv */
+
 bool
 sysd_process_eeprom(unsigned char *buf, fru_eeprom_t *fru_eeprom, int len)
 {
-    int                 idx = 0;
-    int                 skip;
-    int                 tlv_len = 0;
-    int                 crc_len;
-    unsigned char       *bp;
-    char                *tlv_value = NULL;
-    unsigned char       *tlv_value_n = NULL;
-    unsigned int        chksum;
-    unsigned int        found_crc;
-    fru_tlv_t           *fru_tlv;
+    int                         idx;
+    int                         tlv_len;
+    size_t                      crc_len;
+    size_t                      arena_len = 0;
+    size_t                      n_exts = 0;
+    unsigned char               *bp;
+    unsigned int                chksum;
+    unsigned int                found_crc;
+    const fru_tlv_t             *fru_tlv;
+    const fru_tlv_decoder_t     *decoder;
+    fru_arena_t                 arena;
 
     bp = buf;
 
     /* Skip the FRU header. */
     buf += sizeof(fru_header_t);
 
-    while (idx < len) {
-        fru_tlv = (fru_tlv_t *) buf;
-        tlv_value = (char *) fru_tlv->value;
-        tlv_len = (unsigned int) fru_tlv->length;
+    /* First pass: validate every TLV and size the arena. */
+    for (idx = 0; idx < len; idx += tlv_len + 2) {
+        if (len - idx < 2) {
+            VLOG_ERR("Truncated FRU TLV at offset %d", idx);
+            return (false);
+        }
+
+        fru_tlv = (const fru_tlv_t *) (buf + idx);
+        tlv_len = fru_tlv->length;
+        if (tlv_len > len - idx - 2) {
+            VLOG_ERR("FRU TLV type 0x%x length %d overruns EEPROM length %d",
+                     fru_tlv->code, tlv_len, len);
+            return (false);
+        }
+
+        decoder = fru_tlv_decoder_find(fru_tlv->code);
+        if (decoder == NULL) {
+            VLOG_ERR("Illegal FRU TLV type 0x%x", fru_tlv->code);
+            return (false);
+        }
+        /* Fixed size character fields are truncated rather than
+         * rejected, everything else must have a sane length. */
+        if (tlv_len < decoder->min_len
+            || (tlv_len > decoder->max_len && decoder->kind != FRU_TLV_CHARS)) {
+            VLOG_ERR("Invalid length %d for FRU TLV type 0x%x",
+                     tlv_len, fru_tlv->code);
+            return (false);
+        }
 
-        switch(fru_tlv->code) {
-            case FRU_PRODUCT_NAME_TYPE:
-                SYSD_MALLOC(fru_eeprom->product_name, tlv_len + 1);
-                strncpy(fru_eeprom->product_name, tlv_value, tlv_len);
-                fru_eeprom->product_name[tlv_len] = '\0';
+        switch (decoder->kind) {
+            case FRU_TLV_STRING:
+                arena_len += tlv_len + 1;
                 break;
 
-            case FRU_PART_NUMBER_TYPE:
-                SYSD_MALLOC(fru_eeprom->part_number, tlv_len + 1);
-                strncpy(fru_eeprom->part_number, tlv_value, tlv_len);
-                fru_eeprom->part_number[tlv_len] = '\0';
+            case FRU_TLV_VENDOR_EXT:
+                arena_len += tlv_len - FRU_VENDOR_EXT_IANA_LEN;
+                n_exts++;
                 break;
 
-            case FRU_SERIAL_NUMBER_TYPE:
-                SYSD_MALLOC(fru_eeprom->serial_number, tlv_len + 1);
-                strncpy(fru_eeprom->serial_number, tlv_value, tlv_len);
-                fru_eeprom->serial_number[tlv_len] = '\0';
+            case FRU_TLV_CRC:
+                /* CRC-32 over everything up to and including the CRC
+                 * TLV's type and length bytes. */
+                crc_len = sizeof(fru_header_t) + idx + 2;
+                chksum = calc_crc(bp, crc_len);
+                VLOG_DBG("calculated crc is 0x%04x", chksum);
+                found_crc = ((unsigned int) (fru_tlv->value[0] & 0xff) << 24 |
+                             (fru_tlv->value[1] & 0xff) << 16 |
+                             (fru_tlv->value[2] & 0xff) << 8 |
+                             (fru_tlv->value[3] & 0xff));
+                if (chksum != found_crc) {
+                    VLOG_ERR("Invalid CRC: found 0x%04x calculated 0x%04x", found_crc, chksum);
+                    return (false);
+                }
                 break;
 
-            case FRU_NUM_MAC_TYPE:
-                /* Two byte big-endian uint */
-                tlv_value_n = (unsigned char*)tlv_value;
-                fru_eeprom->num_macs = (uint16_t) ((tlv_value_n[0] << 8) | (tlv_value_n[1]));
+            default:
                 break;
+        }
+    }
 
-            case FRU_BASE_MAC_ADDRESS_TYPE:
-                bcopy(tlv_value, fru_eeprom->base_mac_address, FRU_BASE_MAC_ADDRESS_LEN);
+    /* Second pass: decode into the arena. */
+    fru_arena_init(&arena, fru_eeprom, n_exts, arena_len);
+    for (idx = 0; idx < len; idx += tlv_len + 2) {
+        fru_tlv = (const fru_tlv_t *) (buf + idx);
+        tlv_len = fru_tlv->length;
+        fru_decode_tlv(fru_tlv_decoder_find(fru_tlv->code), fru_tlv,
+                       fru_eeprom, &arena);
+    }
+
+    return (true);
+} /* sysd_process_eeprom() */
+
+/*
+ * Persistent cache of the decoded FRU EEPROM.
+ *
+ * The cache file is keyed by the raw OCP header and the raw CRC TLV of the
+ * EEPROM it was built from. Since the CRC covers the whole EEPROM image, a
+ * matching header and CRC TLV means the cached fields can be reused without
+ * reading (and decoding) the rest of the EEPROM over I2C.
+ */
+#define FRU_CACHE_VERSION           2
+
+static struct json *
+fru_cache_hex_create(const unsigned char *buf, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    char    *str = xmalloc(2 * len + 1);
+    size_t  i;
+
+    for (i = 0; i < len; i++) {
+        str[2 * i] = hex[buf[i] >> 4];
+        str[2 * i + 1] = hex[buf[i] & 0xf];
+    }
+    str[2 * len] = '\0';
+
+    return json_string_create_nocopy(str);
+
+} /* fru_cache_hex_create */
+
+static bool
+fru_cache_hex_equals(const struct json *json, const unsigned char *buf,
+                     size_t len)
+{
+    struct json *expected;
+    bool        equal;
+
+    if (!json || json->type != JSON_STRING) {
+        return false;
+    }
+
+    expected = fru_cache_hex_create(buf, len);
+    equal = !strcmp(json_string(json), json_string(expected));
+    json_destroy(expected);
+
+    return equal;
+
+} /* fru_cache_hex_equals */
+
+static bool
+fru_cache_hex_parse(const struct json *json, unsigned char *buf, size_t len)
+{
+    const char      *str;
+    unsigned int    byte;
+    size_t          i;
+
+    if (!json || json->type != JSON_STRING) {
+        return false;
+    }
+
+    str = json_string(json);
+    if (strlen(str) != 2 * len) {
+        return false;
+    }
+
+    for (i = 0; i < len; i++) {
+        if (sscanf(&str[2 * i], "%2x", &byte) != 1) {
+            return false;
+        }
+        buf[i] = (unsigned char) byte;
+    }
+
+    return true;
+
+} /* fru_cache_hex_parse */
+
+/* Location of the FRU cache, overridable with --fru-cache. */
+static const char *fru_cache_file = FRU_CACHE_FILE_PATH;
+
+void
+sysd_fru_set_cache_file(const char *path)
+{
+    fru_cache_file = path;
+
+} /* sysd_fru_set_cache_file */
+
+/* Returns the decoded FRU fields as a JSON object keyed by field name, as
+ * stored in the FRU cache and shown by ops-sysd/dump. */
+struct json *
+sysd_fru_to_json(const fru_eeprom_t *fru_eeprom)
+{
+    struct json *fields;
+    size_t      i;
+
+    fields = json_object_create();
+    for (i = 0; i < ARRAY_SIZE(fru_tlv_decoders); i++) {
+        const fru_tlv_decoder_t *decoder = &fru_tlv_decoders[i];
+        const void *field = FRU_TLV_FIELD_PTR(fru_eeprom, decoder);
+        struct json *exts;
+        int j;
+
+        switch (decoder->kind) {
+            case FRU_TLV_STRING:
+                if (*(char * const *) field) {
+                    json_object_put_string(fields, decoder->name,
+                                           *(char * const *) field);
+                }
                 break;
 
-            case FRU_MANUFACTURE_DATE_TYPE:
-                strncpy(fru_eeprom->manufacture_date, tlv_value, tlv_len + 1);
-                fru_eeprom->manufacture_date[tlv_len] = '\0';
+            case FRU_TLV_CHARS:
+                json_object_put_string(fields, decoder->name, field);
                 break;
 
-            case FRU_DEVICE_VERSION_TYPE:
-                fru_eeprom->device_version = tlv_value[0];
+            case FRU_TLV_U8:
+                json_object_put(fields, decoder->name,
+                                json_integer_create(*(const char *) field));
                 break;
 
-            case FRU_LABEL_REVISION_TYPE:
-                SYSD_MALLOC(fru_eeprom->label_revision, tlv_len + 1);
-                strncpy(fru_eeprom->label_revision, tlv_value, tlv_len);
-                fru_eeprom->label_revision[tlv_len] = '\0';
+            case FRU_TLV_U16:
+                json_object_put(fields, decoder->name,
+                                json_integer_create(*(const uint16_t *) field));
                 break;
 
-            case FRU_PLATFORM_NAME_TYPE:
-                SYSD_MALLOC(fru_eeprom->platform_name, tlv_len + 1);
-                strncpy(fru_eeprom->platform_name, tlv_value, tlv_len);
-                fru_eeprom->platform_name[tlv_len] = '\0';
+            case FRU_TLV_MAC:
+                json_object_put(fields, decoder->name,
+                                fru_cache_hex_create(field,
+                                                     FRU_BASE_MAC_ADDRESS_LEN));
                 break;
 
-            case FRU_ONIE_VERSION_TYPE:
-                SYSD_MALLOC(fru_eeprom->onie_version, tlv_len + 1);
-                strncpy(fru_eeprom->onie_version, tlv_value, tlv_len);
-                fru_eeprom->onie_version[tlv_len] = '\0';
+            case FRU_TLV_VENDOR_EXT:
+                exts = json_array_create_empty();
+                for (j = 0; j < fru_eeprom->n_vendor_exts; j++) {
+                    const fru_vendor_ext_t *ext = &fru_eeprom->vendor_exts[j];
+                    struct json *obj = json_object_create();
+
+                    json_object_put(obj, "iana", json_integer_create(ext->iana));
+                    json_object_put(obj, "data",
+                                    fru_cache_hex_create(ext->data, ext->len));
+                    json_array_add(exts, obj);
+                }
+                json_object_put(fields, decoder->name, exts);
                 break;
 
-            case FRU_MANUFACTURER_TYPE:
-                SYSD_MALLOC(fru_eeprom->manufacturer, tlv_len + 1);
-                strncpy(fru_eeprom->manufacturer, tlv_value, tlv_len);
-                fru_eeprom->manufacturer[tlv_len] = '\0';
+            case FRU_TLV_CRC:
                 break;
+        }
+    }
 
-            case FRU_COUNTRY_CODE_TYPE:
-                strncpy(fru_eeprom->country_code, tlv_value, tlv_len + 1);
-                fru_eeprom->country_code[tlv_len] = '\0';
+    return fields;
+
+} /* sysd_fru_to_json */
+
+static void
+sysd_fru_cache_save(const fru_header_t *header, const unsigned char *crc_tlv,
+                    const fru_eeprom_t *fru_eeprom)
+{
+    char        *cache_dir;
+    char        *tmp_file;
+    char        *slash;
+    char        *str;
+    FILE        *fp;
+    struct json *cache;
+    struct json *fields;
+
+    fields = sysd_fru_to_json(fru_eeprom);
+
+    cache = json_object_create();
+    json_object_put(cache, "version", json_integer_create(FRU_CACHE_VERSION));
+    json_object_put(cache, "header",
+                    fru_cache_hex_create((const unsigned char *) header,
+                                         sizeof(*header)));
+    json_object_put(cache, "crc", fru_cache_hex_create(crc_tlv, FRU_CRC_LEN));
+    json_object_put(cache, "fru", fields);
+
+    str = json_to_string(cache, 0);
+    json_destroy(cache);
+
+    /* Make sure the cache directory exists. */
+    cache_dir = xstrdup(fru_cache_file);
+    slash = strrchr(cache_dir, '/');
+    if (slash && slash != cache_dir) {
+        *slash = '\0';
+        if (mkdir(cache_dir, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH)
+            && errno != EEXIST) {
+            VLOG_WARN("Unable to create FRU cache directory %s. Error %s",
+                      cache_dir, ovs_strerror(errno));
+            free(cache_dir);
+            free(str);
+            return;
+        }
+    }
+    free(cache_dir);
+
+    /* Write to a temporary file first so a crash never leaves a
+     * truncated cache behind. */
+    tmp_file = xasprintf("%s.tmp", fru_cache_file);
+    fp = fopen(tmp_file, "w");
+    if (fp == NULL) {
+        VLOG_WARN("Unable to write FRU cache %s. Error %s",
+                  fru_cache_file, ovs_strerror(errno));
+        free(tmp_file);
+        free(str);
+        return;
+    }
+    fputs(str, fp);
+    free(str);
+
+    if (fclose(fp) || rename(tmp_file, fru_cache_file)) {
+        VLOG_WARN("Unable to write FRU cache %s. Error %s",
+                  fru_cache_file, ovs_strerror(errno));
+        remove(tmp_file);
+        free(tmp_file);
+        return;
+    }
+    free(tmp_file);
+
+    VLOG_DBG("FRU cache written to %s", fru_cache_file);
+
+} /* sysd_fru_cache_save */
+
+static bool
+sysd_fru_cache_load(const fru_header_t *header, const unsigned char *crc_tlv,
+                    fru_eeprom_t *fru_eeprom)
+{
+    bool                rc = false;
+    size_t              i;
+    size_t              j;
+    size_t              arena_len = 0;
+    size_t              n_exts = 0;
+    struct json         *cache;
+    struct json         *value;
+    struct json         *ext;
+    struct json         *data;
+    struct json_array   *exts;
+    struct shash        *object;
+    struct shash        *fields;
+    fru_arena_t         arena;
+
+    cache = json_from_file(fru_cache_file);
+    if (cache == NULL) {
+        return false;
+    }
+    if (cache->type != JSON_OBJECT) {
+        /* Missing or unparsable cache, json_from_file() returns the
+         * error as a string. */
+        VLOG_DBG("No usable FRU cache at %s", fru_cache_file);
+        goto out;
+    }
+
+    object = json_object(cache);
+    value = shash_find_data(object, "version");
+    if (!value || value->type != JSON_INTEGER
+        || json_integer(value) != FRU_CACHE_VERSION) {
+        goto out;
+    }
+
+    if (!fru_cache_hex_equals(shash_find_data(object, "header"),
+                              (const unsigned char *) header, sizeof(*header))
+        || !fru_cache_hex_equals(shash_find_data(object, "crc"),
+                                 crc_tlv, FRU_CRC_LEN)) {
+        VLOG_INFO("FRU EEPROM changed, ignoring FRU cache");
+        goto out;
+    }
+
+    value = shash_find_data(object, "fru");
+    if (!value || value->type != JSON_OBJECT) {
+        goto out;
+    }
+    fields = json_object(value);
+
+    /* Size the arena the same way sysd_process_eeprom() does. */
+    for (i = 0; i < ARRAY_SIZE(fru_tlv_decoders); i++) {
+        const fru_tlv_decoder_t *decoder = &fru_tlv_decoders[i];
+
+        value = shash_find_data(fields, decoder->name);
+        if (decoder->kind == FRU_TLV_STRING
+            && value && value->type == JSON_STRING) {
+            arena_len += strlen(json_string(value)) + 1;
+        } else if (decoder->kind == FRU_TLV_VENDOR_EXT) {
+            if (!value || value->type != JSON_ARRAY) {
+                goto out;
+            }
+            exts = json_array(value);
+            for (j = 0; j < exts->n; j++) {
+                ext = exts->elems[j];
+                if (ext->type != JSON_OBJECT) {
+                    goto out;
+                }
+                data = shash_find_data(json_object(ext), "data");
+                if (!data || data->type != JSON_STRING
+                    || strlen(json_string(data)) > 2 * UINT8_MAX) {
+                    goto out;
+                }
+                arena_len += strlen(json_string(data)) / 2;
+            }
+            n_exts += exts->n;
+        }
+    }
+
+    memset(fru_eeprom, 0, sizeof(*fru_eeprom));
+    fru_arena_init(&arena, fru_eeprom, n_exts, arena_len);
+
+    for (i = 0; i < ARRAY_SIZE(fru_tlv_decoders); i++) {
+        const fru_tlv_decoder_t *decoder = &fru_tlv_decoders[i];
+        void *field = FRU_TLV_FIELD_PTR(fru_eeprom, decoder);
+
+        value = shash_find_data(fields, decoder->name);
+        if (!value) {
+            continue;
+        }
+
+        switch (decoder->kind) {
+            case FRU_TLV_STRING:
+                if (value->type == JSON_STRING) {
+                    *(char **) field = fru_arena_strndup(&arena,
+                                                         json_string(value),
+                                                         strlen(json_string(value)));
+                }
                 break;
 
-            case FRU_VENDOR_TYPE:
-                SYSD_MALLOC(fru_eeprom->vendor, tlv_len + 1);
-                strncpy(fru_eeprom->vendor, tlv_value, tlv_len);
-                fru_eeprom->vendor[tlv_len] = '\0';
+            case FRU_TLV_CHARS:
+                if (value->type == JSON_STRING) {
+                    strncpy(field, json_string(value), decoder->max_len);
+                    ((char *) field)[decoder->max_len] = '\0';
+                }
                 break;
 
-            case FRU_DIAG_VERSION_TYPE:
-                SYSD_MALLOC(fru_eeprom->diag_version, tlv_len + 1);
-                strncpy(fru_eeprom->diag_version, tlv_value, tlv_len);
-                fru_eeprom->diag_version[tlv_len] = '\0';
+            case FRU_TLV_U8:
+                if (value->type == JSON_INTEGER) {
+                    *(char *) field = (char) json_integer(value);
+                }
                 break;
 
-            case FRU_SERVICE_TAG_TYPE:
-                SYSD_MALLOC(fru_eeprom->service_tag, tlv_len + 1);
-                strncpy(fru_eeprom->service_tag, tlv_value, tlv_len);
-                fru_eeprom->service_tag[tlv_len] = '\0';
+            case FRU_TLV_U16:
+                if (value->type == JSON_INTEGER) {
+                    *(uint16_t *) field = (uint16_t) json_integer(value);
+                }
                 break;
 
-            case FRU_VENDOR_EXTENSION_TYPE:
-                /* OPS_TODO: Currently vendor specific extension TLVs
-                 *           are not supported. Ignore them. */
+            case FRU_TLV_MAC:
+                if (!fru_cache_hex_parse(value, field,
+                                         FRU_BASE_MAC_ADDRESS_LEN)) {
+                    goto fail;
+                }
                 break;
 
-            case FRU_CRC_TYPE:
-                /* CRC-32 */
-                crc_len = len + sizeof(fru_header_t) - tlv_len;
-                chksum = calc_crc(bp, crc_len);
-                VLOG_DBG("calculated crc is 0x%04x", chksum);
-                found_crc = ((fru_tlv->value[0] & 0xff) << 24 |
-                             (fru_tlv->value[1] & 0xff) << 16 |
-                             (fru_tlv->value[2] & 0xff) << 8 |
-                             (fru_tlv->value[3] & 0xff));
-                if (chksum != found_crc) {
-                    VLOG_ERR("Invalid CRC: found 0x%04x calculated 0x%04x", found_crc, chksum);
-                    return (false);
+            case FRU_TLV_VENDOR_EXT:
+                exts = json_array(value);
+                for (j = 0; j < exts->n; j++) {
+                    fru_vendor_ext_t *vext;
+                    unsigned char *payload;
+
+                    ext = exts->elems[j];
+                    data = shash_find_data(json_object(ext), "data");
+                    value = shash_find_data(json_object(ext), "iana");
+                    if (!value || value->type != JSON_INTEGER) {
+                        goto fail;
+                    }
+
+                    vext = &fru_eeprom->vendor_exts[fru_eeprom->n_vendor_exts++];
+                    vext->iana = (uint32_t) json_integer(value);
+                    vext->len = strlen(json_string(data)) / 2;
+                    payload = fru_arena_alloc(&arena, vext->len);
+                    if (!fru_cache_hex_parse(data, payload, vext->len)) {
+                        goto fail;
+                    }
+                    vext->data = payload;
                 }
                 break;
 
-            case 0x00:
-            case 0xff:
-            default:
-                VLOG_ERR("Illegal FRU TLV type 0x%x", fru_tlv->code);
-                return (false);
+            case FRU_TLV_CRC:
                 break;
         }
-
-        skip = fru_tlv->length+sizeof(fru_tlv->length)+sizeof(fru_tlv->code);
-        idx += skip;
-        buf += skip;
     }
 
-    return (true);
-} /* sysd_process_eeprom() */
+    rc = true;
 
-int
-sysd_read_fru_eeprom(fru_eeprom_t *fru_eeprom)
+out:
+    json_destroy(cache);
+    return rc;
+
+fail:
+    free(fru_eeprom->arena);
+    memset(fru_eeprom, 0, sizeof(*fru_eeprom));
+    goto out;
+
+} /* sysd_fru_cache_load */
+
+static int
+sysd_read_fru_eeprom_xport(struct sysd_fru_xport *xport, fru_eeprom_t *fru_eeprom)
 {
     bool            rc;
     unsigned char   *buf;
-    size_t             len;
+    size_t          len;
     uint16_t        total_len;
+    int             crc_offset;
     fru_header_t    header;
-
-    if (fru_yaml) {
-        /* Populate fru from yaml file */
-        rc = sysd_cfg_yaml_get_fru_info(fru_eeprom);
-        if (0 > rc) {
-            VLOG_ERR("Error getting yaml fru info. rc = %d.", rc);
-            return -1;
-        }
-        VLOG_INFO("Retrieved fru info from fru.yaml");
-        return 0;
-    }
-
-    VLOG_INFO("Getting fru info from EEPROM");
+    unsigned char   crc_tlv[FRU_CRC_LEN];
 
     /* Read header info */
-    rc = sysd_cfg_yaml_fru_read((unsigned char *) &header, sizeof(header));
+    rc = sysd_fru_xport_read(xport, 0, &header, sizeof(header));
     if (!rc) {
         VLOG_ERR("Error reading FRU EEPROM Header");
         log_event("SYS_FRU_EEPROM_HEADER_READ_FAILURE", NULL);
@@ -231,15 +743,27 @@ sysd_read_fru_eeprom(fru_eeprom_t *fru_eeprom)
     total_len = (header.total_length[0] << 8) | (header.total_length[1]);
     VLOG_DBG("total_length is %d", total_len);
 
+    /* The CRC TLV is always the last TLV. Read just that and compare it,
+     * along with the header, against the cached FRU info. */
+    crc_offset = sizeof(fru_header_t) + total_len - FRU_CRC_LEN;
+    if (total_len >= FRU_CRC_LEN
+        && sysd_fru_xport_read(xport, crc_offset, crc_tlv, sizeof(crc_tlv))
+        && crc_tlv[0] == FRU_CRC_TYPE
+        && crc_tlv[1] == FRU_CRC_LEN - 2
+        && sysd_fru_cache_load(&header, crc_tlv, fru_eeprom)) {
+        VLOG_INFO("Retrieved fru info from %s", fru_cache_file);
+        return 0;
+    }
+
     /* Using length from header, read remainder of FRU EEPROM */
-    len = total_len + sizeof(fru_header_t) + 1;
-    buf = (unsigned char *) calloc(1, len);
+    len = total_len + sizeof(fru_header_t);
+    buf = (unsigned char *) calloc(1, len + 1);
     if ((unsigned char *)NULL == buf) {
         VLOG_ERR("Unable to allocate memory for eeprom read");
         return -1;
     }
 
-    rc = sysd_cfg_yaml_fru_read(buf, (int)len);
+    rc = sysd_fru_xport_read(xport, 0, buf, len);
     if (!rc) {
         VLOG_ERR("Error reading FRU EEPROM");
         free(buf);
@@ -253,8 +777,71 @@ sysd_read_fru_eeprom(fru_eeprom_t *fru_eeprom)
         free(buf);
         return -1;
     }
+
+    /* sysd_process_eeprom() validated the CRC, so the image is good
+     * enough to cache. */
+    if (total_len >= FRU_CRC_LEN && buf[crc_offset] == FRU_CRC_TYPE) {
+        sysd_fru_cache_save(&header, buf + crc_offset, fru_eeprom);
+    }
     free(buf);
 
     return 0;
+} /* sysd_read_fru_eeprom_xport() */
+
+/* FRU EEPROM read ahead of sysd_read_fru_eeprom() on a bus worker, see
+ * sysd_bus_init_devices(). Only touched by the worker until it is joined. */
+static bool         fru_prefetched = false;
+static fru_eeprom_t fru_prefetch;
+
+static int
+sysd_read_fru_eeprom_dev(fru_eeprom_t *fru_eeprom)
+{
+    int                     rc;
+    long long               start;
+    struct sysd_fru_xport   *xport;
+
+    start = time_msec();
+    xport = sysd_fru_xport_open(g_hw_desc_dir, FRU_EEPROM_DEVICE_NAME);
+    rc = sysd_read_fru_eeprom_xport(xport, fru_eeprom);
+    sysd_metrics_fru_read(xport->bytes_read, time_msec() - start);
+    sysd_fru_xport_close(xport);
+
+    return rc;
+} /* sysd_read_fru_eeprom_dev() */
+
+void
+sysd_fru_prefetch(void)
+{
+    VLOG_INFO("Getting fru info from EEPROM");
+
+    memset(&fru_prefetch, 0, sizeof(fru_prefetch));
+    fru_prefetched = !sysd_read_fru_eeprom_dev(&fru_prefetch);
+} /* sysd_fru_prefetch() */
+
+int
+sysd_read_fru_eeprom(fru_eeprom_t *fru_eeprom)
+{
+    int                     rc;
+
+    if (fru_yaml) {
+        /* Populate fru from yaml file */
+        rc = sysd_cfg_yaml_get_fru_info(fru_eeprom);
+        if (0 > rc) {
+            VLOG_ERR("Error getting yaml fru info. rc = %d.", rc);
+            return -1;
+        }
+        VLOG_INFO("Retrieved fru info from fru.yaml");
+        return 0;
+    }
+
+    if (fru_prefetched) {
+        *fru_eeprom = fru_prefetch;
+        fru_prefetched = false;
+        return 0;
+    }
+
+    VLOG_INFO("Getting fru info from EEPROM");
+
+    return sysd_read_fru_eeprom_dev(fru_eeprom);
 } /* sysd_read_fru_eeprom() */
 /** @} end of group sysd */
@@ -0,0 +1,457 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup sysd
+ *
+ * @file
+ * Source for sysd FRU EEPROM transports.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include <openvswitch/vlog.h>
+#include <smap.h>
+#include <util.h>
+
+#include <config-yaml.h>
+#include "sysd_cfg_yaml.h"
+#include "sysd_fru_xport.h"
+
+VLOG_DEFINE_THIS_MODULE(fru_xport);
+
+/** @ingroup sysd
+ * @{ */
+
+#define SYSFS_I2C_DEVICES_PATH  "/sys/bus/i2c/devices"
+
+/*
+ * config_yaml transport: config-yaml's i2c_data_read().
+ */
+static struct sysd_fru_xport *
+fru_xport_cfg_yaml_open(const struct smap *dev_cfg OVS_UNUSED,
+                        const struct smap *bus_cfg OVS_UNUSED)
+{
+    return xzalloc(sizeof(struct sysd_fru_xport));
+
+} /* fru_xport_cfg_yaml_open */
+
+static bool
+fru_xport_cfg_yaml_read(struct sysd_fru_xport *xport OVS_UNUSED,
+                        size_t offset, void *buf, size_t len)
+{
+    return sysd_cfg_yaml_fru_read_at(buf, (int) offset, (int) len);
+
+} /* fru_xport_cfg_yaml_read */
+
+static void
+fru_xport_cfg_yaml_close(struct sysd_fru_xport *xport)
+{
+    free(xport);
+
+} /* fru_xport_cfg_yaml_close */
+
+static const struct sysd_fru_xport_class fru_xport_cfg_yaml_class = {
+    "config_yaml",
+    fru_xport_cfg_yaml_open,
+    fru_xport_cfg_yaml_read,
+    fru_xport_cfg_yaml_close,
+};
+
+/*
+ * fd based transports: at24 sysfs 'eeprom' attribute and plain files.
+ * Both hand back the requested range with a single pread().
+ */
+struct fru_xport_fd {
+    struct sysd_fru_xport   up;
+    int                     fd;
+    char                    *path;
+};
+
+static struct fru_xport_fd *
+fru_xport_fd_cast(struct sysd_fru_xport *xport)
+{
+    return CONTAINER_OF(xport, struct fru_xport_fd, up);
+
+} /* fru_xport_fd_cast */
+
+static struct sysd_fru_xport *
+fru_xport_fd_create(char *path)
+{
+    struct fru_xport_fd *fd_xport;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        VLOG_ERR("Unable to open FRU EEPROM %s. Error %s",
+                 path, ovs_strerror(errno));
+        free(path);
+        return NULL;
+    }
+
+    fd_xport = xzalloc(sizeof *fd_xport);
+    fd_xport->fd = fd;
+    fd_xport->path = path;
+
+    return &fd_xport->up;
+
+} /* fru_xport_fd_create */
+
+static bool
+fru_xport_fd_read(struct sysd_fru_xport *xport, size_t offset, void *buf,
+                  size_t len)
+{
+    struct fru_xport_fd *fd_xport = fru_xport_fd_cast(xport);
+    size_t done = 0;
+
+    while (done < len) {
+        ssize_t n = pread(fd_xport->fd, (char *) buf + done, len - done,
+                          offset + done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            VLOG_ERR("Failed to read %"PRIuSIZE" bytes at offset %"PRIuSIZE
+                     " from %s. Error %s", len, offset, fd_xport->path,
+                     n ? ovs_strerror(errno) : "end of file");
+            return false;
+        }
+        done += n;
+    }
+
+    return true;
+
+} /* fru_xport_fd_read */
+
+static void
+fru_xport_fd_close(struct sysd_fru_xport *xport)
+{
+    struct fru_xport_fd *fd_xport = fru_xport_fd_cast(xport);
+
+    close(fd_xport->fd);
+    free(fd_xport->path);
+    free(fd_xport);
+
+} /* fru_xport_fd_close */
+
+static struct sysd_fru_xport *
+fru_xport_file_open(const struct smap *dev_cfg,
+                    const struct smap *bus_cfg OVS_UNUSED)
+{
+    const char *path = smap_get(dev_cfg, FRU_XPORT_PATH_KEY);
+
+    if (path == NULL) {
+        VLOG_ERR("FRU transport 'file' requires '%s'", FRU_XPORT_PATH_KEY);
+        return NULL;
+    }
+
+    return fru_xport_fd_create(xstrdup(path));
+
+} /* fru_xport_file_open */
+
+/* Returns the adapter number of an i2c-dev node such as /dev/i2c-3. */
+static int
+fru_xport_i2c_adapter(const struct smap *bus_cfg)
+{
+    const char *dev_name = smap_get(bus_cfg, "dev_name");
+    const char *p;
+
+    if (dev_name == NULL || (p = strrchr(dev_name, '-')) == NULL) {
+        return -1;
+    }
+
+    return atoi(p + 1);
+
+} /* fru_xport_i2c_adapter */
+
+static struct sysd_fru_xport *
+fru_xport_sysfs_open(const struct smap *dev_cfg, const struct smap *bus_cfg)
+{
+    const char *path = smap_get(dev_cfg, FRU_XPORT_PATH_KEY);
+    const char *address = smap_get(dev_cfg, "address");
+    int adapter;
+
+    if (path != NULL) {
+        return fru_xport_fd_create(xstrdup(path));
+    }
+
+    /* Derive the at24 attribute path from the bus and device address. */
+    adapter = fru_xport_i2c_adapter(bus_cfg);
+    if (adapter < 0 || address == NULL) {
+        VLOG_ERR("FRU transport 'sysfs' requires '%s' or a bus 'dev_name' "
+                 "and device 'address'", FRU_XPORT_PATH_KEY);
+        return NULL;
+    }
+
+    return fru_xport_fd_create(xasprintf("%s/%d-%04lx/eeprom",
+                                         SYSFS_I2C_DEVICES_PATH, adapter,
+                                         strtoul(address, NULL, 0)));
+
+} /* fru_xport_sysfs_open */
+
+static const struct sysd_fru_xport_class fru_xport_sysfs_class = {
+    "sysfs",
+    fru_xport_sysfs_open,
+    fru_xport_fd_read,
+    fru_xport_fd_close,
+};
+
+static const struct sysd_fru_xport_class fru_xport_file_class = {
+    "file",
+    fru_xport_file_open,
+    fru_xport_fd_read,
+    fru_xport_fd_close,
+};
+
+/*
+ * i2c_dev transport: I2C_RDWR combined write-offset/read transfers,
+ * chunked to the adapter's maximum message size.
+ */
+struct fru_xport_i2c_dev {
+    struct sysd_fru_xport   up;
+    int                     fd;
+    uint16_t                address;
+    size_t                  max_xfer;
+    int                     offset_width;
+};
+
+static struct fru_xport_i2c_dev *
+fru_xport_i2c_dev_cast(struct sysd_fru_xport *xport)
+{
+    return CONTAINER_OF(xport, struct fru_xport_i2c_dev, up);
+
+} /* fru_xport_i2c_dev_cast */
+
+static struct sysd_fru_xport *
+fru_xport_i2c_dev_open(const struct smap *dev_cfg, const struct smap *bus_cfg)
+{
+    struct fru_xport_i2c_dev *i2c_xport;
+    const char *dev_name = smap_get(bus_cfg, "dev_name");
+    const char *address = smap_get(dev_cfg, "address");
+    unsigned long funcs = 0;
+    int max_xfer;
+    int offset_width;
+    int fd;
+
+    if (dev_name == NULL || address == NULL) {
+        VLOG_ERR("FRU transport 'i2c_dev' requires a bus 'dev_name' "
+                 "and device 'address'");
+        return NULL;
+    }
+
+    max_xfer = smap_get_int(dev_cfg, FRU_XPORT_MAX_XFER_KEY,
+                            FRU_XPORT_DFLT_MAX_XFER);
+    offset_width = smap_get_int(dev_cfg, FRU_XPORT_OFFSET_WIDTH_KEY, 1);
+    if (max_xfer <= 0 || max_xfer > UINT16_MAX
+        || (offset_width != 1 && offset_width != 2)) {
+        VLOG_ERR("Invalid '%s' or '%s' for FRU transport 'i2c_dev'",
+                 FRU_XPORT_MAX_XFER_KEY, FRU_XPORT_OFFSET_WIDTH_KEY);
+        return NULL;
+    }
+
+    fd = open(dev_name, O_RDWR);
+    if (fd < 0) {
+        VLOG_ERR("Unable to open %s. Error %s", dev_name, ovs_strerror(errno));
+        return NULL;
+    }
+
+    /* SMBus-only adapters do not implement I2C_RDWR. */
+    if (ioctl(fd, I2C_FUNCS, &funcs) < 0 || !(funcs & I2C_FUNC_I2C)) {
+        VLOG_ERR("Adapter %s does not support I2C_RDWR transfers", dev_name);
+        close(fd);
+        return NULL;
+    }
+
+    i2c_xport = xzalloc(sizeof *i2c_xport);
+    i2c_xport->fd = fd;
+    i2c_xport->address = (uint16_t) strtoul(address, NULL, 0);
+    i2c_xport->max_xfer = max_xfer;
+    i2c_xport->offset_width = offset_width;
+
+    return &i2c_xport->up;
+
+} /* fru_xport_i2c_dev_open */
+
+static bool
+fru_xport_i2c_dev_read(struct sysd_fru_xport *xport, size_t offset, void *buf,
+                       size_t len)
+{
+    struct fru_xport_i2c_dev *i2c_xport = fru_xport_i2c_dev_cast(xport);
+    size_t limit = (size_t) 1 << (8 * i2c_xport->offset_width);
+    size_t done = 0;
+
+    /* The offset would wrap around and read the start of the EEPROM. */
+    if (offset > limit || len > limit - offset) {
+        VLOG_ERR("Read of %"PRIuSIZE" bytes at offset %"PRIuSIZE" from 0x%02x "
+                 "is past the %d-byte '%s' range",
+                 len, offset, i2c_xport->address, i2c_xport->offset_width,
+                 FRU_XPORT_OFFSET_WIDTH_KEY);
+        return false;
+    }
+
+    while (done < len) {
+        size_t chunk = MIN(len - done, i2c_xport->max_xfer);
+        size_t cur = offset + done;
+        uint8_t offset_buf[2];
+        struct i2c_msg msgs[2];
+        struct i2c_rdwr_ioctl_data xfer;
+
+        if (i2c_xport->offset_width == 2) {
+            offset_buf[0] = (cur >> 8) & 0xff;
+            offset_buf[1] = cur & 0xff;
+        } else {
+            offset_buf[0] = cur & 0xff;
+        }
+
+        msgs[0].addr = i2c_xport->address;
+        msgs[0].flags = 0;
+        msgs[0].len = i2c_xport->offset_width;
+        msgs[0].buf = offset_buf;
+
+        msgs[1].addr = i2c_xport->address;
+        msgs[1].flags = I2C_M_RD;
+        msgs[1].len = chunk;
+        msgs[1].buf = (uint8_t *) buf + done;
+
+        xfer.msgs = msgs;
+        xfer.nmsgs = 2;
+
+        if (ioctl(i2c_xport->fd, I2C_RDWR, &xfer) < 0) {
+            VLOG_ERR("I2C_RDWR of %"PRIuSIZE" bytes at offset %"PRIuSIZE
+                     " from 0x%02x failed. Error %s", chunk, cur,
+                     i2c_xport->address, ovs_strerror(errno));
+            return false;
+        }
+        done += chunk;
+    }
+
+    return true;
+
+} /* fru_xport_i2c_dev_read */
+
+static void
+fru_xport_i2c_dev_close(struct sysd_fru_xport *xport)
+{
+    struct fru_xport_i2c_dev *i2c_xport = fru_xport_i2c_dev_cast(xport);
+
+    close(i2c_xport->fd);
+    free(i2c_xport);
+
+} /* fru_xport_i2c_dev_close */
+
+static const struct sysd_fru_xport_class fru_xport_i2c_dev_class = {
+    "i2c_dev",
+    fru_xport_i2c_dev_open,
+    fru_xport_i2c_dev_read,
+    fru_xport_i2c_dev_close,
+};
+
+static const struct sysd_fru_xport_class *fru_xport_classes[] = {
+    &fru_xport_cfg_yaml_class,
+    &fru_xport_sysfs_class,
+    &fru_xport_i2c_dev_class,
+    &fru_xport_file_class,
+};
+
+static const struct sysd_fru_xport_class *
+fru_xport_class_find(const char *name)
+{
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(fru_xport_classes); i++) {
+        if (!strcmp(fru_xport_classes[i]->name, name)) {
+            return fru_xport_classes[i];
+        }
+    }
+
+    return NULL;
+
+} /* fru_xport_class_find */
+
+/*
+ * Opens the transport configured for device 'dev_name' in the devices.yaml
+ * file under 'hw_desc_dir'. Falls back to config-yaml if the configured
+ * transport is unknown or cannot be opened.
+ */
+struct sysd_fru_xport *
+sysd_fru_xport_open(const char *hw_desc_dir, const char *dev_name)
+{
+    const struct sysd_fru_xport_class *class = &fru_xport_cfg_yaml_class;
+    struct sysd_fru_xport *xport = NULL;
+    struct smap dev_cfg = SMAP_INITIALIZER(&dev_cfg);
+    struct smap bus_cfg = SMAP_INITIALIZER(&bus_cfg);
+    const char *name;
+
+    if (sysd_cfg_yaml_get_device_cfg(hw_desc_dir, dev_name,
+                                     &dev_cfg, &bus_cfg)) {
+        name = smap_get(&dev_cfg, FRU_XPORT_KEY);
+        if (name != NULL) {
+            class = fru_xport_class_find(name);
+            if (class == NULL) {
+                VLOG_WARN("Unknown FRU transport '%s' for %s, using config_yaml",
+                          name, dev_name);
+                class = &fru_xport_cfg_yaml_class;
+            }
+        }
+    }
+
+    xport = class->open(&dev_cfg, &bus_cfg);
+    if (xport == NULL && class != &fru_xport_cfg_yaml_class) {
+        VLOG_WARN("Unable to use FRU transport '%s' for %s, using config_yaml",
+                  class->name, dev_name);
+        class = &fru_xport_cfg_yaml_class;
+        xport = class->open(&dev_cfg, &bus_cfg);
+    }
+    xport->class = class;
+
+    VLOG_INFO("Reading %s through the '%s' transport", dev_name, class->name);
+
+    smap_destroy(&dev_cfg);
+    smap_destroy(&bus_cfg);
+
+    return xport;
+
+} /* sysd_fru_xport_open */
+
+bool
+sysd_fru_xport_read(struct sysd_fru_xport *xport, size_t offset, void *buf,
+                    size_t len)
+{
+    if (!xport->class->read(xport, offset, buf, len)) {
+        return false;
+    }
+    xport->bytes_read += len;
+
+    return true;
+
+} /* sysd_fru_xport_read */
+
+void
+sysd_fru_xport_close(struct sysd_fru_xport *xport)
+{
+    if (xport) {
+        xport->class->close(xport);
+    }
+
+} /* sysd_fru_xport_close */
+/** @} end of group sysd */
@@ -0,0 +1,54 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup sysd
+ *
+ * @file
+ * Process-wide state of ops-sysd, kept apart from sysd.c so that the bench
+ * and fuzz targets, which do not link main(), share the same definitions.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <ovsdb-idl.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_util.h"
+
+/** @ingroup sysd
+ * @{ */
+
+/* OVSDB IDL used to obtain configuration. */
+struct ovsdb_idl *idl;
+uint32_t         idl_seqno = 0;
+int              num_subsystems = 0;
+sysd_subsystem_t **subsystems = NULL;
+
+struct sysd_arena sysd_state_arena =
+    SYSD_ARENA_INITIALIZER(SYSD_ARENA_CHUNK_SIZE);
+
+char *g_hw_desc_dir = "/";
+
+daemon_info_t **daemons = NULL;
+int num_daemons = 0;
+int num_hw_daemons = 0;
+
+/* Structure to store management info read */
+mgmt_intf_info_t *mgmt_intf = NULL;
+
+/** @} end of group sysd */
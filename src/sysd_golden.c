@@ -0,0 +1,695 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup sysd
+ *
+ * @file
+ * Source for the sysd initial configuration snapshot.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <bitmap.h>
+#include <json.h>
+#include <jsonrpc.h>
+#include <poll-loop.h>
+#include <sha1.h>
+#include <shash.h>
+#include <timeval.h>
+#include <util.h>
+#include <uuid.h>
+#include <ovsdb-data.h>
+#include <ovsdb-idl.h>
+#include <ovsdb-idl-provider.h>
+#include <vswitch-idl.h>
+#include <openvswitch/vlog.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_fru.h"
+#include "sysd_golden.h"
+#include "sysd_trace.h"
+#include "sysd_util.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_golden);
+
+/** @ingroup sysd
+ * @{ */
+
+extern struct ovsdb_idl *idl;
+extern char *g_hw_desc_dir;
+
+enum golden_state {
+    GOLDEN_IDLE,            /* No replay tried yet. */
+    GOLDEN_CONNECTING,      /* Waiting to send the transact request. */
+    GOLDEN_SENT,            /* Waiting for its reply. */
+    GOLDEN_APPLIED,         /* Committed, waiting for the IDL to see it. */
+    GOLDEN_DONE,            /* Replayed, or not tried. */
+};
+
+static const char               *golden_file = GOLDEN_CONFIG_FILE_PATH;
+static char                     *golden_remote;
+static char                     fingerprint[SHA1_HEX_DIGEST_LEN + 1];
+
+/* A row inserted by the initial configuration transaction. */
+struct golden_row {
+    const struct ovsdb_idl_table_class  *table;
+    const struct ovsdb_idl_row          *row;
+};
+
+/* Rows noted while the initial configuration transaction is built. */
+static bool                     recording;
+static struct golden_row        *inserted;
+static size_t                   n_inserted;
+static size_t                   allocated_inserted;
+
+/* Snapshot of the initial configuration transaction being committed. */
+static char                     *capture;
+static size_t                   capture_rows;
+
+static enum golden_state        replay_state = GOLDEN_IDLE;
+static struct jsonrpc_session   *replay_session;
+static struct jsonrpc_msg       *replay_request;
+static struct json              *replay_id;
+static size_t                   replay_rows;
+static long long                replay_started_at;
+static uint64_t                 replay_phase;
+
+/* An empty file name disables snapshots. */
+void
+sysd_golden_set_file(const char *path)
+{
+    golden_file = path;
+
+} /* sysd_golden_set_file */
+
+static bool
+golden_enabled(void)
+{
+    return golden_file[0] != '\0' && fingerprint[0] != '\0';
+
+} /* golden_enabled */
+
+/* Adds the name and contents of 'path' to 'ctx'. A missing file is hashed
+ * as its name alone, so that adding it later changes the fingerprint. */
+static void
+golden_hash_file(struct sha1_ctx *ctx, const char *path)
+{
+    char        buf[4096];
+    uint64_t    total = 0;
+    size_t      n;
+    FILE        *fp;
+
+    sha1_update(ctx, path, strlen(path) + 1);
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        return;
+    }
+    while ((n = fread(buf, 1, sizeof buf, fp)) > 0) {
+        sha1_update(ctx, buf, n);
+        total += n;
+    }
+    fclose(fp);
+    sha1_update(ctx, &total, sizeof total);
+
+} /* golden_hash_file */
+
+/* Adds every regular file in 'dir' to 'ctx', in name order. */
+static void
+golden_hash_dir(struct sha1_ctx *ctx, const char *dir)
+{
+    struct dirent   **names;
+    int             n;
+    int             i;
+
+    sha1_update(ctx, dir, strlen(dir) + 1);
+
+    n = scandir(dir, &names, NULL, alphasort);
+    if (n < 0) {
+        VLOG_WARN("Unable to list %s. Error %s", dir, ovs_strerror(errno));
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        char        *path = xasprintf("%s/%s", dir, names[i]->d_name);
+        struct stat st;
+
+        if (names[i]->d_name[0] != '.'
+            && !stat(path, &st) && S_ISREG(st.st_mode)) {
+            golden_hash_file(ctx, path);
+        }
+        free(path);
+        free(names[i]);
+    }
+    free(names);
+
+} /* golden_hash_dir */
+
+/* Takes note of the database to replay to and fingerprints the platform.
+ * Called once the FRU EEPROM has been read. */
+void
+sysd_golden_init(const char *remote, const char *manifest_file)
+{
+    struct sha1_ctx ctx;
+    uint8_t         digest[SHA1_DIGEST_SIZE];
+    uint32_t        version = SYSD_GOLDEN_VERSION;
+    int             i;
+
+    if (golden_file[0] == '\0') {
+        return;
+    }
+    free(golden_remote);
+    golden_remote = xstrdup(remote);
+
+    sha1_init(&ctx);
+    sha1_update(&ctx, &version, sizeof version);
+    golden_hash_dir(&ctx, g_hw_desc_dir);
+    golden_hash_file(&ctx, manifest_file);
+    golden_hash_file(&ctx, OS_RELEASE_FILE_PATH);
+
+    /* The decoded fields rather than the raw EEPROM, which is not kept. */
+    for (i = 0; i < num_subsystems; i++) {
+        struct json *fru = sysd_fru_to_json(&subsystems[i]->fru_eeprom);
+        char        *str = json_to_string(fru, JSSF_SORT);
+
+        sha1_update(&ctx, str, strlen(str) + 1);
+        free(str);
+        json_destroy(fru);
+    }
+
+    sha1_final(&ctx, digest);
+    sha1_to_hex(digest, fingerprint);
+    VLOG_DBG("Platform fingerprint %s", fingerprint);
+
+} /* sysd_golden_init */
+
+/*
+ * Capture.
+ *
+ * The IDL does not expose the JSON it sends, so the rows are read back
+ * from the open transaction: the code that builds the initial
+ * configuration notes each row it inserts, and only the columns it wrote
+ * are kept. They are written out as the same "insert" operations the IDL
+ * sends, with references between them by uuid-name.
+ */
+
+/* Starts noting the rows inserted into the initial configuration
+ * transaction. A retried build starts over. */
+void
+sysd_golden_capture_begin(void)
+{
+    n_inserted = 0;
+    recording = golden_enabled();
+
+} /* sysd_golden_capture_begin */
+
+/* Notes that 'row', of 'table', was inserted by the transaction being
+ * built. Does nothing outside of sysd_golden_capture_begin() and
+ * sysd_golden_capture(), since the same helpers build later transactions.
+ */
+void
+sysd_golden_note_insert(const struct ovsdb_idl_table_class *table,
+                        const struct ovsdb_idl_row *row)
+{
+    if (!recording) {
+        return;
+    }
+    if (n_inserted >= allocated_inserted) {
+        inserted = x2nrealloc(inserted, &allocated_inserted, sizeof *inserted);
+    }
+    inserted[n_inserted].table = table;
+    inserted[n_inserted].row = row;
+    n_inserted++;
+
+} /* sysd_golden_note_insert */
+
+/* Whether the values of 'column' may refer to other rows. */
+static bool
+golden_column_has_refs(const struct ovsdb_idl_column *column)
+{
+    return column->type.key.type == OVSDB_TYPE_UUID
+           || column->type.value.type == OVSDB_TYPE_UUID;
+
+} /* golden_column_has_refs */
+
+/* Replaces each ["uuid", UUID] in 'json' that refers to a row named in
+ * 'names' with ["named-uuid", NAME]. Returns false if 'json' refers to a
+ * row that is not in 'names'. */
+static bool
+golden_name_refs(struct json *json, const struct shash *names)
+{
+    struct json_array   *array;
+    size_t              i;
+
+    if (json->type != JSON_ARRAY) {
+        return true;
+    }
+    array = json_array(json);
+
+    if (array->n == 2
+        && array->elems[0]->type == JSON_STRING
+        && array->elems[1]->type == JSON_STRING
+        && !strcmp(json_string(array->elems[0]), "uuid")) {
+        const char *name = shash_find_data(names,
+                                           json_string(array->elems[1]));
+
+        if (name == NULL) {
+            return false;
+        }
+        json_destroy(array->elems[0]);
+        array->elems[0] = json_string_create("named-uuid");
+        json_destroy(array->elems[1]);
+        array->elems[1] = json_string_create(name);
+        return true;
+    }
+
+    for (i = 0; i < array->n; i++) {
+        if (!golden_name_refs(array->elems[i], names)) {
+            return false;
+        }
+    }
+
+    return true;
+
+} /* golden_name_refs */
+
+/* Returns the "insert" operation for 'row', holding only the columns the
+ * transaction wrote, as ovsdb_idl_txn_commit() does. */
+static struct json *
+golden_insert_op(const struct golden_row *ins, const char *name,
+                 const struct shash *names, bool *portable)
+{
+    const struct ovsdb_idl_table_class  *table = ins->table;
+    struct json                         *columns = json_object_create();
+    struct json                         *op = json_object_create();
+    size_t                              i;
+
+    for (i = 0; i < table->n_columns; i++) {
+        const struct ovsdb_idl_column   *column = &table->columns[i];
+        const struct ovsdb_datum        *datum;
+        struct json                     *value;
+
+        /* ovsdb-idl.h has no way to ask which columns a transaction set,
+         * so this reads the same 'written' bitmap ovsdb_idl_txn_commit()
+         * does, from ovsdb-idl-provider.h. That header ships with the IDL
+         * for the generated vswitch-idl.c, which relies on the same
+         * fields, so it changes only together with the IDL sysd links. */
+        if (!ins->row->written || !bitmap_is_set(ins->row->written, i)) {
+            continue;
+        }
+        datum = ovsdb_idl_read(ins->row, column);
+        value = ovsdb_datum_to_json(datum, &column->type);
+        if (golden_column_has_refs(column)
+            && !golden_name_refs(value, names)) {
+            *portable = false;
+        }
+        json_object_put(columns, column->name, value);
+    }
+
+    json_object_put_string(op, "op", "insert");
+    json_object_put_string(op, "table", table->name);
+    json_object_put_string(op, "uuid-name", name);
+    json_object_put(op, "row", columns);
+
+    return op;
+
+} /* golden_insert_op */
+
+/* Snapshots the rows noted since sysd_golden_capture_begin(), to be saved
+ * by sysd_golden_capture_done() once their transaction commits. */
+void
+sysd_golden_capture(void)
+{
+    struct shash    names = SHASH_INITIALIZER(&names);
+    struct json     *ops;
+    struct json     *snapshot;
+    bool            portable = true;
+    size_t          i;
+
+    free(capture);
+    capture = NULL;
+    capture_rows = 0;
+    if (!recording) {
+        return;
+    }
+    recording = false;
+
+    /* Name the inserted rows first, since rows refer to ones inserted
+     * after them. */
+    for (i = 0; i < n_inserted; i++) {
+        char uuid[UUID_LEN + 1];
+        char *name;
+        char *p;
+
+        snprintf(uuid, sizeof uuid, UUID_FMT,
+                 UUID_ARGS(&inserted[i].row->uuid));
+        name = xasprintf("row%s", uuid);
+        for (p = name; *p; p++) {
+            if (*p == '-') {
+                *p = '_';
+            }
+        }
+        shash_add(&names, uuid, name);
+    }
+
+    ops = json_array_create_empty();
+    for (i = 0; i < n_inserted; i++) {
+        char uuid[UUID_LEN + 1];
+
+        snprintf(uuid, sizeof uuid, UUID_FMT,
+                 UUID_ARGS(&inserted[i].row->uuid));
+        json_array_add(ops, golden_insert_op(&inserted[i],
+                                             shash_find_data(&names, uuid),
+                                             &names, &portable));
+    }
+    capture_rows = n_inserted;
+    n_inserted = 0;
+    shash_destroy_free_data(&names);
+
+    if (!portable) {
+        /* Replaying it would point at rows that a new database lacks. */
+        VLOG_INFO("Initial configuration refers to rows it did not insert, "
+                  "not keeping a snapshot");
+        json_destroy(ops);
+        return;
+    }
+
+    snapshot = json_object_create();
+    json_object_put(snapshot, "version",
+                    json_integer_create(SYSD_GOLDEN_VERSION));
+    json_object_put_string(snapshot, "fingerprint", fingerprint);
+    json_object_put(snapshot, "ops", ops);
+    capture = json_to_string(snapshot, 0);
+    json_destroy(snapshot);
+
+} /* sysd_golden_capture */
+
+static void
+golden_save(const char *str)
+{
+    char    *dir;
+    char    *tmp_file;
+    char    *slash;
+    FILE    *fp;
+
+    /* Make sure the snapshot directory exists. */
+    dir = xstrdup(golden_file);
+    slash = strrchr(dir, '/');
+    if (slash && slash != dir) {
+        *slash = '\0';
+        if (mkdir(dir, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH)
+            && errno != EEXIST) {
+            VLOG_WARN("Unable to create snapshot directory %s. Error %s",
+                      dir, ovs_strerror(errno));
+            free(dir);
+            return;
+        }
+    }
+    free(dir);
+
+    /* A crash while writing must not leave a truncated snapshot. */
+    tmp_file = xasprintf("%s.tmp", golden_file);
+    fp = fopen(tmp_file, "w");
+    if (fp == NULL) {
+        VLOG_WARN("Unable to write snapshot %s. Error %s",
+                  golden_file, ovs_strerror(errno));
+        free(tmp_file);
+        return;
+    }
+    fputs(str, fp);
+
+    if (fclose(fp) || rename(tmp_file, golden_file)) {
+        VLOG_WARN("Unable to write snapshot %s. Error %s",
+                  golden_file, ovs_strerror(errno));
+        remove(tmp_file);
+        free(tmp_file);
+        return;
+    }
+    free(tmp_file);
+
+    VLOG_INFO("Initial configuration snapshot of %"PRIuSIZE" rows written "
+              "to %s", capture_rows, golden_file);
+
+} /* golden_save */
+
+/* Saves the snapshot taken by sysd_golden_capture() if its transaction
+ * committed, and drops it either way. */
+void
+sysd_golden_capture_done(enum ovsdb_idl_txn_status status)
+{
+    if (capture && status == TXN_SUCCESS) {
+        golden_save(capture);
+    }
+    free(capture);
+    capture = NULL;
+    capture_rows = 0;
+
+} /* sysd_golden_capture_done */
+
+/*
+ * Replay.
+ *
+ * The snapshot is sent on a connection of its own, since the IDL only
+ * commits transactions it built. A "wait" operation ahead of the inserts
+ * makes ovsdb-server abort the transaction if a System row has appeared
+ * in the meantime.
+ */
+
+/* Reads the snapshot and returns its operations if it was taken on this
+ * platform and image, or NULL. */
+static struct json *
+golden_load(void)
+{
+    struct json         *snapshot = json_from_file(golden_file);
+    const struct json   *version;
+    const struct json   *print;
+    struct json         *ops = NULL;
+
+    if (snapshot->type != JSON_OBJECT) {
+        VLOG_INFO("No initial configuration snapshot: %s",
+                  snapshot->type == JSON_STRING
+                  ? json_string(snapshot) : golden_file);
+        json_destroy(snapshot);
+        return NULL;
+    }
+
+    version = shash_find_data(json_object(snapshot), "version");
+    print = shash_find_data(json_object(snapshot), "fingerprint");
+    if (version == NULL || version->type != JSON_INTEGER
+        || json_integer(version) != SYSD_GOLDEN_VERSION
+        || print == NULL || print->type != JSON_STRING
+        || strcmp(json_string(print), fingerprint)) {
+        VLOG_INFO("Initial configuration snapshot %s was taken on another "
+                  "platform or image, building the configuration",
+                  golden_file);
+    } else {
+        ops = shash_find_and_delete(json_object(snapshot), "ops");
+        if (ops && ops->type != JSON_ARRAY) {
+            VLOG_WARN("Initial configuration snapshot %s is malformed",
+                      golden_file);
+            json_destroy(ops);
+            ops = NULL;
+        }
+    }
+    json_destroy(snapshot);
+
+    return ops;
+
+} /* golden_load */
+
+/* Starts sending the saved initial configuration, if there is one for this
+ * platform and image. Returns false if the caller should build it instead.
+ * Only the first empty database sysd sees is tried. */
+bool
+sysd_golden_replay_start(void)
+{
+    struct json *ops;
+    struct json *params;
+    struct json *wait;
+    size_t      i;
+
+    if (!golden_enabled() || replay_state != GOLDEN_IDLE) {
+        return false;
+    }
+    replay_state = GOLDEN_DONE;
+
+    ops = golden_load();
+    if (ops == NULL) {
+        return false;
+    }
+
+    wait = json_object_create();
+    json_object_put_string(wait, "op", "wait");
+    json_object_put_string(wait, "table", ovsrec_table_system.name);
+    json_object_put(wait, "timeout", json_integer_create(0));
+    json_object_put(wait, "where", json_array_create_empty());
+    json_object_put(wait, "columns", json_array_create_empty());
+    json_object_put_string(wait, "until", "==");
+    json_object_put(wait, "rows", json_array_create_empty());
+
+    params = json_array_create_2(json_string_create(ovsrec_idl_class.database),
+                                 wait);
+    for (i = 0; i < json_array(ops)->n; i++) {
+        json_array_add(params, json_clone(json_array(ops)->elems[i]));
+    }
+    replay_rows = json_array(ops)->n;
+    json_destroy(ops);
+
+    replay_request = jsonrpc_create_request("transact", params, &replay_id);
+    replay_session = jsonrpc_session_open(golden_remote, false);
+    replay_state = GOLDEN_CONNECTING;
+    replay_started_at = time_msec();
+    replay_phase = sysd_trace_phase_start("golden_replay");
+    VLOG_INFO("Sending the initial configuration snapshot from %s",
+              golden_file);
+
+    return true;
+
+} /* sysd_golden_replay_start */
+
+/* Whether the snapshot is on its way to the database. */
+bool
+sysd_golden_replay_pending(void)
+{
+    return replay_state == GOLDEN_CONNECTING || replay_state == GOLDEN_SENT
+           || replay_state == GOLDEN_APPLIED;
+
+} /* sysd_golden_replay_pending */
+
+static void
+golden_replay_close(void)
+{
+    jsonrpc_session_close(replay_session);
+    replay_session = NULL;
+    jsonrpc_msg_destroy(replay_request);
+    replay_request = NULL;
+    json_destroy(replay_id);
+    replay_id = NULL;
+
+} /* golden_replay_close */
+
+/* Returns the first error in a transact reply, or NULL if it committed. */
+static char *
+golden_reply_error(const struct jsonrpc_msg *reply)
+{
+    const struct json_array *results;
+    size_t                  i;
+
+    if (reply->type == JSONRPC_ERROR) {
+        return json_to_string(reply->error, 0);
+    }
+    if (reply->result == NULL || reply->result->type != JSON_ARRAY) {
+        return xstrdup("malformed reply");
+    }
+
+    results = json_array(reply->result);
+    for (i = 0; i < results->n; i++) {
+        const struct json *result = results->elems[i];
+
+        if (result->type == JSON_OBJECT) {
+            const struct json *error = shash_find_data(json_object(result),
+                                                       "error");
+            if (error) {
+                return json_to_string(error, 0);
+            }
+        }
+    }
+
+    return NULL;
+
+} /* golden_reply_error */
+
+/* Moves the replay along. Returns true if it has just failed, in which
+ * case the caller builds the initial configuration. */
+bool
+sysd_golden_run(void)
+{
+    struct jsonrpc_msg  *msg;
+    char                *error = NULL;
+    bool                replied = false;
+
+    if (replay_state == GOLDEN_APPLIED) {
+        if (ovsrec_system_first(idl) != NULL) {
+            replay_state = GOLDEN_DONE;
+            sysd_trace_phase_stop("golden_replay", replay_phase);
+        }
+        return false;
+    }
+    if (replay_state != GOLDEN_CONNECTING && replay_state != GOLDEN_SENT) {
+        return false;
+    }
+
+    jsonrpc_session_run(replay_session);
+    if (replay_state == GOLDEN_CONNECTING
+        && jsonrpc_session_is_connected(replay_session)) {
+        jsonrpc_session_send(replay_session, replay_request);
+        replay_request = NULL;
+        replay_state = GOLDEN_SENT;
+    }
+
+    while (!replied && (msg = jsonrpc_session_recv(replay_session))) {
+        if ((msg->type == JSONRPC_REPLY || msg->type == JSONRPC_ERROR)
+            && json_equal(msg->id, replay_id)) {
+            replied = true;
+            error = golden_reply_error(msg);
+        }
+        jsonrpc_msg_destroy(msg);
+    }
+
+    if (!replied && !jsonrpc_session_is_alive(replay_session)) {
+        replied = true;
+        error = xstrdup("connection closed");
+    }
+    if (!replied) {
+        return false;
+    }
+    golden_replay_close();
+
+    if (error) {
+        VLOG_WARN("Initial configuration snapshot not applied (%s), "
+                  "building the configuration", error);
+        free(error);
+        replay_state = GOLDEN_DONE;
+        sysd_trace_phase_stop("golden_replay", replay_phase);
+        return true;
+    }
+
+    VLOG_INFO("Initial configuration snapshot of %"PRIuSIZE" rows committed "
+              "%lld ms after it was read", replay_rows,
+              time_msec() - replay_started_at);
+    replay_state = GOLDEN_APPLIED;
+    poll_immediate_wake();
+
+    return false;
+
+} /* sysd_golden_run */
+
+void
+sysd_golden_wait(void)
+{
+    if (replay_session) {
+        jsonrpc_session_wait(replay_session);
+        jsonrpc_session_recv_wait(replay_session);
+    }
+
+} /* sysd_golden_wait */
+/** @} end of group sysd */
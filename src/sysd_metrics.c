@@ -0,0 +1,489 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup sysd
+ *
+ * @file
+ * Source for sysd runtime metrics.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <unistd.h>
+
+#include <dynamic-string.h>
+#include <shash.h>
+#include <timeval.h>
+#include <util.h>
+#include <ovsdb-idl.h>
+#include <openvswitch/vlog.h>
+
+#include "sysd_metrics.h"
+#include "sysd_trace.h"
+#include "sysd_txn.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_metrics);
+
+/** @ingroup sysd
+ * @{ */
+
+/* Histogram buckets are powers of two, 1 to 32768: milliseconds for
+ * durations (1 ms to 32 s), plain counts otherwise. */
+#define METRICS_HIST_BUCKETS    16
+
+struct metrics_hist {
+    unsigned long long  buckets[METRICS_HIST_BUCKETS + 1]; /* Last is +Inf. */
+    unsigned long long  count;
+    long long           sum;
+};
+
+/* Scale for metrics_hist_format(). */
+#define METRICS_MSEC    1000.0      /* Samples in msec, reported in sec. */
+#define METRICS_COUNT   1.0
+
+static const char *txn_site_names[SYSD_TXN_N_SITES] = {
+    "initial_config",
+    "hw_done",
+    "package_info",
+    "software_info",
+    "interfaces",
+    "reconcile",
+};
+
+#define METRICS_TXN_N_STATUSES  (TXN_ERROR + 1)
+
+static unsigned long long   poll_wakeups;
+static unsigned long long   seqno_changes;
+static long long            woke_at;
+static struct metrics_hist  run_hist;
+static struct metrics_hist  busy_hist;
+
+static unsigned long long   txn_results[SYSD_TXN_N_SITES]
+                                       [METRICS_TXN_N_STATUSES];
+static struct metrics_hist  txn_build_hist[SYSD_TXN_N_SITES];
+static struct metrics_hist  txn_commit_hist[SYSD_TXN_N_SITES];
+static struct metrics_hist  txn_rows_hist[SYSD_TXN_N_SITES];
+static unsigned int         txn_rows;   /* Written since last taken. */
+static unsigned long long   txn_coalesced;
+static unsigned long long   txn_retries[SYSD_TXN_N_SITES];
+static long long            slow_commit_msec = SYSD_SLOW_COMMIT_MSEC_DFLT;
+static struct shash         rows_written = SHASH_INITIALIZER(&rows_written);
+static unsigned long long   package_info_rows;
+
+static unsigned long long   fru_reads;
+static unsigned long long   fru_read_bytes;
+static long long            fru_read_msec;
+
+static unsigned long long   timezone_applied;
+
+static void
+metrics_hist_add(struct metrics_hist *hist, long long msec)
+{
+    int i;
+
+    for (i = 0; i < METRICS_HIST_BUCKETS && msec > (1LL << i); i++) {
+        continue;
+    }
+    hist->buckets[i]++;
+    hist->count++;
+    hist->sum += msec;
+
+} /* metrics_hist_add */
+
+static void
+metrics_header(struct ds *ds, const char *name, const char *type,
+               const char *help)
+{
+    ds_put_format(ds, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+
+} /* metrics_header */
+
+/* 'labels' is empty or a list of label pairs, without braces. Bucket
+ * bounds and the sum are divided by 'scale'. */
+static void
+metrics_hist_format(struct ds *ds, const char *name, const char *labels,
+                    const struct metrics_hist *hist, double scale)
+{
+    unsigned long long  cumulative = 0;
+    const char          *sep = labels[0] ? "," : "";
+    int                 i;
+
+    for (i = 0; i < METRICS_HIST_BUCKETS; i++) {
+        cumulative += hist->buckets[i];
+        ds_put_format(ds, "%s_bucket{%s%sle=\"%g\"} %llu\n", name, labels,
+                      sep, (1LL << i) / scale, cumulative);
+    }
+    ds_put_format(ds, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, labels, sep,
+                  hist->count);
+    if (labels[0]) {
+        ds_put_format(ds, "%s_sum{%s} %.3f\n%s_count{%s} %llu\n",
+                      name, labels, hist->sum / scale,
+                      name, labels, hist->count);
+    } else {
+        ds_put_format(ds, "%s_sum %.3f\n%s_count %llu\n",
+                      name, hist->sum / scale, name, hist->count);
+    }
+
+} /* metrics_hist_format */
+
+static void
+metrics_txn_hist_format(struct ds *ds, const char *name, int site,
+                        const struct metrics_hist *hist, double scale)
+{
+    char labels[64];
+
+    if (hist->count) {
+        snprintf(labels, sizeof labels, "site=\"%s\"", txn_site_names[site]);
+        metrics_hist_format(ds, name, labels, hist, scale);
+    }
+
+} /* metrics_txn_hist_format */
+
+void
+sysd_metrics_loop_woke(void)
+{
+    poll_wakeups++;
+    woke_at = time_msec();
+
+} /* sysd_metrics_loop_woke */
+
+/* Records how long the main loop was busy, from waking up to blocking
+ * again. An event that arrives meanwhile waits up to that long, but the
+ * time it waited is not measured. */
+void
+sysd_metrics_loop_sleeping(void)
+{
+    if (woke_at) {
+        metrics_hist_add(&busy_hist, time_msec() - woke_at);
+    }
+
+} /* sysd_metrics_loop_sleeping */
+
+void
+sysd_metrics_run_time(long long msec)
+{
+    metrics_hist_add(&run_hist, msec);
+
+} /* sysd_metrics_run_time */
+
+void
+sysd_metrics_seqno_changed(void)
+{
+    seqno_changes++;
+
+} /* sysd_metrics_seqno_changed */
+
+static void
+metrics_txn(enum sysd_txn_site site, enum ovsdb_idl_txn_status status)
+{
+    if (site < SYSD_TXN_N_SITES && status < METRICS_TXN_N_STATUSES) {
+        txn_results[site][status]++;
+    }
+
+} /* metrics_txn */
+
+/* Rows written to one table. */
+struct metrics_table_rows {
+    unsigned long long  committed;
+    unsigned int        pending;    /* In the transaction being built or
+                                     * committed. */
+};
+
+/* Counts 'n' rows of 'table' in the transaction being built. They are
+ * added to the table's total by sysd_metrics_rows_settle() if it commits. */
+void
+sysd_metrics_rows_written(const struct ovsdb_idl_table_class *table,
+                          unsigned int n)
+{
+    struct metrics_table_rows *rows = shash_find_data(&rows_written,
+                                                      table->name);
+
+    if (rows == NULL) {
+        rows = xzalloc(sizeof *rows);
+        shash_add(&rows_written, table->name, rows);
+    }
+    rows->pending += n;
+    txn_rows += n;
+
+} /* sysd_metrics_rows_written */
+
+/* Adds the rows counted since the last call to the per-table totals if
+ * 'committed', else drops them. */
+void
+sysd_metrics_rows_settle(bool committed)
+{
+    struct shash_node *node;
+
+    SHASH_FOR_EACH (node, &rows_written) {
+        struct metrics_table_rows *rows = node->data;
+
+        if (committed) {
+            rows->committed += rows->pending;
+        }
+        rows->pending = 0;
+    }
+
+} /* sysd_metrics_rows_settle */
+
+void
+sysd_metrics_set_slow_commit_msec(long long msec)
+{
+    slow_commit_msec = msec;
+
+} /* sysd_metrics_set_slow_commit_msec */
+
+const char *
+sysd_metrics_txn_site_name(enum sysd_txn_site site)
+{
+    return site < SYSD_TXN_N_SITES ? txn_site_names[site] : "unknown";
+
+} /* sysd_metrics_txn_site_name */
+
+unsigned int
+sysd_metrics_txn_rows_take(void)
+{
+    unsigned int rows = txn_rows;
+
+    txn_rows = 0;
+    return rows;
+
+} /* sysd_metrics_txn_rows_take */
+
+void
+sysd_metrics_txn_done(enum sysd_txn_site site,
+                      enum ovsdb_idl_txn_status status, uint64_t build_ns,
+                      uint64_t commit_ns, unsigned int rows)
+{
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+    uint64_t                    now_ns = sysd_trace_now();
+    long long                   build_msec = (commit_ns - build_ns) / 1000000;
+    long long                   commit_msec = (now_ns - commit_ns) / 1000000;
+
+    sysd_trace(SYSD_TRACE_TXN_COMMIT, sysd_metrics_txn_site_name(site), rows,
+               (now_ns - commit_ns) / 1000, status);
+
+    metrics_txn(site, status);
+    if (site < SYSD_TXN_N_SITES) {
+        metrics_hist_add(&txn_build_hist[site], build_msec);
+        metrics_hist_add(&txn_commit_hist[site], commit_msec);
+        metrics_hist_add(&txn_rows_hist[site], rows);
+    }
+
+    if (slow_commit_msec > 0 && commit_msec >= slow_commit_msec) {
+        VLOG_WARN_RL(&rl, "Slow %s commit: %lld ms for %u rows (built in "
+                     "%lld ms), %s", sysd_metrics_txn_site_name(site),
+                     commit_msec, rows, build_msec,
+                     ovsdb_idl_txn_status_to_string(status));
+    }
+
+} /* sysd_metrics_txn_done */
+
+/* Records 'n' jobs committed in the transaction of an earlier job. */
+void
+sysd_metrics_txn_coalesced(unsigned int n)
+{
+    txn_coalesced += n;
+
+} /* sysd_metrics_txn_coalesced */
+
+void
+sysd_metrics_txn_retry(enum sysd_txn_site site)
+{
+    if (site < SYSD_TXN_N_SITES) {
+        txn_retries[site]++;
+    }
+
+} /* sysd_metrics_txn_retry */
+
+void
+sysd_metrics_package_info_rows(unsigned int n)
+{
+    package_info_rows += n;
+
+} /* sysd_metrics_package_info_rows */
+
+void
+sysd_metrics_fru_read(size_t bytes, long long msec)
+{
+    fru_reads++;
+    fru_read_bytes += bytes;
+    fru_read_msec = msec;
+
+} /* sysd_metrics_fru_read */
+
+void
+sysd_metrics_timezone_applied(void)
+{
+    timezone_applied++;
+
+} /* sysd_metrics_timezone_applied */
+
+long long
+sysd_metrics_rss_bytes(void)
+{
+    unsigned long   size;
+    unsigned long   resident;
+    FILE            *fp;
+    int             n;
+
+    fp = fopen("/proc/self/statm", "r");
+    if (fp == NULL) {
+        return -1;
+    }
+    n = fscanf(fp, "%lu %lu", &size, &resident);
+    fclose(fp);
+
+    return n == 2 ? (long long) resident * sysconf(_SC_PAGESIZE) : -1;
+
+} /* sysd_metrics_rss_bytes */
+
+long long
+sysd_metrics_heap_bytes(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 \
+                           || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+#else
+    struct mallinfo mi = mallinfo();
+#endif
+
+    /* Bytes handed out by malloc, from the main arena and mmap. */
+    return (long long) mi.uordblks + (long long) mi.hblkhd;
+
+} /* sysd_metrics_heap_bytes */
+
+void
+sysd_metrics_format(struct ds *ds)
+{
+    const struct shash_node **nodes;
+    size_t                  i;
+    int                     site;
+    int                     status;
+
+    metrics_header(ds, "sysd_poll_wakeups_total", "counter",
+                   "Main loop wakeups.");
+    ds_put_format(ds, "sysd_poll_wakeups_total %llu\n", poll_wakeups);
+
+    metrics_header(ds, "sysd_idl_seqno_changes_total", "counter",
+                   "IDL sequence number changes seen by sysd_run.");
+    ds_put_format(ds, "sysd_idl_seqno_changes_total %llu\n", seqno_changes);
+
+    metrics_header(ds, "sysd_run_duration_seconds", "histogram",
+                   "Time spent in sysd_run per main loop iteration.");
+    metrics_hist_format(ds, "sysd_run_duration_seconds", "", &run_hist,
+                        METRICS_MSEC);
+
+    metrics_header(ds, "sysd_poll_loop_busy_seconds", "histogram",
+                   "Time the main loop is busy, from wakeup until the "
+                   "next poll_block().");
+    metrics_hist_format(ds, "sysd_poll_loop_busy_seconds", "", &busy_hist,
+                        METRICS_MSEC);
+
+    metrics_header(ds, "sysd_ovsdb_txn_total", "counter",
+                   "OVSDB transactions committed, by call site and result.");
+    for (site = 0; site < SYSD_TXN_N_SITES; site++) {
+        for (status = 0; status < METRICS_TXN_N_STATUSES; status++) {
+            if (txn_results[site][status]) {
+                ds_put_format(ds, "sysd_ovsdb_txn_total{site=\"%s\","
+                              "status=\"%s\"} %llu\n", txn_site_names[site],
+                              ovsdb_idl_txn_status_to_string(status),
+                              txn_results[site][status]);
+            }
+        }
+    }
+
+    metrics_header(ds, "sysd_ovsdb_txn_queue_length", "gauge",
+                   "OVSDB write jobs queued or in flight.");
+    ds_put_format(ds, "sysd_ovsdb_txn_queue_length %"PRIuSIZE"\n",
+                  sysd_txn_n_pending());
+
+    metrics_header(ds, "sysd_ovsdb_txn_retries_total", "counter",
+                   "OVSDB transactions built again after a failed commit, "
+                   "by call site.");
+    for (site = 0; site < SYSD_TXN_N_SITES; site++) {
+        if (txn_retries[site]) {
+            ds_put_format(ds, "sysd_ovsdb_txn_retries_total{site=\"%s\"} "
+                          "%llu\n", txn_site_names[site], txn_retries[site]);
+        }
+    }
+
+    metrics_header(ds, "sysd_ovsdb_txn_coalesced_total", "counter",
+                   "OVSDB write jobs committed in another job's transaction.");
+    ds_put_format(ds, "sysd_ovsdb_txn_coalesced_total %llu\n", txn_coalesced);
+
+    metrics_header(ds, "sysd_ovsdb_txn_build_seconds", "histogram",
+                   "Time spent building a transaction before committing it.");
+    for (site = 0; site < SYSD_TXN_N_SITES; site++) {
+        metrics_txn_hist_format(ds, "sysd_ovsdb_txn_build_seconds", site,
+                                &txn_build_hist[site], METRICS_MSEC);
+    }
+    metrics_header(ds, "sysd_ovsdb_txn_commit_seconds", "histogram",
+                   "Commit round trip to ovsdb-server.");
+    for (site = 0; site < SYSD_TXN_N_SITES; site++) {
+        metrics_txn_hist_format(ds, "sysd_ovsdb_txn_commit_seconds", site,
+                                &txn_commit_hist[site], METRICS_MSEC);
+    }
+    metrics_header(ds, "sysd_ovsdb_txn_rows", "histogram",
+                   "Rows inserted or updated per transaction.");
+    for (site = 0; site < SYSD_TXN_N_SITES; site++) {
+        metrics_txn_hist_format(ds, "sysd_ovsdb_txn_rows", site,
+                                &txn_rows_hist[site], METRICS_COUNT);
+    }
+
+    metrics_header(ds, "sysd_ovsdb_rows_written_total", "counter",
+                   "Rows inserted or updated by committed transactions, "
+                   "by table.");
+    nodes = shash_sort(&rows_written);
+    for (i = 0; i < shash_count(&rows_written); i++) {
+        const struct metrics_table_rows *rows = nodes[i]->data;
+
+        ds_put_format(ds, "sysd_ovsdb_rows_written_total{table=\"%s\"} %llu\n",
+                      nodes[i]->name, rows->committed);
+    }
+    free(nodes);
+
+    metrics_header(ds, "sysd_package_info_rows_total", "counter",
+                   "Package_Info rows loaded from version_detail.yaml.");
+    ds_put_format(ds, "sysd_package_info_rows_total %llu\n",
+                  package_info_rows);
+
+    metrics_header(ds, "sysd_fru_reads_total", "counter",
+                   "FRU EEPROM reads.");
+    ds_put_format(ds, "sysd_fru_reads_total %llu\n", fru_reads);
+    metrics_header(ds, "sysd_fru_read_bytes_total", "counter",
+                   "Bytes read from the FRU EEPROM.");
+    ds_put_format(ds, "sysd_fru_read_bytes_total %llu\n", fru_read_bytes);
+    metrics_header(ds, "sysd_fru_read_seconds", "gauge",
+                   "Duration of the last FRU EEPROM read.");
+    ds_put_format(ds, "sysd_fru_read_seconds %.3f\n", fru_read_msec / 1000.0);
+
+    metrics_header(ds, "sysd_timezone_applied_total", "counter",
+                   "Timezone changes applied to /etc/localtime.");
+    ds_put_format(ds, "sysd_timezone_applied_total %llu\n", timezone_applied);
+
+    metrics_header(ds, "process_resident_memory_bytes", "gauge",
+                   "Resident memory size in bytes.");
+    ds_put_format(ds, "process_resident_memory_bytes %lld\n",
+                  sysd_metrics_rss_bytes());
+    metrics_header(ds, "sysd_heap_allocated_bytes", "gauge",
+                   "Bytes currently allocated with malloc.");
+    ds_put_format(ds, "sysd_heap_allocated_bytes %lld\n",
+                  sysd_metrics_heap_bytes());
+
+} /* sysd_metrics_format */
+/** @} end of group sysd */
@@ -0,0 +1,179 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup sysd
+ *
+ * @file
+ * Source for sysd conditional OVSDB monitoring.
+ */
+
+#include <stdbool.h>
+
+#include <ovsdb-idl.h>
+#include <vswitch-idl.h>
+#include <openvswitch/vlog.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_monitor.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_monitor);
+
+/** @ingroup sysd
+ * @{ */
+
+extern struct ovsdb_idl *idl;
+
+static const char *phase_names[] = {
+    [SYSD_MONITOR_RECONCILE]    = "reconcile",
+    [SYSD_MONITOR_HW_WAIT]      = "hw_wait",
+    [SYSD_MONITOR_RUNNING]      = "running",
+};
+
+static enum sysd_monitor_phase  cur_phase = SYSD_MONITOR_RECONCILE;
+static bool                     cur_packages;
+
+/* Condition sequence number at which the server applies the conditions of
+ * 'cur_phase', and whether it had done so at the last check. */
+static unsigned int             cond_seqno;
+static bool                     synced;
+
+#ifdef HAVE_OVSDB_IDL_CONDITIONS
+static unsigned int
+monitor_set_conditions(enum sysd_monitor_phase phase, bool packages)
+{
+    struct ovsdb_idl_condition  intf_cond;
+    struct ovsdb_idl_condition  daemon_cond;
+    struct ovsdb_idl_condition  pkg_cond;
+    unsigned int                seqno;
+
+    /* An empty condition matches no rows. */
+    ovsdb_idl_condition_init(&intf_cond);
+    ovsdb_idl_condition_init(&daemon_cond);
+    ovsdb_idl_condition_init(&pkg_cond);
+
+    switch (phase) {
+    case SYSD_MONITOR_RECONCILE:
+        ovsrec_interface_add_clause_type(&intf_cond, OVSDB_F_EQ,
+                                         OVSREC_INTERFACE_TYPE_SYSTEM);
+        ovsdb_idl_condition_add_clause_true(&daemon_cond);
+        break;
+    case SYSD_MONITOR_HW_WAIT:
+        ovsrec_interface_add_clause_type(&intf_cond, OVSDB_F_EQ,
+                                         OVSREC_INTERFACE_TYPE_SYSTEM);
+        ovsrec_daemon_add_clause_is_hw_handler(&daemon_cond, OVSDB_F_EQ,
+                                               true);
+        break;
+    case SYSD_MONITOR_RUNNING:
+        break;
+    }
+    if (packages) {
+        ovsdb_idl_condition_add_clause_true(&pkg_cond);
+    }
+
+    seqno = ovsdb_idl_set_condition(idl, &ovsrec_table_interface,
+                                    &intf_cond);
+    seqno = MAX(seqno, ovsdb_idl_set_condition(idl, &ovsrec_table_daemon,
+                                               &daemon_cond));
+    seqno = MAX(seqno, ovsdb_idl_set_condition(idl,
+                                               &ovsrec_table_package_info,
+                                               &pkg_cond));
+
+    ovsdb_idl_condition_destroy(&pkg_cond);
+    ovsdb_idl_condition_destroy(&daemon_cond);
+    ovsdb_idl_condition_destroy(&intf_cond);
+
+    return seqno;
+
+} /* monitor_set_conditions */
+
+static unsigned int
+monitor_condition_seqno(void)
+{
+    return ovsdb_idl_get_condition_seqno(idl);
+
+} /* monitor_condition_seqno */
+#else
+/* The IDL replicates whole tables, so every phase has its rows as soon as
+ * the IDL does. */
+static unsigned int
+monitor_set_conditions(enum sysd_monitor_phase phase OVS_UNUSED,
+                       bool packages OVS_UNUSED)
+{
+    return 0;
+
+} /* monitor_set_conditions */
+
+static unsigned int
+monitor_condition_seqno(void)
+{
+    return 0;
+
+} /* monitor_condition_seqno */
+#endif /* HAVE_OVSDB_IDL_CONDITIONS */
+
+/* Sets the conditions of the first phase, before the IDL connects, so the
+ * initial monitor request already carries them. */
+void
+sysd_monitor_init(void)
+{
+#ifndef HAVE_OVSDB_IDL_CONDITIONS
+    VLOG_INFO("OVSDB IDL without conditional monitoring, replicating whole "
+              "tables");
+#endif
+    cur_phase = SYSD_MONITOR_RECONCILE;
+    cur_packages = false;
+    cond_seqno = monitor_set_conditions(cur_phase, cur_packages);
+    synced = false;
+
+} /* sysd_monitor_init */
+
+/* Moves the conditions to those of 'phase', with Package_Info rows if
+ * 'packages', called from each sysd_run(). Returns true when the server
+ * has just caught up with the conditions of the current phase. Rows it
+ * adds for a wider condition need not change the IDL sequence number, so
+ * the caller takes this as a change too. */
+bool
+sysd_monitor_run(enum sysd_monitor_phase phase, bool packages)
+{
+    if (phase != cur_phase || packages != cur_packages) {
+        VLOG_INFO("Monitoring for the %s phase%s, was %s%s",
+                  phase_names[phase], packages ? " with packages" : "",
+                  phase_names[cur_phase],
+                  cur_packages ? " with packages" : "");
+        cur_phase = phase;
+        cur_packages = packages;
+        cond_seqno = monitor_set_conditions(phase, packages);
+        synced = false;
+    }
+
+    if (!synced && monitor_condition_seqno() >= cond_seqno) {
+        synced = true;
+        return true;
+    }
+
+    return false;
+
+} /* sysd_monitor_run */
+
+/* Whether the IDL holds every row the current phase asks for. */
+bool
+sysd_monitor_synced(void)
+{
+    return synced;
+
+} /* sysd_monitor_synced */
+/** @} end of group sysd */
@@ -33,8 +33,14 @@
 #include <daemon.h>
 #include <dirs.h>
 #include <smap.h>
+#include <dynamic-string.h>
+#include <hash.h>
+#include <hmap.h>
+#include <json.h>
 #include <shash.h>
 #include <poll-loop.h>
+#include <sha1.h>
+#include <timeval.h>
 #include <ovsdb-idl.h>
 #include <openswitch-idl.h>
 #include <vswitch-idl.h>
@@ -47,8 +53,17 @@
 #include "qos_init.h"
 #include "acl_init.h"
 #include "sysd.h"
+#include "sysd_cfg_yaml.h"
+#include "sysd_defaults.h"
+#include "sysd_dispatch.h"
 #include "sysd_util.h"
 #include "sysd_ovsdb_if.h"
+#include "sysd_metrics.h"
+#include "sysd_golden.h"
+#include "sysd_monitor.h"
+#include "sysd_reconcile.h"
+#include "sysd_trace.h"
+#include "sysd_txn.h"
 #include "eventlog.h"
 
 #include <errno.h>
@@ -59,7 +74,10 @@ VLOG_DEFINE_THIS_MODULE(ovsdb_if);
 /** @ingroup sysd
  * @{ */
 #define PKG_INFO_ENTRIES_PER_COMMIT 2000
-#define REM_BUF_LEN (buflen - 1 - strlen(buf))
+
+/* System:other_info key holding the SHA-1 of the version_detail file that
+ * Package_Info was last filled from. */
+#define PKG_INFO_DIGEST_KEY "sysd_package_info_sha1"
 
 enum {
     VALUE,
@@ -84,94 +102,247 @@ extern char *g_hw_desc_dir;
 
 static bool hw_init_done_set = false;
 
+/* Package version details, overridable with --version-detail. */
+static const char *version_detail_file = VERSION_DETAIL_FILE_PATH;
+
 void
-sysd_get_speeds_string(char *speed_str, int len, int **speeds)
+sysd_set_version_detail_file(const char *path)
 {
-    int     i = 0;
-    char    buf[10];
+    version_detail_file = path;
 
-    while(speeds[i] != NULL) {
-        if (i == 0) {
-            snprintf(buf, sizeof(buf), "%d", *speeds[i]);
-        } else {
-            snprintf(buf, sizeof(buf), ",%d", *speeds[i]);
-        }
-        strncat(speed_str, buf, len);
-        i++;
-    }
-} /* sysd_get_speeds_string */
+} /* sysd_set_version_detail_file */
 
-struct ovsrec_interface *
-sysd_initial_interface_add(struct ovsdb_idl_txn *txn,
-                           sysd_subsystem_t *subsys_ptr,
-                           sysd_intf_info_t *intf_ptr)
-{
-    char                        *tmp_p;
-    char                        buf[128];
-    struct ovsrec_interface     *ovs_intf = NULL;
-    struct smap                 hw_intf_info;
-    char                        **cap_p;
+/*
+ * hw_intf_info templates.
+ *
+ * Only switch_unit and switch_intf_id differ between interfaces of the same
+ * port type within a subsystem. The rest of hw_intf_info (connector,
+ * pluggable, max_speed, speeds, capabilities and the subsystem MAC) is
+ * built once per port type and copied for each interface.
+ */
+struct hw_intf_template {
+    struct hmap_node    node;
+    uint64_t            system_mac_addr;
+    bool                pluggable;
+    int                 max_speed;
+    const char          *connector;     /* These point into the first */
+    int                 **speeds;       /* port description of the type. */
+    char                **capabilities;
+    struct smap         info;
+};
 
-    ovs_intf = ovsrec_interface_insert(txn);
+static struct hmap hw_intf_templates = HMAP_INITIALIZER(&hw_intf_templates);
 
-    ovsrec_interface_set_name(ovs_intf, intf_ptr->name);
+static const char *known_intf_capabilities[] = {
+    INTERFACE_HW_INTF_INFO_MAP_SPLIT_4,
+    INTERFACE_HW_INTF_INFO_MAP_ENET1G,
+    INTERFACE_HW_INTF_INFO_MAP_ENET10G,
+    INTERFACE_HW_INTF_INFO_MAP_ENET25G,
+    INTERFACE_HW_INTF_INFO_MAP_ENET40G,
+    INTERFACE_HW_INTF_INFO_MAP_ENET100G,
+};
 
-    ovsrec_interface_set_type(ovs_intf, OVSREC_INTERFACE_TYPE_SYSTEM);
+static uint32_t
+hw_intf_template_hash(const sysd_subsystem_t *subsys_ptr,
+                      const sysd_intf_info_t *intf_ptr)
+{
+    uint32_t    hash;
+    int         i;
+
+    hash = hash_bytes(&subsys_ptr->system_mac_addr,
+                      sizeof subsys_ptr->system_mac_addr, 0);
+    hash = hash_int(intf_ptr->max_speed, hash);
+    hash = hash_int(intf_ptr->pluggable, hash);
+    hash = hash_string(intf_ptr->connector, hash);
+    for (i = 0; intf_ptr->speeds[i]; i++) {
+        hash = hash_int(*intf_ptr->speeds[i], hash);
+    }
+    for (i = 0; intf_ptr->capabilities[i]; i++) {
+        hash = hash_string(intf_ptr->capabilities[i], hash);
+    }
 
-    ovsrec_interface_set_admin_state(ovs_intf, OVSREC_INTERFACE_ADMIN_STATE_DOWN);
+    return hash;
 
-    smap_init(&hw_intf_info);
+} /* hw_intf_template_hash */
 
-    tmp_p = (intf_ptr->pluggable) ? INTERFACE_HW_INTF_INFO_MAP_PLUGGABLE_TRUE
-        : INTERFACE_HW_INTF_INFO_MAP_PLUGGABLE_FALSE;
-    smap_add(&hw_intf_info, INTERFACE_HW_INTF_INFO_MAP_PLUGGABLE, tmp_p);
-    smap_add(&hw_intf_info, INTERFACE_HW_INTF_INFO_MAP_CONNECTOR, intf_ptr->connector);
+static bool
+hw_intf_template_matches(const struct hw_intf_template *t,
+                         const sysd_subsystem_t *subsys_ptr,
+                         const sysd_intf_info_t *intf_ptr)
+{
+    int i;
 
-    smap_add_format(&hw_intf_info, INTERFACE_HW_INTF_INFO_MAP_MAX_SPEED,
-                    "%d", intf_ptr->max_speed);
+    if (t->system_mac_addr != subsys_ptr->system_mac_addr
+        || t->pluggable != intf_ptr->pluggable
+        || t->max_speed != intf_ptr->max_speed
+        || strcmp(t->connector, intf_ptr->connector)) {
+        return false;
+    }
 
-    memset(buf, 0, sizeof(buf));
-    sysd_get_speeds_string(buf, sizeof(buf), intf_ptr->speeds);
-    smap_add(&hw_intf_info, INTERFACE_HW_INTF_INFO_MAP_SPEEDS, buf);
+    /* Ports of one type share these arrays once the hardware description
+     * has been compacted, see sysd_cfg_yaml_compact(). */
+    if (t->speeds != intf_ptr->speeds) {
+        for (i = 0; t->speeds[i] && intf_ptr->speeds[i]; i++) {
+            if (*t->speeds[i] != *intf_ptr->speeds[i]) {
+                return false;
+            }
+        }
+        if (t->speeds[i] || intf_ptr->speeds[i]) {
+            return false;
+        }
+    }
+    if (t->capabilities != intf_ptr->capabilities) {
+        for (i = 0; t->capabilities[i] && intf_ptr->capabilities[i]; i++) {
+            if (strcmp(t->capabilities[i], intf_ptr->capabilities[i])) {
+                return false;
+            }
+        }
+        if (t->capabilities[i] || intf_ptr->capabilities[i]) {
+            return false;
+        }
+    }
 
+    return true;
 
-    smap_add_format(&hw_intf_info, INTERFACE_HW_INTF_INFO_MAP_SWITCH_UNIT,
-                    "%d", intf_ptr->device);
-    smap_add_format(&hw_intf_info, INTERFACE_HW_INTF_INFO_MAP_SWITCH_INTF_ID,
-                    "%d", intf_ptr->device_port);
+} /* hw_intf_template_matches */
+
+static struct hw_intf_template *
+hw_intf_template_create(const sysd_subsystem_t *subsys_ptr,
+                        const sysd_intf_info_t *intf_ptr, uint32_t hash)
+{
+    struct hw_intf_template *t = xzalloc(sizeof *t);
+    struct ds               speeds = DS_EMPTY_INITIALIZER;
+    char                    mac_addr[32];
+    char                    **cap_p;
+    int                     i;
+
+    t->system_mac_addr = subsys_ptr->system_mac_addr;
+    t->pluggable = intf_ptr->pluggable;
+    t->max_speed = intf_ptr->max_speed;
+    t->connector = intf_ptr->connector;
+    t->speeds = intf_ptr->speeds;
+    t->capabilities = intf_ptr->capabilities;
+    smap_init(&t->info);
+
+    smap_add(&t->info, INTERFACE_HW_INTF_INFO_MAP_PLUGGABLE,
+             intf_ptr->pluggable ? INTERFACE_HW_INTF_INFO_MAP_PLUGGABLE_TRUE
+                                 : INTERFACE_HW_INTF_INFO_MAP_PLUGGABLE_FALSE);
+    smap_add(&t->info, INTERFACE_HW_INTF_INFO_MAP_CONNECTOR,
+             intf_ptr->connector);
+    smap_add_format(&t->info, INTERFACE_HW_INTF_INFO_MAP_MAX_SPEED,
+                    "%d", intf_ptr->max_speed);
+
+    for (i = 0; intf_ptr->speeds[i] != NULL; i++) {
+        ds_put_format(&speeds, i ? ",%d" : "%d", *intf_ptr->speeds[i]);
+    }
+    smap_add(&t->info, INTERFACE_HW_INTF_INFO_MAP_SPEEDS, ds_cstr(&speeds));
+    ds_destroy(&speeds);
 
     /* Add interface capabilities
      * Check for known values and add them. If an unknown capability is given,
      * log (info) it and go ahead and add it.
     */
-    cap_p = intf_ptr->capabilities;
-
-    while (*cap_p != (char *) NULL) {
-        if ((strcmp(*cap_p, INTERFACE_HW_INTF_INFO_MAP_SPLIT_4) != 0)  &&
-            (strcmp(*cap_p, INTERFACE_HW_INTF_INFO_MAP_ENET1G)  != 0)  &&
-            (strcmp(*cap_p, INTERFACE_HW_INTF_INFO_MAP_ENET10G) != 0)  &&
-            (strcmp(*cap_p, INTERFACE_HW_INTF_INFO_MAP_ENET25G) != 0)  &&
-            (strcmp(*cap_p, INTERFACE_HW_INTF_INFO_MAP_ENET40G) != 0)  &&
-            (strcmp(*cap_p, INTERFACE_HW_INTF_INFO_MAP_ENET100G) != 0)) {
-
+    for (cap_p = intf_ptr->capabilities; *cap_p != NULL; cap_p++) {
+        for (i = 0; i < ARRAY_SIZE(known_intf_capabilities); i++) {
+            if (!strcmp(*cap_p, known_intf_capabilities[i])) {
+                break;
+            }
+        }
+        if (i == ARRAY_SIZE(known_intf_capabilities)) {
             VLOG_INFO("subsystem[%s]:interface[%s] - adding unknown "
                       "interface capability[%s]",
-                             subsys_ptr->name, intf_ptr->name, *cap_p);
+                      subsys_ptr->name, intf_ptr->name, *cap_p);
         }
 
-        smap_add(&hw_intf_info, *cap_p, "true");
-        cap_p++;
+        smap_add(&t->info, *cap_p, "true");
     }
 
     /* All the interfaces in a subsystem uses the same MAC address.
      * Copy the subsystem system MAC to interface hw_info:mac_addres.
      */
     if (subsys_ptr->system_mac_addr) {
-        memset(buf, 0, sizeof(buf));
-        tmp_p = ops_ether_ulong_long_to_string(buf, subsys_ptr->system_mac_addr);
-        smap_add(&hw_intf_info, INTERFACE_HW_INTF_INFO_MAP_MAC_ADDR, tmp_p);
+        memset(mac_addr, 0, sizeof(mac_addr));
+        smap_add(&t->info, INTERFACE_HW_INTF_INFO_MAP_MAC_ADDR,
+                 ops_ether_ulong_long_to_string(mac_addr,
+                                                subsys_ptr->system_mac_addr));
+    }
+
+    hmap_insert(&hw_intf_templates, &t->node, hash);
+
+    return t;
+
+} /* hw_intf_template_create */
+
+/* Frees the templates, which must be done before the port descriptions
+ * they point into are freed. */
+void
+sysd_hw_intf_templates_clear(void)
+{
+    struct hw_intf_template *t;
+    struct hw_intf_template *next;
+
+    HMAP_FOR_EACH_SAFE (t, next, node, &hw_intf_templates) {
+        hmap_remove(&hw_intf_templates, &t->node);
+        smap_destroy(&t->info);
+        free(t);
     }
 
+} /* sysd_hw_intf_templates_clear */
+
+/*
+ * Fills 'hw_intf_info' with the hardware description of interface
+ * 'intf_ptr' of subsystem 'subsys_ptr'. 'hw_intf_info' must be initialized.
+ */
+void
+sysd_build_hw_intf_info(struct smap *hw_intf_info,
+                        const sysd_subsystem_t *subsys_ptr,
+                        const sysd_intf_info_t *intf_ptr)
+{
+    struct hw_intf_template *t;
+    struct hw_intf_template *found = NULL;
+    struct smap_node        *node;
+    uint32_t                hash;
+
+    hash = hw_intf_template_hash(subsys_ptr, intf_ptr);
+    HMAP_FOR_EACH_WITH_HASH (t, node, hash, &hw_intf_templates) {
+        if (hw_intf_template_matches(t, subsys_ptr, intf_ptr)) {
+            found = t;
+            break;
+        }
+    }
+    t = found ? found : hw_intf_template_create(subsys_ptr, intf_ptr, hash);
+
+    hmap_reserve(&hw_intf_info->map, smap_count(&t->info) + 2);
+    SMAP_FOR_EACH (node, &t->info) {
+        smap_add(hw_intf_info, node->key, node->value);
+    }
+    smap_add_format(hw_intf_info, INTERFACE_HW_INTF_INFO_MAP_SWITCH_UNIT,
+                    "%d", intf_ptr->device);
+    smap_add_format(hw_intf_info, INTERFACE_HW_INTF_INFO_MAP_SWITCH_INTF_ID,
+                    "%d", intf_ptr->device_port);
+
+} /* sysd_build_hw_intf_info */
+
+struct ovsrec_interface *
+sysd_initial_interface_add(struct ovsdb_idl_txn *txn,
+                           sysd_subsystem_t *subsys_ptr,
+                           sysd_intf_info_t *intf_ptr)
+{
+    struct ovsrec_interface     *ovs_intf = NULL;
+    struct smap                 hw_intf_info;
+
+    ovs_intf = ovsrec_interface_insert(txn);
+    sysd_golden_note_insert(&ovsrec_table_interface, &ovs_intf->header_);
+    sysd_metrics_rows_written(&ovsrec_table_interface, 1);
+
+    ovsrec_interface_set_name(ovs_intf, intf_ptr->name);
+
+    ovsrec_interface_set_type(ovs_intf, OVSREC_INTERFACE_TYPE_SYSTEM);
+
+    ovsrec_interface_set_admin_state(ovs_intf, OVSREC_INTERFACE_ADMIN_STATE_DOWN);
+
+    smap_init(&hw_intf_info);
+    sysd_build_hw_intf_info(&hw_intf_info, subsys_ptr, intf_ptr);
     ovsrec_interface_set_hw_intf_info(ovs_intf, &hw_intf_info);
     smap_destroy(&hw_intf_info);
 
@@ -190,15 +361,18 @@ sysd_initial_interface_add(struct ovsdb_idl_txn *txn,
 
 } /* sysd_initial_interface_add */
 
+/* Sets the split parent and children of the 'n' interfaces in 'intfs',
+ * whose rows are 'ovs_intf'. Families must not span calls. */
 void
-sysd_set_splittable_port_info(struct ovsrec_interface **ovs_intf, sysd_subsystem_t *subsys_ptr)
+sysd_set_splittable_port_info(sysd_intf_info_t **intfs,
+                              struct ovsrec_interface **ovs_intf, int n)
 {
     int                 i = 0;
     sysd_intf_info_t    *intf_ptr = NULL;
     struct shash        ovs_intf_shash = SHASH_INITIALIZER(&ovs_intf_shash);
 
-    for (i = 0; i < subsys_ptr->intf_count; i++) {
-        intf_ptr = subsys_ptr->interfaces[i];
+    for (i = 0; i < n; i++) {
+        intf_ptr = intfs[i];
 
         if ((intf_ptr->subports[0] != NULL) ||
             (intf_ptr->parent_port != NULL)) {
@@ -207,8 +381,8 @@ sysd_set_splittable_port_info(struct ovsrec_interface **ovs_intf, sysd_subsystem
         }
     }
 
-    for (i = 0; i < subsys_ptr->intf_count; i++) {
-        intf_ptr = subsys_ptr->interfaces[i];
+    for (i = 0; i < n; i++) {
+        intf_ptr = intfs[i];
 
         if (intf_ptr->parent_port != NULL) {
             struct ovsrec_interface *parent = NULL;
@@ -249,6 +423,8 @@ sysd_initial_daemon_add(struct ovsdb_idl_txn *txn, daemon_info_t *daemon_ptr)
     struct ovsrec_daemon     *ovs_daemon = NULL;
 
     ovs_daemon = ovsrec_daemon_insert(txn);
+    sysd_golden_note_insert(&ovsrec_table_daemon, &ovs_daemon->header_);
+    sysd_metrics_rows_written(&ovsrec_table_daemon, 1);
 
     ovsrec_daemon_set_name(ovs_daemon, daemon_ptr->name);
     ovsrec_daemon_set_cur_hw(ovs_daemon, daemon_ptr->cur_hw);
@@ -258,11 +434,96 @@ sysd_initial_daemon_add(struct ovsdb_idl_txn *txn, daemon_info_t *daemon_ptr)
 
 } /* sysd_initial_daemon_add */
 
+/* Publishes each FRU vendor extension TLV as
+ * "vendor_extension_<IANA number>" = <hex payload>. Further extensions from
+ * the same vendor get a "_<n>" suffix, in EEPROM order. */
+static void
+sysd_add_vendor_extensions(struct smap *other_info, const fru_eeprom_t *fru)
+{
+    int         i;
+    int         j;
+    int         dup;
+    struct ds   key = DS_EMPTY_INITIALIZER;
+    struct ds   value = DS_EMPTY_INITIALIZER;
+
+    for (i = 0; i < fru->n_vendor_exts; i++) {
+        const fru_vendor_ext_t *ext = &fru->vendor_exts[i];
+
+        dup = 0;
+        for (j = 0; j < i; j++) {
+            if (fru->vendor_exts[j].iana == ext->iana) {
+                dup++;
+            }
+        }
+
+        ds_clear(&key);
+        ds_put_format(&key, "vendor_extension_%"PRIu32, ext->iana);
+        if (dup) {
+            ds_put_format(&key, "_%d", dup);
+        }
+
+        ds_clear(&value);
+        for (j = 0; j < ext->len; j++) {
+            ds_put_format(&value, "%02x", ext->data[j]);
+        }
+
+        smap_add(other_info, ds_cstr(&key), ds_cstr(&value));
+    }
+
+    ds_destroy(&key);
+    ds_destroy(&value);
+
+} /* sysd_add_vendor_extensions */
+
+/* Fills 'other_info' with the Subsystem other_info of 'subsys_ptr': its
+ * FRU EEPROM contents and interface limits. */
+void
+sysd_build_subsystem_other_info(struct smap *other_info,
+                                const sysd_subsystem_t *subsys_ptr)
+{
+    const fru_eeprom_t *fru = &subsys_ptr->fru_eeprom;
+
+    smap_add(other_info, "country_code", fru->country_code);
+    smap_add_format(other_info, "device_version", "%c", fru->device_version);
+    smap_add(other_info, "diag_version", fru->diag_version ? : "");
+    smap_add(other_info, "label_revision", fru->label_revision ? : "");
+    smap_add_format(other_info, "base_mac_address",
+                    "%02x:%02x:%02x:%02x:%02x:%02x",
+                    SYSD_MAC_FORMAT(fru->base_mac_address));
+    smap_add_format(other_info, "number_of_macs", "%d", fru->num_macs);
+    smap_add(other_info, "manufacturer", fru->manufacturer ? : "");
+    smap_add(other_info, "manufacture_date", fru->manufacture_date);
+    smap_add(other_info, "onie_version", fru->onie_version ? : "");
+    smap_add(other_info, "part_number", fru->part_number ? : "");
+    smap_add(other_info, "Product Name", fru->product_name ? : "");
+    smap_add(other_info, "platform_name", fru->platform_name ? : "");
+    smap_add(other_info, "serial_number", fru->serial_number ? : "");
+    smap_add(other_info, "vendor", fru->vendor ? : "");
+    sysd_add_vendor_extensions(other_info, fru);
+
+    smap_add_format(other_info, "interface_count",
+                    "%d", subsys_ptr->intf_cmn_info->number_ports);
+    smap_add_format(other_info, "max_interface_speed",
+                    "%d", subsys_ptr->intf_cmn_info->max_port_speed);
+    smap_add_format(other_info, "max_transmission_unit",
+                    "%d", subsys_ptr->intf_cmn_info->max_transmission_unit);
+    smap_add_format(other_info, "max_bond_count",
+                    "%d", subsys_ptr->intf_cmn_info->max_lag_count);
+    smap_add_format(other_info, "max_bond_member_count",
+                    "%d", subsys_ptr->intf_cmn_info->max_lag_member_count);
+    smap_add_format(other_info, "l3_port_requires_internal_vlan",
+                    "%d", subsys_ptr->intf_cmn_info->l3_port_requires_internal_vlan);
+
+} /* sysd_build_subsystem_other_info */
+
+/* Inserts the Subsystem row for 'subsys_ptr'. Its interfaces are inserted
+ * too unless 'add_interfaces' is false, in which case they are left to
+ * sysd_interface_batch_build(). */
 struct ovsrec_subsystem *
-sysd_initial_subsystem_add(struct ovsdb_idl_txn *txn, sysd_subsystem_t *subsys_ptr)
+sysd_initial_subsystem_add(struct ovsdb_idl_txn *txn, sysd_subsystem_t *subsys_ptr,
+                           bool add_interfaces)
 {
     int                         i = 0;
-    fru_eeprom_t                *fru = NULL;
     char                        mac_addr[32];
     char                        *tmp_p;
 
@@ -271,48 +532,29 @@ sysd_initial_subsystem_add(struct ovsdb_idl_txn *txn, sysd_subsystem_t *subsys_p
     struct ovsrec_interface     **ovs_intf = NULL;
 
     ovs_subsys = ovsrec_subsystem_insert(txn);
-
-    fru = &(subsys_ptr->fru_eeprom);
+    sysd_golden_note_insert(&ovsrec_table_subsystem, &ovs_subsys->header_);
+    sysd_metrics_rows_written(&ovsrec_table_subsystem, 1);
 
     ovsrec_subsystem_set_name(ovs_subsys, subsys_ptr->name);
     ovsrec_subsystem_set_asset_tag_number(ovs_subsys, DFLT_ASSET_TAG);
     ovsrec_subsystem_set_hw_desc_dir(ovs_subsys, g_hw_desc_dir);
 
     smap_init(&other_info);
-
-    smap_add(&other_info, "country_code", fru->country_code);
-    smap_add_format(&other_info, "device_version", "%c", fru->device_version);
-    smap_add(&other_info, "diag_version", fru->diag_version ? : "");
-    smap_add(&other_info, "label_revision", fru->label_revision ? : "");
-    smap_add_format(&other_info, "base_mac_address",
-                    "%02x:%02x:%02x:%02x:%02x:%02x",
-                    SYSD_MAC_FORMAT(fru->base_mac_address));
-    smap_add_format(&other_info, "number_of_macs", "%d", fru->num_macs);
-    smap_add(&other_info, "manufacturer", fru->manufacturer ? : "");
-    smap_add(&other_info, "manufacture_date", fru->manufacture_date ? : "");
-    smap_add(&other_info, "onie_version", fru->onie_version ? : "");
-    smap_add(&other_info, "part_number", fru->part_number ? : "");
-    smap_add(&other_info, "Product Name", fru->product_name ? : "");
-    smap_add(&other_info, "platform_name", fru->platform_name ? : "");
-    smap_add(&other_info, "serial_number", fru->serial_number ? : "");
-    smap_add(&other_info, "vendor", fru->vendor ? : "");
-
-    smap_add_format(&other_info, "interface_count",
-                    "%d", subsys_ptr->intf_cmn_info->number_ports);
-    smap_add_format(&other_info, "max_interface_speed",
-                    "%d", subsys_ptr->intf_cmn_info->max_port_speed);
-    smap_add_format(&other_info, "max_transmission_unit",
-                    "%d", subsys_ptr->intf_cmn_info->max_transmission_unit);
-    smap_add_format(&other_info, "max_bond_count",
-                    "%d", subsys_ptr->intf_cmn_info->max_lag_count);
-    smap_add_format(&other_info, "max_bond_member_count",
-                    "%d", subsys_ptr->intf_cmn_info->max_lag_member_count);
-    smap_add_format(&other_info, "l3_port_requires_internal_vlan",
-                    "%d", subsys_ptr->intf_cmn_info->l3_port_requires_internal_vlan);
+    sysd_build_subsystem_other_info(&other_info, subsys_ptr);
 
     ovsrec_subsystem_set_other_info(ovs_subsys, &other_info);
     smap_destroy(&other_info);
 
+    /* Save next_mac_address and macs_remaining in subsystem */
+    memset(mac_addr, 0, sizeof(mac_addr));
+    tmp_p = ops_ether_ulong_long_to_string(mac_addr, subsys_ptr->nxt_mac_addr);
+    ovsrec_subsystem_set_next_mac_address(ovs_subsys, tmp_p);
+    ovsrec_subsystem_set_macs_remaining(ovs_subsys, subsys_ptr->num_free_macs);
+
+    if (!add_interfaces) {
+        return ovs_subsys;
+    }
+
     ovs_intf = SYSD_OVS_PTR_CALLOC(ovsrec_interface *, subsys_ptr->intf_count);
     if (ovs_intf == NULL) {
         VLOG_ERR("Failed to allocate memory for OVS subsystem interfaces.");
@@ -325,13 +567,8 @@ sysd_initial_subsystem_add(struct ovsdb_idl_txn *txn, sysd_subsystem_t *subsys_p
         ovs_intf[i] = sysd_initial_interface_add(txn, subsys_ptr, subsys_ptr->interfaces[i]);
     }
 
-    sysd_set_splittable_port_info(ovs_intf, subsys_ptr);
-
-    /* Save next_mac_address and macs_remaining in subsystem */
-    memset(mac_addr, 0, sizeof(mac_addr));
-    tmp_p = ops_ether_ulong_long_to_string(mac_addr, subsys_ptr->nxt_mac_addr);
-    ovsrec_subsystem_set_next_mac_address(ovs_subsys, tmp_p);
-    ovsrec_subsystem_set_macs_remaining(ovs_subsys, subsys_ptr->num_free_macs);
+    sysd_set_splittable_port_info(subsys_ptr->interfaces, ovs_intf,
+                                  subsys_ptr->intf_count);
 
     ovsrec_subsystem_set_interfaces(ovs_subsys, ovs_intf, i);
 
@@ -342,21 +579,55 @@ sysd_initial_subsystem_add(struct ovsdb_idl_txn *txn, sysd_subsystem_t *subsys_p
 } /* sysd_initial_subsystem_add */
 
 /*
- * This function is used to initialize the default bridge during system bootup.
+ * Inserts a bridge of the default topology with its VLANs and, unless the
+ * template says otherwise, its internal interface and port.
  */
-void
+static struct ovsrec_bridge *
 sysd_configure_default_bridge(struct ovsdb_idl_txn *txn,
-                              struct ovsrec_system *ovs_row)
+                              const sysd_default_bridge_t *tmpl)
 {
     struct ovsrec_bridge *default_bridge_row = NULL;
     struct ovsrec_port *port = NULL;
     struct ovsrec_interface *iface = NULL;
+    struct ovsrec_vlan **vlans;
     struct smap hw_intf_info, user_config;
+    char vlan_name[16];
+    size_t i;
 
     /* Create bridge */
     default_bridge_row = ovsrec_bridge_insert(txn);
-    ovsrec_bridge_set_name(default_bridge_row, DEFAULT_BRIDGE_NAME);
-    ovsrec_system_set_bridges(ovs_row, &default_bridge_row, 1);
+    sysd_golden_note_insert(&ovsrec_table_bridge,
+                            &default_bridge_row->header_);
+    sysd_metrics_rows_written(&ovsrec_table_bridge, 1);
+    ovsrec_bridge_set_name(default_bridge_row, tmpl->name);
+
+    /* All of the bridge's VLANs are set in one go. */
+    if (tmpl->n_vlans) {
+        vlans = xmalloc(tmpl->n_vlans * sizeof *vlans);
+        for (i = 0; i < tmpl->n_vlans; i++) {
+            const sysd_default_vlan_t *vlan = &tmpl->vlans[i];
+
+            vlans[i] = ovsrec_vlan_insert(txn);
+            sysd_golden_note_insert(&ovsrec_table_vlan, &vlans[i]->header_);
+            ovsrec_vlan_set_id(vlans[i], vlan->id);
+            if (vlan->name == NULL) {
+                snprintf(vlan_name, sizeof vlan_name, "VLAN%"PRId64,
+                         vlan->id);
+            }
+            ovsrec_vlan_set_name(vlans[i], vlan->name ? vlan->name
+                                                      : vlan_name);
+            ovsrec_vlan_set_admin(vlans[i], vlan->admin_up
+                                            ? OVSREC_VLAN_ADMIN_UP
+                                            : OVSREC_VLAN_ADMIN_DOWN);
+        }
+        sysd_metrics_rows_written(&ovsrec_table_vlan, tmpl->n_vlans);
+        ovsrec_bridge_set_vlans(default_bridge_row, vlans, tmpl->n_vlans);
+        free(vlans);
+    }
+
+    if (!tmpl->internal_port) {
+        return default_bridge_row;
+    }
 
     /*
      * For every bridge we will create a bridge port and a bridge
@@ -370,7 +641,9 @@ sysd_configure_default_bridge(struct ovsdb_idl_txn *txn,
 
     /* Create bridge internal interface */
     iface = ovsrec_interface_insert(txn);
-    ovsrec_interface_set_name(iface, DEFAULT_BRIDGE_NAME);
+    sysd_golden_note_insert(&ovsrec_table_interface, &iface->header_);
+    sysd_metrics_rows_written(&ovsrec_table_interface, 1);
+    ovsrec_interface_set_name(iface, tmpl->name);
     ovsrec_interface_set_type(iface, OVSREC_INTERFACE_TYPE_INTERNAL);
 
     smap_init(&hw_intf_info);
@@ -393,7 +666,9 @@ sysd_configure_default_bridge(struct ovsdb_idl_txn *txn,
 
     /* Create port for bridge */
     port = ovsrec_port_insert(txn);
-    ovsrec_port_set_name(port, DEFAULT_BRIDGE_NAME);
+    sysd_golden_note_insert(&ovsrec_table_port, &port->header_);
+    sysd_metrics_rows_written(&ovsrec_table_port, 1);
+    ovsrec_port_set_name(port, tmpl->name);
 
     /* Add the internal interface to port */
     ovsrec_port_set_interfaces(port, &iface, 1);
@@ -401,35 +676,74 @@ sysd_configure_default_bridge(struct ovsdb_idl_txn *txn,
     /* Add port to the bridge */
     ovsrec_bridge_set_ports(default_bridge_row, &port, 1);
 
+    return default_bridge_row;
+
 }/* sysd_configure_default_bridge */
 
 /*
- * This function is used to initialize the default VRF during system bootup.
+ * Inserts a VRF of the default topology. Only the default VRF exists as
+ * soon as the system boots, so only it is marked ready here.
  */
-void
+static struct ovsrec_vrf *
 sysd_configure_default_vrf(struct ovsdb_idl_txn *txn,
-                           struct ovsrec_system *ovs_row)
+                           const sysd_default_vrf_t *tmpl)
 {
     struct ovsrec_vrf *default_vrf_row = NULL;
     struct smap smap_vrf_status;
-    const int64_t table_id = 0;
 
     default_vrf_row = ovsrec_vrf_insert(txn);
-    ovsrec_vrf_set_name(default_vrf_row, DEFAULT_VRF_NAME);
-    ovsrec_system_set_vrfs(ovs_row, &default_vrf_row, 1);
-    ovsrec_vrf_set_table_id(default_vrf_row, &table_id, sizeof(table_id));
-    smap_clone(&smap_vrf_status, &default_vrf_row->status);
-    smap_add_once(&smap_vrf_status, VRF_STATUS_KEY, VRF_STATUS_VALUE);
+    sysd_golden_note_insert(&ovsrec_table_vrf, &default_vrf_row->header_);
+    sysd_metrics_rows_written(&ovsrec_table_vrf, 1);
+    ovsrec_vrf_set_name(default_vrf_row, tmpl->name);
+    if (tmpl->has_table_id) {
+        ovsrec_vrf_set_table_id(default_vrf_row, &tmpl->table_id, 1);
+    }
+    if (!strcmp(tmpl->name, DEFAULT_VRF_NAME)) {
+        smap_clone(&smap_vrf_status, &default_vrf_row->status);
+        smap_add_once(&smap_vrf_status, VRF_STATUS_KEY, VRF_STATUS_VALUE);
+
+        ovsrec_vrf_set_status(default_vrf_row, &smap_vrf_status);
+        smap_destroy(&smap_vrf_status);
+    }
 
-    ovsrec_vrf_set_status(default_vrf_row, &smap_vrf_status);
-    smap_destroy(&smap_vrf_status);
+    return default_vrf_row;
 
 }/* sysd_configure_default_vrf */
 
+/*
+ * Inserts the bridges and VRFs of the default topology template, setting
+ * System:bridges and System:vrfs once each.
+ */
+static void
+sysd_configure_default_topology(struct ovsdb_idl_txn *txn,
+                                struct ovsrec_system *ovs_row)
+{
+    const sysd_defaults_t *defaults = sysd_defaults_get();
+    struct ovsrec_bridge **bridges;
+    struct ovsrec_vrf **vrfs;
+    size_t i;
+
+    bridges = xmalloc(defaults->n_bridges * sizeof *bridges);
+    for (i = 0; i < defaults->n_bridges; i++) {
+        bridges[i] = sysd_configure_default_bridge(txn,
+                                                   &defaults->bridges[i]);
+    }
+    ovsrec_system_set_bridges(ovs_row, bridges, defaults->n_bridges);
+    free(bridges);
+
+    vrfs = xmalloc(defaults->n_vrfs * sizeof *vrfs);
+    for (i = 0; i < defaults->n_vrfs; i++) {
+        vrfs[i] = sysd_configure_default_vrf(txn, &defaults->vrfs[i]);
+    }
+    ovsrec_system_set_vrfs(ovs_row, vrfs, defaults->n_vrfs);
+    free(vrfs);
+
+} /* sysd_configure_default_topology */
+
 /*
  * Helper function to parse version_detail yaml file.
  */
-static int
+int
 package_info_mapping_check_key(const char *data)
 {
     int i = PKG;
@@ -443,42 +757,235 @@ package_info_mapping_check_key(const char *data)
     return VALUE;
 }
 
+/* One package from version_detail.yaml. */
+struct package_info {
+    char    *name;
+    char    *version;
+    char    *src_url;
+    char    *src_type;
+};
+
+/* Packages parsed by sysd_add_package_info(), inserted into Package_Info
+ * PKG_INFO_ENTRIES_PER_COMMIT at a time by one write job per batch. */
+static struct package_info  *pkgs;
+static size_t               n_pkgs;
+static size_t               pkg_batches_pending;
+static long long            pkg_queued_at;
+static uint64_t             pkg_phase;
+
+/* Package_Info is filled once per version_detail file, and its rows are
+ * replicated only while sysd fills it. */
+static enum {
+    PKG_INFO_UNKNOWN,       /* System row not seen yet. */
+    PKG_INFO_LOADING,       /* Written from another file, or never. */
+    PKG_INFO_DONE,
+} pkg_info_state = PKG_INFO_UNKNOWN;
+static bool                 pkg_info_queued;
+static bool                 pkg_info_failed;
+static char                 pkg_digest[SHA1_HEX_DIGEST_LEN + 1];
+
+static void
+package_info_set(char **field, const yaml_event_t *event)
+{
+    free(*field);
+    *field = xstrdup((const char *) event->data.scalar.value);
+
+} /* package_info_set */
+
+static bool
+sysd_package_info_build(struct ovsdb_idl_txn *txn, void *start_)
+{
+    const struct ovsrec_package_info *old;
+    size_t start = (uintptr_t) start_;
+    size_t end = MIN(start + PKG_INFO_ENTRIES_PER_COMMIT, n_pkgs);
+    size_t i;
+
+    /* A batch is committed whole, so if its first package is there, an
+     * earlier attempt went through but its reply was lost. */
+    OVSREC_PACKAGE_INFO_FOR_EACH(old, idl) {
+        if (old->name && !strcmp(old->name, pkgs[start].name)) {
+            return false;
+        }
+    }
+
+    for (i = start; i < end; i++) {
+        struct ovsrec_package_info *row = ovsrec_package_info_insert(txn);
+
+        ovsrec_package_info_set_name(row, pkgs[i].name);
+        if (pkgs[i].version) {
+            ovsrec_package_info_set_version(row, pkgs[i].version);
+        }
+        if (pkgs[i].src_url) {
+            ovsrec_package_info_set_src_url(row, pkgs[i].src_url);
+        }
+        if (pkgs[i].src_type) {
+            ovsrec_package_info_set_src_type(row, pkgs[i].src_type);
+        }
+    }
+    sysd_metrics_rows_written(&ovsrec_table_package_info, end - start);
+
+    return true;
+
+} /* sysd_package_info_build */
+
+static bool
+sysd_package_info_mark_build(struct ovsdb_idl_txn *txn OVS_UNUSED,
+                             void *aux OVS_UNUSED)
+{
+    const struct ovsrec_system  *cfg = ovsrec_system_first(idl);
+    const char                  *digest;
+    struct smap                 other_info;
+
+    if (cfg == NULL) {
+        return false;
+    }
+    digest = smap_get(&cfg->other_info, PKG_INFO_DIGEST_KEY);
+    if (digest && !strcmp(digest, pkg_digest)) {
+        return false;
+    }
+
+    smap_clone(&other_info, &cfg->other_info);
+    smap_replace(&other_info, PKG_INFO_DIGEST_KEY, pkg_digest);
+    ovsrec_system_set_other_info(cfg, &other_info);
+    smap_destroy(&other_info);
+    sysd_metrics_rows_written(&ovsrec_table_system, 1);
+
+    return true;
+
+} /* sysd_package_info_mark_build */
+
+static void
+sysd_package_info_mark_done(enum ovsdb_idl_txn_status status,
+                            void *aux OVS_UNUSED)
+{
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        VLOG_ERR("Failed to record the Package_Info source. rc = %s",
+                 ovsdb_idl_txn_status_to_string(status));
+    }
+    pkg_info_state = PKG_INFO_DONE;
+
+} /* sysd_package_info_mark_done */
+
+/* Records the file Package_Info was filled from, unless a batch failed.
+ * Then sysd stops replicating Package_Info either way: the rows are
+ * written again from scratch on the next start. */
+static void
+sysd_package_info_finish(void)
+{
+    if (pkg_info_failed) {
+        VLOG_ERR("Package_Info is incomplete, it will be written again when "
+                 "ops-sysd restarts");
+        pkg_info_state = PKG_INFO_DONE;
+        return;
+    }
+    sysd_txn_submit(SYSD_TXN_PACKAGE_INFO, sysd_package_info_mark_build,
+                    sysd_package_info_mark_done, NULL);
+
+} /* sysd_package_info_finish */
+
+/* Deletes the Package_Info rows left from another version_detail file. */
+static bool
+sysd_package_info_clear_build(struct ovsdb_idl_txn *txn OVS_UNUSED,
+                              void *aux OVS_UNUSED)
+{
+    const struct ovsrec_package_info *row, *next;
+    unsigned int n = 0;
+
+    OVSREC_PACKAGE_INFO_FOR_EACH_SAFE(row, next, idl) {
+        ovsrec_package_info_delete(row);
+        n++;
+    }
+    sysd_metrics_rows_written(&ovsrec_table_package_info, n);
+
+    return n != 0;
+
+} /* sysd_package_info_clear_build */
+
+static void
+sysd_package_info_clear_done(enum ovsdb_idl_txn_status status,
+                             void *aux OVS_UNUSED)
+{
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        VLOG_ERR("Failed to remove old Package_Info rows. rc = %s",
+                 ovsdb_idl_txn_status_to_string(status));
+        pkg_info_failed = true;
+    }
+
+} /* sysd_package_info_clear_done */
+
+static void
+sysd_package_info_done(enum ovsdb_idl_txn_status status, void *start_)
+{
+    size_t start = (uintptr_t) start_;
+    size_t i;
+
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        VLOG_ERR("Commit failed to Package_Info for entries %"PRIuSIZE
+                 " and on. rc = %s", start,
+                 ovsdb_idl_txn_status_to_string(status));
+        pkg_info_failed = true;
+    }
+    if (--pkg_batches_pending) {
+        return;
+    }
+
+    VLOG_INFO("Package_Info populated with %"PRIuSIZE" entries in %lld ms",
+              n_pkgs, time_msec() - pkg_queued_at);
+    sysd_trace_phase_stop("package_info", pkg_phase);
+
+    for (i = 0; i < n_pkgs; i++) {
+        free(pkgs[i].name);
+        free(pkgs[i].version);
+        free(pkgs[i].src_url);
+        free(pkgs[i].src_type);
+    }
+    free(pkgs);
+    pkgs = NULL;
+    n_pkgs = 0;
+
+    sysd_package_info_finish();
+
+} /* sysd_package_info_done */
+
 /*
  * Function to populate source url, type and version of each package/daemon
  * extracted from /var/lib/version_detail.yaml file to "Package_Info"
- * table in OVSDB.
+ * table in OVSDB. Returns false if the file could not be read.
  */
-static void
+static bool
 sysd_add_package_info()
 {
     FILE * fh         = NULL;
     int event_value   = 0;
     int current_state = 0;
-    int record_count  = 0;
     int done          = 0;
+    size_t allocated  = 0;
+    size_t start;
     yaml_parser_t parser;
     yaml_event_t event;
-    struct ovsrec_package_info *row  = NULL;
-    struct ovsdb_idl_txn       *txn  = NULL;
-    enum ovsdb_idl_txn_status  txn_status = TXN_ERROR;
+    struct package_info *pkg = NULL;
 
     /* Initialize parser */
     if (!yaml_parser_initialize(&parser)) {
         VLOG_ERR("Failed to initialize parser\n");
-        return;
+        return false;
     }
 
     /* Open /var/lib/version_detail.yaml file */
-    fh = fopen(VERSION_DETAIL_FILE_PATH, "r");
+    fh = fopen(version_detail_file, "r");
     if (NULL == fh) {
-        VLOG_ERR("Failed to open file %s\n",VERSION_DETAIL_FILE_PATH);
+        VLOG_ERR("Failed to open file %s\n", version_detail_file);
+        sysd_trace(SYSD_TRACE_FILE, version_detail_file, 0, 0, errno);
         yaml_parser_delete(&parser);
-        return;
+        return false;
     }
 
     /* Set input file */
     yaml_parser_set_input_file(&parser, fh);
 
+    pkg_queued_at = time_msec();
+    pkg_phase = sysd_trace_phase_start("package_info");
+
     /*
      * Parse version_detail file line-wise to extract package/daemon name,
      * corresponding type, version and its source-URL.
@@ -496,61 +1003,34 @@ sysd_add_package_info()
             switch (event_value) {
                 case VALUE:
                 {
+                    if (current_state != PKG && pkg == NULL) {
+                        break;
+                    }
                     switch(current_state) {
                         case PKG:
-                            if ((record_count % PKG_INFO_ENTRIES_PER_COMMIT) == 0) {
-                                txn = ovsdb_idl_txn_create(idl);
-                            }
-                            row = ovsrec_package_info_insert(txn);
-                            if (NULL == row) {
-                                VLOG_ERR("Could not insert a row into DB\n");
-                                /* Cleanup */
-                                yaml_event_delete(&event);
-                                yaml_parser_delete(&parser);
-                                fclose(fh);
-                                ovsdb_idl_txn_destroy(txn);
-                                return;
+                            if (n_pkgs >= allocated) {
+                                pkgs = x2nrealloc(pkgs, &allocated,
+                                                  sizeof *pkgs);
                             }
-                            ovsrec_package_info_set_name(row,
-                            (const char *)event.data.scalar.value);
+                            pkg = &pkgs[n_pkgs++];
+                            memset(pkg, 0, sizeof *pkg);
+                            package_info_set(&pkg->name, &event);
                             break;
                         case PV:
-                            ovsrec_package_info_set_version(row,
-                            (const char *)event.data.scalar.value);
+                            package_info_set(&pkg->version, &event);
                             break;
                         case SRCREV:
                             if(((const char*)event.data.scalar.value != NULL)
                             && strcmp((const char*)event.data.scalar.value,
                             "INVALID")) {
-                                ovsrec_package_info_set_version(row,
-                                (const char *)event.data.scalar.value);
+                                package_info_set(&pkg->version, &event);
                             }
                             break;
                         case SRC_URL:
-                            ovsrec_package_info_set_src_url(row,
-                            (const char *)event.data.scalar.value);
+                            package_info_set(&pkg->src_url, &event);
                             break;
                         case TYPE:
-                            record_count++;
-                            ovsrec_package_info_set_src_type(row,
-                            (const char *)event.data.scalar.value);
-
-                            /*
-                             * Commit the transaction for every
-                             * PKG_INFO_ENTRIES_PER_COMMIT entries
-                             */
-                            if ((record_count % PKG_INFO_ENTRIES_PER_COMMIT)
-                                == 0) {
-                                txn_status = ovsdb_idl_txn_commit_block(txn);
-                                VLOG_INFO("Populating Package_Info with"
-                                          "%d entries\n", record_count);
-                                if (txn_status != TXN_SUCCESS) {
-                                    VLOG_ERR("Commit failed to Package_Info."
-                                             "rc = %u", txn_status);
-                                }
-                                ovsdb_idl_txn_destroy(txn);
-                                txn = NULL;
-                            }
+                            package_info_set(&pkg->src_type, &event);
                             break;
                     }
                 }
@@ -578,41 +1058,135 @@ sysd_add_package_info()
         yaml_event_delete(&event);
     }
 
-    if (txn != NULL) {
-        txn_status = ovsdb_idl_txn_commit_block(txn);
-        VLOG_INFO("Populating Package_Info with %d entries\n", record_count);
-        if (txn_status != TXN_SUCCESS) {
-            VLOG_ERR("Commit failed to Package_Info. rc = %u", txn_status);
-        }
-        ovsdb_idl_txn_destroy(txn);
-        txn = NULL;
-    }
+    sysd_metrics_package_info_rows(n_pkgs);
+    sysd_trace(SYSD_TRACE_FILE, version_detail_file, n_pkgs, 0, 0);
 
     /* Cleanup */
     yaml_parser_delete(&parser);
     fclose(fh);
 
-} /* sysd_add_package_info */
+    if (n_pkgs == 0) {
+        sysd_trace_phase_stop("package_info", pkg_phase);
+        free(pkgs);
+        pkgs = NULL;
+        sysd_package_info_finish();
+        return true;
+    }
+
+    /* Commit the rows PKG_INFO_ENTRIES_PER_COMMIT at a time. */
+    for (start = 0; start < n_pkgs; start += PKG_INFO_ENTRIES_PER_COMMIT) {
+        pkg_batches_pending++;
+        sysd_txn_submit(SYSD_TXN_PACKAGE_INFO, sysd_package_info_build,
+                        sysd_package_info_done, (void *) (uintptr_t) start);
+    }
+
+    return true;
+
+} /* sysd_add_package_info */
+
+/* Hashes the version_detail file into 'pkg_digest'. Returns false if it
+ * cannot be read. */
+static bool
+sysd_package_info_digest(void)
+{
+    uint8_t         digest[SHA1_DIGEST_SIZE];
+    struct sha1_ctx ctx;
+    char            buf[4096];
+    size_t          n;
+    FILE            *fp;
+
+    fp = fopen(version_detail_file, "r");
+    if (fp == NULL) {
+        VLOG_ERR("Failed to open file %s", version_detail_file);
+        sysd_trace(SYSD_TRACE_FILE, version_detail_file, 0, 0, errno);
+        return false;
+    }
+    sha1_init(&ctx);
+    while ((n = fread(buf, 1, sizeof buf, fp)) > 0) {
+        sha1_update(&ctx, buf, n);
+    }
+    fclose(fp);
+    sha1_final(&ctx, digest);
+    sha1_to_hex(digest, pkg_digest);
+
+    return true;
+
+} /* sysd_package_info_digest */
+
+/* Decides, once the System row is there, whether Package_Info must be
+ * written: only if the System row does not record the current
+ * version_detail file as its source. Until then, and after it is written,
+ * sysd does not replicate Package_Info. */
+static void
+sysd_package_info_check(const struct ovsrec_system *cfg)
+{
+    const char *digest;
+
+    if (pkg_info_state != PKG_INFO_UNKNOWN || cfg == NULL) {
+        return;
+    }
+
+    if (!sysd_package_info_digest()) {
+        pkg_info_state = PKG_INFO_DONE;
+        return;
+    }
+    digest = smap_get(&cfg->other_info, PKG_INFO_DIGEST_KEY);
+    if (digest && !strcmp(digest, pkg_digest)) {
+        VLOG_INFO("Package_Info is up to date with %s", version_detail_file);
+        pkg_info_state = PKG_INFO_DONE;
+    } else {
+        pkg_info_state = PKG_INFO_LOADING;
+    }
+
+} /* sysd_package_info_check */
+
+/* Replaces the Package_Info rows, once they have been replicated. */
+static void
+sysd_package_info_run(void)
+{
+    if (pkg_info_state != PKG_INFO_LOADING || pkg_info_queued
+        || !sysd_monitor_synced()) {
+        return;
+    }
+
+    pkg_info_queued = true;
+    if (ovsrec_package_info_first(idl) != NULL) {
+        VLOG_INFO("Package_Info was not written from %s, replacing it",
+                  version_detail_file);
+        sysd_txn_submit(SYSD_TXN_PACKAGE_INFO, sysd_package_info_clear_build,
+                        sysd_package_info_clear_done, NULL);
+    }
+    if (!sysd_add_package_info()) {
+        pkg_info_state = PKG_INFO_DONE;
+    }
+
+} /* sysd_package_info_run */
+
+/* Software info from the release file, which does not change while sysd
+ * runs, so it is read once. */
+static struct smap  sw_info = SMAP_INITIALIZER(&sw_info);
+static char         *sw_version;    /* NULL if not in the release file. */
+static bool         sw_info_loaded;
 
 /*
- * Function to update the software info, e.g. software name, switch version,
- * in the OVSDB retrieved from the Release file.
+ * Function to read the software info, e.g. software name, switch version,
+ * from the Release file.
  */
 static void
-sysd_update_sw_info(const struct ovsrec_system *cfg)
+sysd_load_sw_info(void)
 {
 #define NSTR  80 /* Max length of each line of /etc/os-release. */
-    struct smap smap = SMAP_INITIALIZER(&smap);
     FILE   *os_ver_fp = NULL;
     char   *line = NULL;
     char   *value;
     char   *name;
     char   version_id[NSTR];
     char   build_id[NSTR];
-    char   build_str[NSTR];
     size_t line_len = 0;
     int i;
 
+    sw_info_loaded = true;
+
     /* Open os-release file with the os version information */
     os_ver_fp = fopen(OS_RELEASE_FILE_PATH, "r");
     if (NULL == os_ver_fp) {
@@ -643,7 +1217,7 @@ sysd_update_sw_info(const struct ovsrec_system *cfg)
 
         /* Release name value.  */
         if (strcmp(name, OS_RELEASE_NAME) == 0 && value[0] != '\0') {
-            smap_add(&smap, SYSTEM_SOFTWARE_INFO_OS_NAME, value);
+            smap_replace(&sw_info, SYSTEM_SOFTWARE_INFO_OS_NAME, value);
 
         /* Version ID value*/
         } else if (strcmp(name, OS_RELEASE_VERSION_NAME) == 0) {
@@ -667,25 +1241,75 @@ sysd_update_sw_info(const struct ovsrec_system *cfg)
         free(line);
     }
 
-    /* Update the software info column. */
-    if (!smap_is_empty(&smap)) {
-        ovsrec_system_set_software_info(cfg, &smap);
-    }
-    smap_destroy(&smap);
-
     /* Check if version id and build id was found*/
     if (build_id[0] != '\0' && version_id[0] != '\0') {
         /* Building the version string */
-        snprintf(build_str, NSTR, "%s (Build: %s)", version_id, build_id);
-        ovsrec_system_set_switch_version(cfg, build_str);
+        sw_version = xasprintf("%s (Build: %s)", version_id, build_id);
     } else {
         VLOG_ERR("%s or %s was not found on %s", OS_RELEASE_VERSION_NAME,
                  OS_RELEASE_BUILD_NAME, OS_RELEASE_FILE_PATH);
-        return;
     }
 
+} /* sysd_load_sw_info */
+
+/*
+ * Function to update the software info, e.g. software name, switch version,
+ * in the OVSDB retrieved from the Release file. Only columns that differ
+ * are written. Returns true if any was.
+ */
+static bool
+sysd_update_sw_info(const struct ovsrec_system *cfg)
+{
+    bool changed = false;
+
+    if (!sw_info_loaded) {
+        sysd_load_sw_info();
+    }
+
+    /* Update the software info column. */
+    if (!smap_is_empty(&sw_info)
+        && !smap_equal(&sw_info, &cfg->software_info)) {
+        ovsrec_system_set_software_info(cfg, &sw_info);
+        changed = true;
+    }
+
+    if (sw_version
+        && (!cfg->switch_version || strcmp(cfg->switch_version, sw_version))) {
+        ovsrec_system_set_switch_version(cfg, sw_version);
+        changed = true;
+    }
+
+    return changed;
+
 } /* sysd_update_sw_info */
 
+static bool sw_info_queued = false;
+
+static bool
+sysd_sw_info_build(struct ovsdb_idl_txn *txn OVS_UNUSED, void *aux OVS_UNUSED)
+{
+    const struct ovsrec_system *cfg = ovsrec_system_first(idl);
+
+    if (cfg == NULL || !sysd_update_sw_info(cfg)) {
+        return false;
+    }
+    sysd_metrics_rows_written(&ovsrec_table_system, 1);
+
+    return true;
+
+} /* sysd_sw_info_build */
+
+static void
+sysd_sw_info_done(enum ovsdb_idl_txn_status status, void *aux OVS_UNUSED)
+{
+    sw_info_queued = false;
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        VLOG_ERR("Failed to update the software info. rc = %s",
+                 ovsdb_idl_txn_status_to_string(status));
+    }
+
+} /* sysd_sw_info_done */
+
 /*
  * Function to handle timezone updates from OVSDB.System.timezone column
  */
@@ -716,6 +1340,7 @@ sysd_handle_timezone_update(const struct ovsrec_system *cfg)
             VLOG_ERR("Unable to create symbolic link for timezone %s err code %d\n",timezone_cmd, ret_val);
             return;
           }
+          sysd_metrics_timezone_applied();
         }
         else
         {
@@ -730,8 +1355,49 @@ sysd_handle_timezone_update(const struct ovsrec_system *cfg)
     }
 } /* sysd_handle_timezone_update */
 
+/* Change handlers, run by sysd_dispatch_run() only when the columns they
+ * were registered for change. */
+static void
+sysd_sw_info_changed(void)
+{
+    /* Writes the software info back if the System row lost it. */
+    if (!sw_info_queued && ovsrec_system_first(idl) != NULL) {
+        sw_info_queued = true;
+        sysd_txn_submit(SYSD_TXN_SW_INFO, sysd_sw_info_build,
+                        sysd_sw_info_done, NULL);
+    }
+
+} /* sysd_sw_info_changed */
+
+static void
+sysd_timezone_changed(void)
+{
+    const struct ovsrec_system *cfg = ovsrec_system_first(idl);
+
+    if (cfg != NULL) {
+        sysd_handle_timezone_update(cfg);
+    }
+
+} /* sysd_timezone_changed */
+
+void
+sysd_register_change_handlers(void)
+{
+    sysd_dispatch_register("software_info", sysd_sw_info_changed,
+                           &ovsrec_table_system,
+                           &ovsrec_system_col_software_info);
+    sysd_dispatch_register("software_info", sysd_sw_info_changed,
+                           &ovsrec_table_system,
+                           &ovsrec_system_col_switch_version);
+    sysd_dispatch_register("timezone", sysd_timezone_changed,
+                           &ovsrec_table_system, &ovsrec_system_col_timezone);
+
+} /* sysd_register_change_handlers */
+
+/* Builds the initial configuration into 'txn'. With 'add_interfaces'
+ * false, the Interface rows are left out for sysd_interface_batch_build(). */
 void
-sysd_initial_configure(struct ovsdb_idl_txn *txn)
+sysd_initial_configure(struct ovsdb_idl_txn *txn, bool add_interfaces)
 {
     int     i = 0;
     char    mac_addr[32];
@@ -743,6 +1409,8 @@ sysd_initial_configure(struct ovsdb_idl_txn *txn)
 
     /* Add System row */
     sys = ovsrec_system_insert(txn);
+    sysd_golden_note_insert(&ovsrec_table_system, &sys->header_);
+    sysd_metrics_rows_written(&ovsrec_table_system, 1);
 
     /* Add the interface name to ovsdb */
     smap_add(&smap, SYSTEM_MGMT_INTF_MAP_NAME, mgmt_intf->name);
@@ -750,9 +1418,8 @@ sysd_initial_configure(struct ovsdb_idl_txn *txn)
     ovsrec_system_set_mgmt_intf(sys, &smap);
     smap_destroy(&smap);
 
-    /* Add default bridge and VRF rows */
-    sysd_configure_default_bridge(txn, sys);
-    sysd_configure_default_vrf(txn, sys);
+    /* Add default bridge, VLAN and VRF rows */
+    sysd_configure_default_topology(txn, sys);
 
     /* Assign system wide mgmt i/f MAC address
      * Set System:management_mac
@@ -783,7 +1450,8 @@ sysd_initial_configure(struct ovsdb_idl_txn *txn)
     }
 
     for (i = 0; i < num_subsystems; i++) {
-        ovs_subsys_l[i] = sysd_initial_subsystem_add(txn, subsystems[i]);
+        ovs_subsys_l[i] = sysd_initial_subsystem_add(txn, subsystems[i],
+                                                     add_interfaces);
     }
 
     ovsrec_system_set_subsystems(sys, ovs_subsys_l, num_subsystems);
@@ -823,37 +1491,285 @@ sysd_initial_configure(struct ovsdb_idl_txn *txn)
     acl_init_limits(txn, sys);
 } /* sysd_initial_configure */
 
+/*
+ * Batched interface configuration.
+ *
+ * On chassis with more interfaces than intf_batch_size, the initial
+ * configuration is committed without any Interface rows, and the
+ * interfaces follow in batches of at most intf_batch_size rows, one write
+ * job each. A port and its split children always share a batch, since the
+ * split columns are only written when the rows are inserted.
+ */
+static int intf_batch_size = SYSD_INTF_BATCH_SIZE_DFLT;
+static bool intf_batched = false;
+static size_t intf_batches_pending;
+static size_t intf_batch_rows;
+static bool intf_batch_failed;
+static bool intf_recheck;
+static long long intf_queued_at;
+static uint64_t intf_phase;
+
+struct intf_batch {
+    sysd_subsystem_t        *subsys;
+    int                     n;
+    sysd_intf_info_t        *intfs[];
+};
+
+void
+sysd_set_intf_batch_size(int n)
+{
+    intf_batch_size = n;
+
+} /* sysd_set_intf_batch_size */
+
+static bool
+sysd_interface_batch_build(struct ovsdb_idl_txn *txn, void *batch_)
+{
+    struct intf_batch               *batch = batch_;
+    const struct ovsrec_subsystem   *ovs_subsys;
+    struct ovsrec_interface         **ovs_intf;
+    size_t                          n_old;
+    int                             i;
+
+    OVSREC_SUBSYSTEM_FOR_EACH(ovs_subsys, idl) {
+        if (!strcmp(ovs_subsys->name, batch->subsys->name)) {
+            break;
+        }
+    }
+    if (ovs_subsys == NULL) {
+        VLOG_ERR("Subsystem %s not found, unable to add its interfaces",
+                 batch->subsys->name);
+        return false;
+    }
+
+    /* A batch is committed whole, so if its first interface is there, an
+     * earlier attempt went through but its reply was lost. */
+    for (i = 0; i < ovs_subsys->n_interfaces; i++) {
+        if (!strcmp(ovs_subsys->interfaces[i]->name, batch->intfs[0]->name)) {
+            return false;
+        }
+    }
+
+    /* The rows are added to the subsystem in the same transaction, so they
+     * are referenced as soon as they exist. */
+    n_old = ovs_subsys->n_interfaces;
+    ovs_intf = xmalloc((n_old + batch->n) * sizeof *ovs_intf);
+    memcpy(ovs_intf, ovs_subsys->interfaces, n_old * sizeof *ovs_intf);
+
+    for (i = 0; i < batch->n; i++) {
+        ovs_intf[n_old + i] = sysd_initial_interface_add(txn, batch->subsys,
+                                                         batch->intfs[i]);
+    }
+    sysd_set_splittable_port_info(batch->intfs, ovs_intf + n_old, batch->n);
+
+    ovsrec_subsystem_set_interfaces(ovs_subsys, ovs_intf, n_old + batch->n);
+    free(ovs_intf);
+
+    return true;
+
+} /* sysd_interface_batch_build */
+
 static void
-sysd_set_hw_done(void)
+sysd_interface_batch_done(enum ovsdb_idl_txn_status status, void *batch_)
+{
+    struct intf_batch *batch = batch_;
+
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        VLOG_ERR("Commit failed to Interface for %d entries of %s from %s."
+                 " rc = %s", batch->n, batch->subsys->name,
+                 batch->intfs[0]->name,
+                 ovsdb_idl_txn_status_to_string(status));
+        intf_batch_failed = true;
+    }
+    free(batch);
+
+    if (--intf_batches_pending) {
+        return;
+    }
+    sysd_trace_phase_stop("interfaces", intf_phase);
+    if (!intf_batch_failed) {
+        VLOG_INFO("Interface table populated with %"PRIuSIZE" entries in "
+                  "%lld ms", intf_batch_rows, time_msec() - intf_queued_at);
+        return;
+    }
+
+    /* The initial configuration may have marked the database reconciled.
+     * Reconcile it after all, which adds the interfaces that are missing,
+     * before cur_hw is set. */
+    intf_batch_failed = false;
+    sysd_reconcile_reset();
+    intf_recheck = true;
+    poll_immediate_wake();
+
+} /* sysd_interface_batch_done */
+
+static void
+sysd_interface_batch_submit(sysd_subsystem_t *subsys,
+                            sysd_intf_info_t **intfs, int n)
+{
+    struct intf_batch *batch;
+
+    batch = xmalloc(sizeof *batch + n * sizeof batch->intfs[0]);
+    batch->subsys = subsys;
+    batch->n = n;
+    memcpy(batch->intfs, intfs, n * sizeof *intfs);
+
+    intf_batches_pending++;
+    sysd_txn_submit(SYSD_TXN_INTERFACES, sysd_interface_batch_build,
+                    sysd_interface_batch_done, batch);
+
+} /* sysd_interface_batch_submit */
+
+/* Queues the interfaces of every subsystem, a family at a time: each port
+ * without a parent is followed by its subports. */
+static void
+sysd_queue_interface_batches(void)
+{
+    int i;
+
+    intf_queued_at = time_msec();
+    intf_phase = sysd_trace_phase_start("interfaces");
+    intf_batch_rows = 0;
+
+    for (i = 0; i < num_subsystems; i++) {
+        sysd_subsystem_t        *subsys = subsystems[i];
+        struct shash            by_name = SHASH_INITIALIZER(&by_name);
+        sysd_intf_info_t        **order;
+        bool                    *queued;
+        int                     n_order = 0;
+        int                     start = 0;
+        int                     j;
+        int                     k;
+
+        order = xmalloc(MAX(subsys->intf_count, 1) * sizeof *order);
+        queued = xcalloc(MAX(subsys->intf_count, 1), sizeof *queued);
+        for (j = 0; j < subsys->intf_count; j++) {
+            shash_add_once(&by_name, subsys->interfaces[j]->name,
+                           (void *) (intptr_t) j);
+        }
+
+        for (j = 0; j < subsys->intf_count; j++) {
+            sysd_intf_info_t    *intf_ptr = subsys->interfaces[j];
+            int                 family = n_order;
+
+            if (queued[j] || (intf_ptr->parent_port != NULL
+                              && shash_find(&by_name, intf_ptr->parent_port))) {
+                continue;
+            }
+            queued[j] = true;
+            order[n_order++] = intf_ptr;
+
+            for (k = 0; k < SYSD_MAX_SPLIT_PORTS
+                        && intf_ptr->subports[k] != NULL; k++) {
+                struct shash_node *node;
+                int idx;
+
+                node = shash_find(&by_name, intf_ptr->subports[k]);
+                if (node == NULL) {
+                    continue;
+                }
+                idx = (intptr_t) node->data;
+                if (!queued[idx]) {
+                    queued[idx] = true;
+                    order[n_order++] = subsys->interfaces[idx];
+                }
+            }
+
+            /* Close the batch before a family that would overflow it. */
+            if (n_order - start > intf_batch_size && family > start) {
+                sysd_interface_batch_submit(subsys, order + start,
+                                            family - start);
+                start = family;
+            }
+        }
+
+        /* Subports whose parent lists some other port go on their own. */
+        for (j = 0; j < subsys->intf_count; j++) {
+            if (!queued[j]) {
+                order[n_order++] = subsys->interfaces[j];
+                if (n_order - start > intf_batch_size) {
+                    sysd_interface_batch_submit(subsys, order + start,
+                                                n_order - 1 - start);
+                    start = n_order - 1;
+                }
+            }
+        }
+
+        /* What is left fits in a batch, or is a single family. */
+        if (start < n_order) {
+            sysd_interface_batch_submit(subsys, order + start,
+                                        n_order - start);
+        }
+        intf_batch_rows += n_order;
+
+        shash_destroy(&by_name);
+        free(queued);
+        free(order);
+    }
+
+    if (intf_batches_pending == 0) {
+        sysd_trace_phase_stop("interfaces", intf_phase);
+    }
+
+} /* sysd_queue_interface_batches */
+
+static bool hw_done_queued = false;
+
+/* Sets cur_hw and next_hw where they are not 1 already. Returns false if
+ * there was nothing to set, e.g. when sysd restarts. */
+static bool
+sysd_hw_done_build(struct ovsdb_idl_txn *txn OVS_UNUSED, void *aux OVS_UNUSED)
 {
-    struct ovsdb_idl_txn *txn = NULL;
     const struct ovsrec_system *sys = NULL;
-    enum ovsdb_idl_txn_status txn_status = TXN_ERROR;
     char hostname[128];
+    bool changed = false;
     int ret;
 
     ret = gethostname(hostname, sizeof(hostname));
     if(ret < 0)
         VLOG_ERR("hostname:%s ret errno %s", hostname, strerror(errno));
 
-    txn = ovsdb_idl_txn_create(idl);
-
     OVSREC_SYSTEM_FOR_EACH(sys, idl) {
+        if (sys->cur_hw == 1 && sys->next_hw == 1) {
+            continue;
+        }
         ovsrec_system_set_cur_hw(sys, (int64_t) 1);
         VLOG_INFO("%s system cur_hw after %d", hostname, (int)(sys->cur_hw));
         ovsrec_system_set_next_hw(sys, (int64_t) 1);
+        sysd_metrics_rows_written(&ovsrec_table_system, 1);
+        changed = true;
     }
 
-    txn_status = ovsdb_idl_txn_commit_block(txn);
-    if (txn_status != TXN_SUCCESS) {
-        VLOG_ERR("Failed to set cur_hw, next_hw = 1. rc = %u", txn_status);
+    return changed;
+
+} /* sysd_hw_done_build */
+
+static void
+sysd_hw_done_done(enum ovsdb_idl_txn_status status, void *aux OVS_UNUSED)
+{
+    hw_done_queued = false;
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        /* Checked again on the next database change. */
+        VLOG_ERR("Failed to set cur_hw, next_hw = 1. rc = %s",
+                 ovsdb_idl_txn_status_to_string(status));
+        return;
     }
-    ovsdb_idl_txn_destroy(txn);
 
     hw_init_done_set = true;
 
     VLOG_INFO("H/W description file processing completed");
 
+} /* sysd_hw_done_done */
+
+static void
+sysd_set_hw_done(void)
+{
+    if (!hw_done_queued) {
+        hw_done_queued = true;
+        sysd_txn_submit(SYSD_TXN_HW_DONE, sysd_hw_done_build,
+                        sysd_hw_done_done, NULL);
+    }
+
 } /* sysd_set_hw_done() */
 
 static void
@@ -891,8 +1807,8 @@ sysd_chk_if_hw_daemons_done(void)
     if(ret < 0)
         VLOG_ERR("hostname:%s ret errno:%s", hostname, strerror(errno));
 
-    VLOG_INFO("hostname:%s Number of Daemons running %d", hostname,
-              num_hw_daemons);
+    VLOG_DBG("hostname:%s Number of Daemons running %d", hostname,
+             num_hw_daemons);
 
     if (num_hw_daemons <= 0) {
         sysd_set_hw_done();
@@ -903,14 +1819,15 @@ sysd_chk_if_hw_daemons_done(void)
     for (i = 0; i < num_daemons; i++) {
         if (daemons[i]->is_hw_handler) {
             OVSREC_DAEMON_FOR_EACH(db_daemon, idl) {
-                VLOG_INFO("%s db_daemon:'%s' daemons_manifest:'%s'"
-                           " db_daemon cur_hw: %d db_daemon is_hw_handler: %d",
-                           hostname, db_daemon->name, daemons[i]->name,
-                           (int)(db_daemon->cur_hw),
-                           (int)(db_daemon->is_hw_handler));
                 if (db_daemon->is_hw_handler) {
                     if (strncmp(daemons[i]->name, db_daemon->name,
                                 strlen(daemons[i]->name)) == 0) {
+                        if ((db_daemon->cur_hw > 0) != daemons[i]->hw_ready) {
+                            daemons[i]->hw_ready = db_daemon->cur_hw > 0;
+                            sysd_trace(SYSD_TRACE_DAEMON, db_daemon->name,
+                                       db_daemon->cur_hw,
+                                       db_daemon->is_hw_handler, 0);
+                        }
                         if (db_daemon->cur_hw > 0) {
                             num_found++;
                         } else {
@@ -939,13 +1856,72 @@ sysd_chk_if_hw_daemons_done(void)
 
 } /* sysd_chk_if_hw_daemons_done() */
 
+static bool initial_config_queued = false;
+static long long initial_config_queued_at;
+static uint64_t initial_config_phase;
+
+static bool
+sysd_initial_config_build(struct ovsdb_idl_txn *txn, void *aux OVS_UNUSED)
+{
+    /* A retried attempt may find the System row already there. */
+    if (ovsrec_system_first(idl) != NULL) {
+        return false;
+    }
+    if (!intf_batched) {
+        sysd_golden_capture_begin();
+    }
+    sysd_initial_configure(txn, !intf_batched);
+    if (!intf_batched) {
+        sysd_golden_capture();
+    }
+
+    return true;
+
+} /* sysd_initial_config_build */
+
+static void
+sysd_initial_config_done(enum ovsdb_idl_txn_status status,
+                         void *aux OVS_UNUSED)
+{
+    initial_config_queued = false;
+    sysd_trace_phase_stop("initial_config", initial_config_phase);
+    sysd_golden_capture_done(status);
+
+    if (status == TXN_SUCCESS) {
+        VLOG_INFO("Initial configuration committed %lld ms after it was "
+                  "queued", time_msec() - initial_config_queued_at);
+        sysd_reconcile_skip();
+    } else if (status == TXN_UNCHANGED) {
+        /* An earlier attempt committed but its reply was lost. The System
+         * row is there, so reconciliation checks the rest once the
+         * interfaces are in. */
+        VLOG_INFO("Initial configuration found in the database %lld ms "
+                  "after it was queued",
+                  time_msec() - initial_config_queued_at);
+    } else {
+        VLOG_ERR("Failed to commit the transaction. rc = %s", ovsdb_idl_txn_status_to_string(status));
+        return;
+    }
+
+    /* Notify parent of startup completion. */
+    daemonize_complete();
+
+    /* Queued after an unchanged commit too: otherwise reconciliation would
+     * add every interface in one transaction. The batches skip what is
+     * already there. */
+    if (intf_batched) {
+        sysd_queue_interface_batches();
+    }
+
+} /* sysd_initial_config_done */
+
 void
 sysd_run(void)
 {
     uint32_t                            new_seqno = 0;
-    enum ovsdb_idl_txn_status           txn_status = TXN_ERROR;
-    struct ovsdb_idl_txn                *txn = NULL;
     const struct ovsrec_system    *cfg = NULL;
+    bool                                replay_failed;
+    bool                                monitor_synced;
     ovsdb_idl_run(idl);
 
     if (ovsdb_idl_is_lock_contended(idl)) {
@@ -957,89 +1933,430 @@ sysd_run(void)
 
         return;
     } else if (!ovsdb_idl_has_lock(idl)) {
+        sysd_reconcile_reset();
+        sysd_dispatch_reset();
+        sysd_monitor_run(SYSD_MONITOR_RECONCILE,
+                         pkg_info_state == PKG_INFO_LOADING);
         return;
     }
 
+    /* Replicate only the rows this stage of the boot reads. */
+    sysd_package_info_check(ovsrec_system_first(idl));
+    monitor_synced = sysd_monitor_run(!sysd_reconcile_done()
+                                      ? SYSD_MONITOR_RECONCILE
+                                      : !hw_init_done_set
+                                      ? SYSD_MONITOR_HW_WAIT
+                                      : SYSD_MONITOR_RUNNING,
+                                      pkg_info_state == PKG_INFO_LOADING);
+
+    /* A snapshot that could not be applied is built instead. */
+    replay_failed = sysd_golden_run();
+
     new_seqno = ovsdb_idl_get_seqno(idl);
-    if (new_seqno != idl_seqno) {
+    if (new_seqno != idl_seqno || replay_failed || monitor_synced
+        || intf_recheck) {
 
         idl_seqno = ovsdb_idl_get_seqno(idl);
+        intf_recheck = false;
+        sysd_metrics_seqno_changed();
 
         cfg = ovsrec_system_first(idl);
 
         if (cfg == NULL) {
-            txn = ovsdb_idl_txn_create(idl);
-
-            sysd_initial_configure(txn);
-
-            txn_status = ovsdb_idl_txn_commit_block(txn);
-            if (txn_status != TXN_SUCCESS) {
-                VLOG_ERR("Failed to commit the transaction. rc = %s", ovsdb_idl_txn_status_to_string(txn_status));
+            /* Send the snapshot of the initial configuration saved on this
+             * platform and image if there is one, else build it. */
+            if (!initial_config_queued && !sysd_golden_replay_pending()
+                && !sysd_golden_replay_start()) {
+                int n_intfs = 0;
+                int i;
+
+                for (i = 0; i < num_subsystems; i++) {
+                    n_intfs += subsystems[i]->intf_count;
+                }
+                intf_batched = n_intfs > intf_batch_size;
+
+                initial_config_queued = true;
+                initial_config_queued_at = time_msec();
+                initial_config_phase =
+                    sysd_trace_phase_start("initial_config");
+                sysd_txn_submit(SYSD_TXN_INITIAL_CONFIG,
+                                sysd_initial_config_build,
+                                sysd_initial_config_done, NULL);
             }
-            ovsdb_idl_txn_destroy(txn);
         } else {
-            /* Update the software information. */
-            sysd_update_sw_info(cfg);
+            /* Notify parent of startup completion once the System row is
+             * in the database, not just in a transaction in flight. */
+            if (!initial_config_queued && !sysd_golden_replay_pending()) {
+                daemonize_complete();
+            }
+
+            /* Bring a configuration written before this sysd started in
+             * line with the hardware it finds, once every row it compares
+             * has been replicated. */
+            if (!initial_config_queued && !intf_batches_pending
+                && sysd_monitor_synced()) {
+                sysd_reconcile_run();
+            }
 
-            if (!hw_init_done_set) {
+            /* cur_hw waits for every interface to be in the db. */
+            if (!hw_init_done_set && !intf_batches_pending
+                && !sysd_reconcile_pending() && sysd_monitor_synced()) {
                 sysd_chk_if_hw_daemons_done();
             }
-        }
 
-        /* Populate source url and version of packages/daemon present in image */
-        if (ovsrec_package_info_first(idl) == NULL) {
-            sysd_add_package_info();
+            /* Populate source url and version of packages/daemon present
+             * in image */
+            sysd_package_info_run();
         }
-        sysd_handle_timezone_update(cfg);
     }
 
-    /* Notify parent of startup completion. */
-    daemonize_complete();
+    /* Software info and timezone, when their columns change. */
+    sysd_dispatch_run();
+
+    /* Build and commit queued writes. */
+    sysd_txn_run();
 
 } /* sysd_run */
 
+/*
+ * Diagnostic dump.
+ *
+ * Each section is built as JSON, which 'ops-sysd/dump --json' prints as
+ * is. The text form prints the same data under a banner per section.
+ */
+static struct json *
+sysd_dump_smap(const struct smap *smap)
+{
+    struct json             *json = json_object_create();
+    const struct smap_node  *node;
+
+    SMAP_FOR_EACH (node, smap) {
+        json_object_put_string(json, node->key, node->value);
+    }
+
+    return json;
+
+} /* sysd_dump_smap */
+
+/* Strings from the hardware description files may be missing. */
+static void
+sysd_dump_put_string(struct json *json, const char *key, const char *value)
+{
+    if (value) {
+        json_object_put_string(json, key, value);
+    }
+
+} /* sysd_dump_put_string */
+
+static struct json *
+sysd_dump_mac(uint64_t mac)
+{
+    char buf[32];
+
+    memset(buf, 0, sizeof(buf));
+    return json_string_create(ops_ether_ulong_long_to_string(buf, mac));
+
+} /* sysd_dump_mac */
+
+static struct json *
+sysd_dump_daemons(void)
+{
+    struct json *json = json_array_create_empty();
+    int         i;
+
+    for (i = 0; i < num_daemons; i++) {
+        struct json *daemon = json_object_create();
+
+        json_object_put_string(daemon, "name", daemons[i]->name);
+        json_object_put(daemon, "is_hw_handler",
+                        json_boolean_create(daemons[i]->is_hw_handler));
+        json_object_put(daemon, "cur_hw",
+                        json_integer_create(daemons[i]->cur_hw));
+        json_object_put(daemon, "hw_ready",
+                        json_boolean_create(daemons[i]->hw_ready));
+        json_array_add(json, daemon);
+    }
+
+    return json;
+
+} /* sysd_dump_daemons */
+
+static struct json *
+sysd_dump_mgmt_intf(void)
+{
+    struct json *json = json_object_create();
+
+    if (mgmt_intf) {
+        json_object_put_string(json, "name", mgmt_intf->name);
+    }
+
+    return json;
+
+} /* sysd_dump_mgmt_intf */
+
+static struct json *
+sysd_dump_subsystems(void)
+{
+    struct json *json = json_array_create_empty();
+    int         i;
+    int         j;
+
+    for (i = 0; i < num_subsystems; i++) {
+        const sysd_subsystem_t  *subsys_ptr = subsystems[i];
+        struct json             *subsys = json_object_create();
+        struct json             *macs = json_object_create();
+        struct json             *intfs = json_array_create_empty();
+
+        json_object_put_string(subsys, "name", subsys_ptr->name);
+        sysd_dump_put_string(subsys, "type", subsys_ptr->type);
+        json_object_put(subsys, "valid",
+                        json_boolean_create(subsys_ptr->valid));
+        json_object_put(subsys, "fru",
+                        sysd_fru_to_json(&subsys_ptr->fru_eeprom));
+
+        json_object_put(macs, "next_mac_address",
+                        sysd_dump_mac(subsys_ptr->nxt_mac_addr));
+        json_object_put(macs, "macs_remaining",
+                        json_integer_create(subsys_ptr->num_free_macs));
+        json_object_put(macs, "mgmt_mac_address",
+                        sysd_dump_mac(subsys_ptr->mgmt_mac_addr));
+        json_object_put(macs, "system_mac_address",
+                        sysd_dump_mac(subsys_ptr->system_mac_addr));
+        json_object_put(subsys, "mac_allocation", macs);
+
+        for (j = 0; j < subsys_ptr->intf_count; j++) {
+            const sysd_intf_info_t  *intf_ptr = subsys_ptr->interfaces[j];
+            struct json             *intf = json_object_create();
+            struct smap             hw_intf_info;
+
+            smap_init(&hw_intf_info);
+            sysd_build_hw_intf_info(&hw_intf_info, subsys_ptr, intf_ptr);
+            json_object_put_string(intf, "name", intf_ptr->name);
+            json_object_put(intf, "hw_intf_info",
+                            sysd_dump_smap(&hw_intf_info));
+            smap_destroy(&hw_intf_info);
+            json_array_add(intfs, intf);
+        }
+        json_object_put(subsys, "interfaces", intfs);
+
+        json_array_add(json, subsys);
+    }
+
+    return json;
+
+} /* sysd_dump_subsystems */
+
+static struct json *
+sysd_dump_qos(void)
+{
+    YamlQosInfo *qos_info = sysd_cfg_yaml_get_qos_info();
+    struct json *json = json_object_create();
+    struct json *entries;
+    int         i;
+
+    if (qos_info == NULL) {
+        return json;
+    }
+    sysd_dump_put_string(json, "trust", qos_info->trust);
+    sysd_dump_put_string(json, "default_name", qos_info->default_name);
+    sysd_dump_put_string(json, "factory_default_name",
+                         qos_info->factory_default_name);
+
+    entries = json_array_create_empty();
+    for (i = 0; i < sysd_cfg_yaml_get_cos_map_entry_count(); i++) {
+        const YamlCosMapEntry *map_entry = sysd_cfg_yaml_get_cos_map_entry(i);
+        struct json *entry = json_object_create();
+
+        json_object_put(entry, "code_point",
+                        json_integer_create(map_entry->code_point));
+        json_object_put(entry, "local_priority",
+                        json_integer_create(map_entry->local_priority));
+        sysd_dump_put_string(entry, "color", map_entry->color);
+        sysd_dump_put_string(entry, "description", map_entry->description);
+        json_array_add(entries, entry);
+    }
+    json_object_put(json, "cos_map", entries);
+
+    entries = json_array_create_empty();
+    for (i = 0; i < sysd_cfg_yaml_get_dscp_map_entry_count(); i++) {
+        const YamlDscpMapEntry *map_entry =
+            sysd_cfg_yaml_get_dscp_map_entry(i);
+        struct json *entry = json_object_create();
+
+        json_object_put(entry, "code_point",
+                        json_integer_create(map_entry->code_point));
+        json_object_put(entry, "local_priority",
+                        json_integer_create(map_entry->local_priority));
+        json_object_put(entry, "priority_code_point",
+                        json_integer_create(map_entry->priority_code_point));
+        sysd_dump_put_string(entry, "color", map_entry->color);
+        sysd_dump_put_string(entry, "description", map_entry->description);
+        json_array_add(entries, entry);
+    }
+    json_object_put(json, "dscp_map", entries);
+
+    entries = json_array_create_empty();
+    for (i = 0; i < sysd_cfg_yaml_get_queue_profile_entry_count(); i++) {
+        const YamlQueueProfileEntry *yaml_entry =
+            sysd_cfg_yaml_get_queue_profile_entry(i);
+        struct json *entry = json_object_create();
+
+        json_object_put(entry, "queue", json_integer_create(yaml_entry->queue));
+        json_object_put(entry, "local_priority",
+                        json_integer_create(yaml_entry->local_priority));
+        sysd_dump_put_string(entry, "description", yaml_entry->description);
+        json_array_add(entries, entry);
+    }
+    json_object_put(json, "queue_profile", entries);
+
+    entries = json_array_create_empty();
+    for (i = 0; i < sysd_cfg_yaml_get_schedule_profile_entry_count(); i++) {
+        const YamlScheduleProfileEntry *yaml_entry =
+            sysd_cfg_yaml_get_schedule_profile_entry(i);
+        struct json *entry = json_object_create();
+
+        json_object_put(entry, "queue", json_integer_create(yaml_entry->queue));
+        sysd_dump_put_string(entry, "algorithm", yaml_entry->algorithm);
+        json_object_put(entry, "weight",
+                        json_integer_create(yaml_entry->weight));
+        json_array_add(entries, entry);
+    }
+    json_object_put(json, "schedule_profile", entries);
+
+    return json;
+
+} /* sysd_dump_qos */
+
+static struct json *
+sysd_dump_acl(void)
+{
+    YamlAclInfo *acl_info = sysd_cfg_yaml_get_acl_info();
+    struct json *json = json_object_create();
+
+    if (acl_info) {
+        json_object_put(json, "max_acls",
+                        json_integer_create(acl_info->max_acls));
+        json_object_put(json, "max_aces",
+                        json_integer_create(acl_info->max_aces));
+        json_object_put(json, "max_aces_per_acl",
+                        json_integer_create(acl_info->max_aces_per_acl));
+    }
+
+    return json;
+
+} /* sysd_dump_acl */
+
+static bool
+sysd_dump_is_scalar(const struct json *json)
+{
+    return json->type != JSON_OBJECT && json->type != JSON_ARRAY;
+
+} /* sysd_dump_is_scalar */
+
+static void
+sysd_dump_scalar(struct ds *ds, const struct json *json)
+{
+    if (json->type == JSON_STRING) {
+        ds_put_cstr(ds, json_string(json));
+    } else {
+        json_to_ds(json, 0, ds);
+    }
+    ds_put_char(ds, '\n');
+
+} /* sysd_dump_scalar */
+
+/* Prints 'json' as indented "key: value" lines, with array elements
+ * starting with "- ". */
+static void
+sysd_dump_text(struct ds *ds, const struct json *json, int indent)
+{
+    const struct shash_node **nodes;
+    const struct json_array *array;
+    size_t                  i;
+
+    if (json->type == JSON_OBJECT) {
+        nodes = shash_sort(json_object(json));
+        for (i = 0; i < shash_count(json_object(json)); i++) {
+            const struct json *value = nodes[i]->data;
+
+            ds_put_format(ds, "%*s%s:", indent, "", nodes[i]->name);
+            if (sysd_dump_is_scalar(value)) {
+                ds_put_char(ds, ' ');
+                sysd_dump_scalar(ds, value);
+            } else {
+                ds_put_char(ds, '\n');
+                sysd_dump_text(ds, value, indent + 4);
+            }
+        }
+        free(nodes);
+    } else if (json->type == JSON_ARRAY) {
+        array = json_array(json);
+        for (i = 0; i < array->n; i++) {
+            ds_put_format(ds, "%*s-", indent, "");
+            if (sysd_dump_is_scalar(array->elems[i])) {
+                ds_put_char(ds, ' ');
+                sysd_dump_scalar(ds, array->elems[i]);
+            } else {
+                ds_put_char(ds, '\n');
+                sysd_dump_text(ds, array->elems[i], indent + 4);
+            }
+        }
+    } else {
+        ds_put_format(ds, "%*s", indent, "");
+        sysd_dump_scalar(ds, json);
+    }
+
+} /* sysd_dump_text */
+
 /*
  * Function       : sysd_dump
- * Responsibility : populates buffer for unixctl reply
- * Parameters     : buffer, buffer length
+ * Responsibility : appends sysd's internal state to 'ds', for the
+ *                  ops-sysd/dump command and diag-dump
+ * Parameters     : ds, JSON instead of text
  * Returns        : void
  */
-
 void
-sysd_dump(char* buf, int buflen)
+sysd_dump(struct ds *ds, bool json_format)
 {
-    char tmp_buf[100];
-    int i = 0;
-
-    /* Loop through all daemons */
-
-    strcpy(buf, "=============== Daemon Info =========================\n");
-    strncat(buf, "Name\t\t\tis_hw_handler\t\t\tcur_hw\n", REM_BUF_LEN);
-
-    while((num_hw_daemons - 1) >= i) {
-        strncat(buf, daemons[i]->name, REM_BUF_LEN);
-        strncat(buf, "\t\t\t", REM_BUF_LEN);
-        sprintf(tmp_buf, "%d", daemons[i]->is_hw_handler);
-        strncat(buf, tmp_buf, REM_BUF_LEN);
-        strncat(buf, "\t\t\t", REM_BUF_LEN);
-        strcpy(tmp_buf, "\0");
-        sprintf(tmp_buf, "%" PRIi64, daemons[i]->cur_hw);
-        strncat(buf, tmp_buf, REM_BUF_LEN);
-        strncat(buf, "\n", REM_BUF_LEN);
-        i++;
-    }
-
-    /* mgmt_intf */
-    strncat(buf, "=============== Mgmt_intf Info ==========================\n",
-            REM_BUF_LEN);
-    strncat(buf, mgmt_intf->name, REM_BUF_LEN);
-    strncat(buf, "\n", REM_BUF_LEN);
-}
+    static const struct {
+        const char      *key;
+        const char      *title;
+        struct json     *(*build)(void);
+    } sections[] = {
+        { "daemons",     "Daemon Info",    sysd_dump_daemons },
+        { "mgmt_intf",   "Mgmt_intf Info", sysd_dump_mgmt_intf },
+        { "subsystems",  "Subsystem Info", sysd_dump_subsystems },
+        { "qos",         "QoS Defaults",   sysd_dump_qos },
+        { "acl",         "ACL Limits",     sysd_dump_acl },
+    };
+    struct json *dump = json_object_create();
+    size_t      i;
+
+    for (i = 0; i < ARRAY_SIZE(sections); i++) {
+        struct json *section = sections[i].build();
+
+        if (!json_format) {
+            ds_put_format(ds, "=============== %s ===============\n",
+                          sections[i].title);
+            sysd_dump_text(ds, section, 0);
+        }
+        json_object_put(dump, sections[i].key, section);
+    }
+
+    if (json_format) {
+        json_to_ds(dump, JSSF_PRETTY | JSSF_SORT, ds);
+        ds_put_char(ds, '\n');
+    }
+    json_destroy(dump);
+
+} /* sysd_dump */
 
 void
 sysd_wait(void)
 {
     ovsdb_idl_wait(idl);
+    sysd_txn_wait();
+    sysd_golden_wait();
 
 } /* sysd_wait */
 /** @} end of group sysd */
@@ -0,0 +1,342 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup sysd
+ *
+ * @file
+ * Source for the sysd sampling CPU profiler.
+ */
+
+/* For REG_RIP/REG_RBP, dladdr() and pthread_getattr_np(). */
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <ucontext.h>
+#include <sys/time.h>
+
+#include <dynamic-string.h>
+#include <ovs-atomic.h>
+#include <shash.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include "sysd_profile.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_profile);
+
+/** @ingroup sysd
+ * @{ */
+
+/* Frames more than this far apart are taken as a broken chain. */
+#define PROFILE_MAX_FRAME_SIZE  (1024 * 1024)
+
+struct profile_sample {
+    unsigned int    depth;
+    uintptr_t       pcs[SYSD_PROFILE_MAX_DEPTH];    /* Innermost first. */
+};
+
+static struct profile_sample    *samples;
+static atomic_uint              n_samples;          /* Including dropped. */
+static bool                     profiling;
+static unsigned int             profile_hz;
+static uintptr_t                stack_lo;
+static uintptr_t                stack_hi;
+
+/* Returns the interrupted pc and frame pointer. Where the register layout
+ * is not known, starts from the handler's own frame instead, which puts
+ * the signal trampoline on top of every stack. */
+static void
+profile_context_regs(void *uc_, uintptr_t *pc, uintptr_t *fp)
+{
+    ucontext_t *uc OVS_UNUSED = uc_;
+
+#if defined(__x86_64__)
+    *pc = uc->uc_mcontext.gregs[REG_RIP];
+    *fp = uc->uc_mcontext.gregs[REG_RBP];
+#elif defined(__aarch64__)
+    *pc = uc->uc_mcontext.pc;
+    *fp = uc->uc_mcontext.regs[29];
+#else
+    *pc = 0;
+    *fp = (uintptr_t) __builtin_frame_address(0);
+#endif
+
+} /* profile_context_regs */
+
+/* SIGPROF handler. Only touches the preallocated sample array and the
+ * stack of the interrupted thread within the bounds found at start. */
+static void
+profile_sigprof(int signr OVS_UNUSED, siginfo_t *si OVS_UNUSED, void *uc)
+{
+    struct profile_sample   *sample;
+    unsigned int            idx;
+    uintptr_t               pc;
+    uintptr_t               fp;
+    int                     saved_errno = errno;
+
+    atomic_add_explicit(&n_samples, 1, &idx, memory_order_relaxed);
+    if (idx >= SYSD_PROFILE_MAX_SAMPLES) {
+        return;
+    }
+    sample = &samples[idx];
+    sample->depth = 0;
+
+    profile_context_regs(uc, &pc, &fp);
+    if (pc) {
+        sample->pcs[sample->depth++] = pc;
+    }
+
+    /* Each frame starts with the caller's frame pointer followed by the
+     * return address, on both x86-64 and AArch64. */
+    while (sample->depth < SYSD_PROFILE_MAX_DEPTH
+           && fp >= stack_lo && fp + 2 * sizeof(uintptr_t) <= stack_hi
+           && !(fp & (sizeof(uintptr_t) - 1))) {
+        const uintptr_t *frame = (const uintptr_t *) fp;
+
+        if (!frame[1]) {
+            break;
+        }
+        sample->pcs[sample->depth++] = frame[1];
+        if (frame[0] <= fp || frame[0] - fp > PROFILE_MAX_FRAME_SIZE) {
+            break;
+        }
+        fp = frame[0];
+    }
+    errno = saved_errno;
+
+} /* profile_sigprof */
+
+static bool
+profile_get_stack_bounds(void)
+{
+    pthread_attr_t  attr;
+    void            *addr;
+    size_t          size;
+
+    if (pthread_getattr_np(pthread_self(), &attr)) {
+        return false;
+    }
+    if (pthread_attr_getstack(&attr, &addr, &size)) {
+        pthread_attr_destroy(&attr);
+        return false;
+    }
+    pthread_attr_destroy(&attr);
+
+    stack_lo = (uintptr_t) addr;
+    stack_hi = stack_lo + size;
+
+    return true;
+
+} /* profile_get_stack_bounds */
+
+static bool
+profile_set_timer(unsigned int hz)
+{
+    struct itimerval it;
+
+    memset(&it, 0, sizeof it);
+    if (hz) {
+        it.it_interval.tv_usec = 1000000 / hz;
+        it.it_value = it.it_interval;
+    }
+
+    return !setitimer(ITIMER_PROF, &it, NULL);
+
+} /* profile_set_timer */
+
+char *
+sysd_profile_start(unsigned int hz)
+{
+    struct sigaction sa;
+
+    if (profiling) {
+        return xstrdup("profiler already running");
+    }
+    if (!hz || hz > SYSD_PROFILE_MAX_HZ) {
+        return xasprintf("sample rate must be 1 to %d Hz",
+                         SYSD_PROFILE_MAX_HZ);
+    }
+    /* Samples are only unwound within the main thread's stack, which is
+     * where the poll loop runs. */
+    if (!profile_get_stack_bounds()) {
+        return xstrdup("unable to find the main thread's stack");
+    }
+
+    samples = xmalloc(SYSD_PROFILE_MAX_SAMPLES * sizeof *samples);
+    atomic_store_explicit(&n_samples, 0, memory_order_relaxed);
+
+    memset(&sa, 0, sizeof sa);
+    sa.sa_sigaction = profile_sigprof;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, NULL)) {
+        free(samples);
+        samples = NULL;
+        return xasprintf("sigaction failed (%s)", ovs_strerror(errno));
+    }
+    if (!profile_set_timer(hz)) {
+        signal(SIGPROF, SIG_IGN);
+        free(samples);
+        samples = NULL;
+        return xasprintf("setitimer failed (%s)", ovs_strerror(errno));
+    }
+
+    profiling = true;
+    profile_hz = hz;
+    VLOG_INFO("CPU profiler started at %u Hz", hz);
+
+    return NULL;
+
+} /* sysd_profile_start */
+
+/* Appends the name of the function containing 'pc' to 'ds'. Return
+ * addresses point after the call, so callers pass 'pc' - 1 for those. */
+static void
+profile_put_symbol(struct ds *ds, uintptr_t pc)
+{
+    Dl_info info;
+
+    if (!dladdr((void *) pc, &info)) {
+        ds_put_format(ds, "0x%"PRIxPTR, pc);
+    } else if (info.dli_sname) {
+        ds_put_cstr(ds, info.dli_sname);
+    } else if (info.dli_fname) {
+        const char *slash = strrchr(info.dli_fname, '/');
+
+        ds_put_format(ds, "%s+0x%"PRIxPTR,
+                      slash ? slash + 1 : info.dli_fname,
+                      pc - (uintptr_t) info.dli_fbase);
+    } else {
+        ds_put_format(ds, "0x%"PRIxPTR, pc);
+    }
+
+} /* profile_put_symbol */
+
+static void
+profile_count(struct shash *stacks, const char *key, unsigned long n)
+{
+    unsigned long *count = shash_find_data(stacks, key);
+
+    if (count == NULL) {
+        count = xzalloc(sizeof *count);
+        shash_add(stacks, key, count);
+    }
+    *count += n;
+
+} /* profile_count */
+
+char *
+sysd_profile_stop(const char *file, struct ds *summary)
+{
+    struct shash            raw = SHASH_INITIALIZER(&raw);
+    struct shash            folded = SHASH_INITIALIZER(&folded);
+    const struct shash_node **nodes;
+    struct shash_node       *node;
+    struct ds               key = DS_EMPTY_INITIALIZER;
+    unsigned int            total;
+    unsigned int            n;
+    unsigned int            i;
+    int                     d;
+    FILE                    *fp;
+
+    if (!profiling) {
+        return xstrdup("profiler not running");
+    }
+
+    /* Ignore rather than restore the default action, which would kill us
+     * if a last SIGPROF is still pending. */
+    profile_set_timer(0);
+    signal(SIGPROF, SIG_IGN);
+    profiling = false;
+
+    atomic_read_explicit(&n_samples, &total, memory_order_relaxed);
+    n = MIN(total, SYSD_PROFILE_MAX_SAMPLES);
+
+    /* Merge identical stacks before naming them, which is the slow part. */
+    for (i = 0; i < n; i++) {
+        ds_clear(&key);
+        for (d = 0; d < samples[i].depth; d++) {
+            ds_put_format(&key, "%"PRIxPTR" ", samples[i].pcs[d]);
+        }
+        profile_count(&raw, ds_cstr(&key), 1);
+    }
+    free(samples);
+    samples = NULL;
+
+    SHASH_FOR_EACH (node, &raw) {
+        uintptr_t   pcs[SYSD_PROFILE_MAX_DEPTH];
+        const char  *p = node->name;
+        char        *end;
+        int         depth = 0;
+
+        while (depth < SYSD_PROFILE_MAX_DEPTH
+               && (pcs[depth] = strtoull(p, &end, 16), end != p)) {
+            depth++;
+            p = end;
+        }
+
+        /* Folded stacks list the outermost frame first. */
+        ds_clear(&key);
+        for (d = depth - 1; d >= 0; d--) {
+            profile_put_symbol(&key, d ? pcs[d] - 1 : pcs[d]);
+            if (d) {
+                ds_put_char(&key, ';');
+            }
+        }
+        if (!depth) {
+            ds_put_cstr(&key, "[unknown]");
+        }
+        profile_count(&folded, ds_cstr(&key),
+                      *(unsigned long *) node->data);
+    }
+    shash_destroy_free_data(&raw);
+    ds_destroy(&key);
+
+    fp = fopen(file, "w");
+    if (fp == NULL) {
+        shash_destroy_free_data(&folded);
+        return xasprintf("%s: open failed (%s)", file, ovs_strerror(errno));
+    }
+    nodes = shash_sort(&folded);
+    for (i = 0; i < shash_count(&folded); i++) {
+        fprintf(fp, "%s %lu\n", nodes[i]->name,
+                *(unsigned long *) nodes[i]->data);
+    }
+    free(nodes);
+    fclose(fp);
+
+    ds_put_format(summary, "%u samples at %u Hz", n, profile_hz);
+    if (total > n) {
+        ds_put_format(summary, " (%u dropped)", total - n);
+    }
+    ds_put_format(summary, ", %"PRIuSIZE" stacks written to %s",
+                  shash_count(&folded), file);
+    VLOG_INFO("CPU profiler stopped: %s", ds_cstr(summary));
+    shash_destroy_free_data(&folded);
+
+    return NULL;
+
+} /* sysd_profile_stop */
+/** @} end of group sysd */
@@ -0,0 +1,448 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup sysd
+ *
+ * @file
+ * Source for sysd restart reconciliation.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <shash.h>
+#include <smap.h>
+#include <timeval.h>
+#include <util.h>
+#include <ovsdb-idl.h>
+#include <vswitch-idl.h>
+#include <openvswitch/vlog.h>
+
+#include <config-yaml.h>
+#include "acl_init.h"
+#include "sysd.h"
+#include "sysd_util.h"
+#include "sysd_ovsdb_if.h"
+#include "sysd_metrics.h"
+#include "sysd_reconcile.h"
+#include "sysd_trace.h"
+#include "sysd_txn.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_reconcile);
+
+/** @ingroup sysd
+ * @{ */
+
+extern char *g_hw_desc_dir;
+
+/* Rows written by the last build of the reconciliation job. */
+static struct {
+    unsigned int    added;
+    unsigned int    updated;
+    unsigned int    removed;
+} changes;
+
+static bool         reconcile_queued = false;
+static bool         reconciled = false;
+static long long    reconcile_queued_at;
+static uint64_t     reconcile_phase;
+
+/* Whether the rows in 'rows' are the same set as the 'n' in 'set'. */
+static bool
+reconcile_same_intf_set(struct ovsrec_interface **set, size_t n,
+                        struct ovsrec_interface **rows, size_t n_rows)
+{
+    size_t i;
+    size_t j;
+
+    if (n != n_rows) {
+        return false;
+    }
+    for (i = 0; i < n_rows; i++) {
+        for (j = 0; j < n && set[j] != rows[i]; j++) {
+            continue;
+        }
+        if (j == n) {
+            return false;
+        }
+    }
+
+    return true;
+
+} /* reconcile_same_intf_set */
+
+/* Brings split_parent and split_children of the subsystem's interfaces,
+ * whose rows are 'rows', in line with the hardware description. 'added'
+ * tells which rows were inserted by this transaction. */
+static void
+reconcile_split_ports(sysd_subsystem_t *subsys, struct ovsrec_interface **rows,
+                      const bool *added, struct shash *by_name)
+{
+    int i;
+    int k;
+
+    for (i = 0; i < subsys->intf_count; i++) {
+        sysd_intf_info_t        *intf_ptr = subsys->interfaces[i];
+        struct ovsrec_interface *row = rows[i];
+        struct ovsrec_interface *parent = NULL;
+        struct ovsrec_interface *children[SYSD_MAX_SPLIT_PORTS];
+        size_t                  n_children = 0;
+        bool                    changed = false;
+
+        if (intf_ptr->parent_port) {
+            parent = shash_find_data(by_name, intf_ptr->parent_port);
+        }
+        if (row->split_parent != parent) {
+            ovsrec_interface_set_split_parent(row, parent);
+            changed = true;
+        }
+
+        for (k = 0; k < SYSD_MAX_SPLIT_PORTS && intf_ptr->subports
+                    && intf_ptr->subports[k]; k++) {
+            struct ovsrec_interface *child;
+
+            child = shash_find_data(by_name, intf_ptr->subports[k]);
+            if (child) {
+                children[n_children++] = child;
+            }
+        }
+        if (!reconcile_same_intf_set(row->split_children, row->n_split_children,
+                                     children, n_children)) {
+            ovsrec_interface_set_split_children(row, children, n_children);
+            changed = true;
+        }
+
+        if (changed && !added[i]) {
+            sysd_metrics_rows_written(&ovsrec_table_interface, 1);
+            changes.updated++;
+        }
+    }
+
+} /* reconcile_split_ports */
+
+/* Adds the subsystem's missing interfaces, updates hw_intf_info where it
+ * differs, and drops interfaces no longer in ports.yaml from the
+ * subsystem. Dropped rows that no Port uses are garbage collected by
+ * ovsdb-server; sysd does not delete them, since a Port may still refer
+ * to them until the user configuration is changed. */
+static void
+reconcile_interfaces(struct ovsdb_idl_txn *txn, sysd_subsystem_t *subsys,
+                     const struct ovsrec_subsystem *ovs_subsys)
+{
+    struct shash            existing = SHASH_INITIALIZER(&existing);
+    struct shash            by_name = SHASH_INITIALIZER(&by_name);
+    struct ovsrec_interface **rows;
+    bool                    *added;
+    struct smap             hw_intf_info;
+    size_t                  n_kept = 0;
+    bool                    set_changed = false;
+    size_t                  i;
+    int                     j;
+
+    for (i = 0; i < ovs_subsys->n_interfaces; i++) {
+        shash_add_once(&existing, ovs_subsys->interfaces[i]->name,
+                       ovs_subsys->interfaces[i]);
+    }
+
+    rows = xmalloc(MAX(subsys->intf_count, 1) * sizeof *rows);
+    added = xcalloc(MAX(subsys->intf_count, 1), sizeof *added);
+    for (j = 0; j < subsys->intf_count; j++) {
+        sysd_intf_info_t        *intf_ptr = subsys->interfaces[j];
+        struct ovsrec_interface *row;
+
+        row = shash_find_and_delete(&existing, intf_ptr->name);
+        if (row == NULL) {
+            row = sysd_initial_interface_add(txn, subsys, intf_ptr);
+            added[j] = true;
+            changes.added++;
+            set_changed = true;
+        } else {
+            n_kept++;
+
+            smap_init(&hw_intf_info);
+            sysd_build_hw_intf_info(&hw_intf_info, subsys, intf_ptr);
+            if (!smap_equal(&hw_intf_info, &row->hw_intf_info)) {
+                ovsrec_interface_set_hw_intf_info(row, &hw_intf_info);
+                sysd_metrics_rows_written(&ovsrec_table_interface, 1);
+                changes.updated++;
+            }
+            smap_destroy(&hw_intf_info);
+        }
+        rows[j] = row;
+        shash_add_once(&by_name, intf_ptr->name, row);
+    }
+
+    if (n_kept != ovs_subsys->n_interfaces) {
+        changes.removed += ovs_subsys->n_interfaces - n_kept;
+        set_changed = true;
+    }
+    if (set_changed) {
+        ovsrec_subsystem_set_interfaces(ovs_subsys, rows, subsys->intf_count);
+    }
+
+    reconcile_split_ports(subsys, rows, added, &by_name);
+
+    shash_destroy(&by_name);
+    shash_destroy(&existing);
+    free(added);
+    free(rows);
+
+} /* reconcile_interfaces */
+
+/* Updates the hardware columns of an existing Subsystem row. FRU keys are
+ * replaced in other_info, leaving any others there alone. MAC allocation
+ * state is left as it is, since other daemons may have used MACs since. */
+static void
+reconcile_subsystem(struct ovsdb_idl_txn *txn, sysd_subsystem_t *subsys,
+                    const struct ovsrec_subsystem *ovs_subsys)
+{
+    struct smap         desired = SMAP_INITIALIZER(&desired);
+    struct smap         other_info;
+    struct smap_node    *node;
+    bool                changed = false;
+
+    sysd_build_subsystem_other_info(&desired, subsys);
+    smap_clone(&other_info, &ovs_subsys->other_info);
+    SMAP_FOR_EACH (node, &desired) {
+        smap_replace(&other_info, node->key, node->value);
+    }
+    if (!smap_equal(&other_info, &ovs_subsys->other_info)) {
+        ovsrec_subsystem_set_other_info(ovs_subsys, &other_info);
+        changed = true;
+    }
+    smap_destroy(&other_info);
+    smap_destroy(&desired);
+
+    if (!ovs_subsys->hw_desc_dir
+        || strcmp(ovs_subsys->hw_desc_dir, g_hw_desc_dir)) {
+        ovsrec_subsystem_set_hw_desc_dir(ovs_subsys, g_hw_desc_dir);
+        changed = true;
+    }
+
+    if (changed) {
+        sysd_metrics_rows_written(&ovsrec_table_subsystem, 1);
+        changes.updated++;
+    }
+
+    reconcile_interfaces(txn, subsys, ovs_subsys);
+
+} /* reconcile_subsystem */
+
+static void
+reconcile_subsystems(struct ovsdb_idl_txn *txn,
+                     const struct ovsrec_system *sys)
+{
+    struct shash            existing = SHASH_INITIALIZER(&existing);
+    struct ovsrec_subsystem **rows;
+    size_t                  n_kept = 0;
+    bool                    set_changed = false;
+    size_t                  i;
+    int                     j;
+
+    for (i = 0; i < sys->n_subsystems; i++) {
+        shash_add_once(&existing, sys->subsystems[i]->name,
+                       sys->subsystems[i]);
+    }
+
+    rows = xmalloc(MAX(num_subsystems, 1) * sizeof *rows);
+    for (j = 0; j < num_subsystems; j++) {
+        struct ovsrec_subsystem *row;
+
+        row = shash_find_and_delete(&existing, subsystems[j]->name);
+        if (row == NULL) {
+            row = sysd_initial_subsystem_add(txn, subsystems[j], true);
+            changes.added += 1 + subsystems[j]->intf_count;
+            set_changed = true;
+        } else {
+            n_kept++;
+            reconcile_subsystem(txn, subsystems[j], row);
+        }
+        rows[j] = row;
+    }
+
+    if (n_kept != sys->n_subsystems) {
+        changes.removed += sys->n_subsystems - n_kept;
+        set_changed = true;
+    }
+    if (set_changed) {
+        ovsrec_system_set_subsystems(sys, rows, num_subsystems);
+    }
+
+    shash_destroy(&existing);
+    free(rows);
+
+} /* reconcile_subsystems */
+
+/* Adds daemons new to the manifest and drops those no longer in it. cur_hw
+ * belongs to each daemon and is left alone. */
+static void
+reconcile_daemons(struct ovsdb_idl_txn *txn, const struct ovsrec_system *sys)
+{
+    struct shash            existing = SHASH_INITIALIZER(&existing);
+    struct ovsrec_daemon    **rows;
+    size_t                  n_kept = 0;
+    bool                    set_changed = false;
+    size_t                  i;
+    int                     j;
+
+    for (i = 0; i < sys->n_daemons; i++) {
+        shash_add_once(&existing, sys->daemons[i]->name, sys->daemons[i]);
+    }
+
+    rows = xmalloc(MAX(num_daemons, 1) * sizeof *rows);
+    for (j = 0; j < num_daemons; j++) {
+        struct ovsrec_daemon *row;
+
+        row = shash_find_and_delete(&existing, daemons[j]->name);
+        if (row == NULL) {
+            row = sysd_initial_daemon_add(txn, daemons[j]);
+            changes.added++;
+            set_changed = true;
+        } else {
+            n_kept++;
+            if (row->is_hw_handler != daemons[j]->is_hw_handler) {
+                ovsrec_daemon_set_is_hw_handler(row, daemons[j]->is_hw_handler);
+                sysd_metrics_rows_written(&ovsrec_table_daemon, 1);
+                changes.updated++;
+            }
+        }
+        rows[j] = row;
+    }
+
+    if (n_kept != sys->n_daemons) {
+        changes.removed += sys->n_daemons - n_kept;
+        set_changed = true;
+    }
+    if (set_changed) {
+        ovsrec_system_set_daemons(sys, rows, num_daemons);
+    }
+
+    shash_destroy(&existing);
+    free(rows);
+
+} /* reconcile_daemons */
+
+/* The QoS defaults are not compared: once written they belong to the user
+ * configuration, and putting them back would undo changes made from the
+ * CLI. */
+static void
+reconcile_system(const struct ovsrec_system *sys)
+{
+    struct smap other_info;
+
+    smap_clone(&other_info, &sys->other_info);
+    acl_limits_to_smap(&other_info);
+    if (!smap_equal(&other_info, &sys->other_info)) {
+        ovsrec_system_set_other_info(sys, &other_info);
+        sysd_metrics_rows_written(&ovsrec_table_system, 1);
+        changes.updated++;
+    }
+    smap_destroy(&other_info);
+
+} /* reconcile_system */
+
+static bool
+reconcile_build(struct ovsdb_idl_txn *txn, void *aux OVS_UNUSED)
+{
+    const struct ovsrec_system *sys = ovsrec_system_first(idl);
+
+    memset(&changes, 0, sizeof changes);
+    if (sys == NULL) {
+        return false;
+    }
+
+    reconcile_subsystems(txn, sys);
+    reconcile_daemons(txn, sys);
+    reconcile_system(sys);
+
+    return changes.added || changes.updated || changes.removed;
+
+} /* reconcile_build */
+
+static void
+reconcile_done(enum ovsdb_idl_txn_status status, void *aux OVS_UNUSED)
+{
+    reconcile_queued = false;
+    sysd_trace_phase_stop("reconcile", reconcile_phase);
+
+    if (status == TXN_UNCHANGED) {
+        VLOG_INFO("Existing configuration matches the hardware description");
+    } else if (status == TXN_SUCCESS) {
+        VLOG_INFO("Reconciled existing configuration in %lld ms: %u rows "
+                  "added, %u updated, %u removed",
+                  time_msec() - reconcile_queued_at, changes.added,
+                  changes.updated, changes.removed);
+    } else {
+        /* Tried again on the next database change. */
+        VLOG_ERR("Failed to reconcile the existing configuration. rc = %s",
+                 ovsdb_idl_txn_status_to_string(status));
+        return;
+    }
+    reconciled = true;
+
+} /* reconcile_done */
+
+/* Queues the reconciliation once per lock acquisition. Called from
+ * sysd_run() when the System row exists and sysd holds the lock. */
+void
+sysd_reconcile_run(void)
+{
+    if (reconciled || reconcile_queued) {
+        return;
+    }
+
+    reconcile_queued = true;
+    reconcile_queued_at = time_msec();
+    reconcile_phase = sysd_trace_phase_start("reconcile");
+    sysd_txn_submit(SYSD_TXN_RECONCILE, reconcile_build, reconcile_done,
+                    NULL);
+
+} /* sysd_reconcile_run */
+
+/* Another sysd may change the database while this one does not hold the
+ * lock, so reconcile again once it is acquired. */
+void
+sysd_reconcile_reset(void)
+{
+    reconciled = false;
+
+} /* sysd_reconcile_reset */
+
+/* The configuration was written by this sysd, nothing to reconcile. */
+void
+sysd_reconcile_skip(void)
+{
+    reconciled = true;
+
+} /* sysd_reconcile_skip */
+
+bool
+sysd_reconcile_pending(void)
+{
+    return reconcile_queued;
+
+} /* sysd_reconcile_pending */
+
+/* Whether the database has matched the hardware since the lock was last
+ * acquired. */
+bool
+sysd_reconcile_done(void)
+{
+    return reconciled;
+
+} /* sysd_reconcile_done */
+/** @} end of group sysd */
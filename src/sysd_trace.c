@@ -0,0 +1,373 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup sysd
+ *
+ * @file
+ * Source for the sysd flight recorder.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <dirs.h>
+#include <dynamic-string.h>
+#include <fatal-signal.h>
+#include <ovs-atomic.h>
+#include <ovsdb-idl.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include "sysd_trace.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_trace);
+
+/** @ingroup sysd
+ * @{ */
+
+#define TRACE_RING_MASK     (SYSD_TRACE_RING_SIZE - 1)
+#define TRACE_NAME_LEN      24
+#define TRACE_LINE_LEN      128
+
+BUILD_ASSERT_DECL(!(SYSD_TRACE_RING_SIZE & TRACE_RING_MASK));
+
+struct trace_event {
+    uint64_t    ns;
+    uint16_t    type;
+    int32_t     c;
+    int64_t     a;
+    int64_t     b;
+    char        name[TRACE_NAME_LEN];
+};
+
+/* 'seq' is the event's index plus one once it is completely written, and
+ * 0 while a writer is filling it in. */
+struct trace_slot {
+    atomic_uint64_t     seq;
+    struct trace_event  ev;
+};
+
+static struct trace_slot    trace_ring[SYSD_TRACE_RING_SIZE];
+static atomic_uint64_t      trace_head = ATOMIC_VAR_INIT(0);
+static uint64_t             trace_epoch;
+static char                 *trace_file;
+static bool                 trace_clean_exit;
+
+static const struct {
+    const char  *name;
+    const char  *a;             /* Names of the arguments printed, or NULL. */
+    const char  *b;
+    const char  *c;
+} trace_types[SYSD_TRACE_N_TYPES] = {
+    [SYSD_TRACE_PHASE_START] = { "phase_start", NULL,     NULL,         NULL },
+    [SYSD_TRACE_PHASE_STOP]  = { "phase_stop",  "usec",   NULL,         NULL },
+    [SYSD_TRACE_TXN_COMMIT]  = { "txn_commit",  "rows",   "usec",       NULL },
+    [SYSD_TRACE_DAEMON]      = { "daemon",      "cur_hw", "hw_handler", NULL },
+    [SYSD_TRACE_FILE]        = { "file",        "entries", NULL,        "rc" },
+    [SYSD_TRACE_ERROR]       = { "error",       NULL,     NULL,         "rc" },
+};
+
+static const int trace_crash_signals[] = {
+    SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT,
+};
+
+uint64_t
+sysd_trace_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+} /* sysd_trace_now */
+
+void
+sysd_trace(enum sysd_trace_type type, const char *name, int64_t a,
+           int64_t b, int32_t c)
+{
+    struct trace_slot   *slot;
+    uint64_t            idx;
+    size_t              len = strlen(name);
+
+    atomic_add_explicit(&trace_head, 1, &idx, memory_order_relaxed);
+    slot = &trace_ring[idx & TRACE_RING_MASK];
+
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->ev.ns = sysd_trace_now();
+    slot->ev.type = type;
+    slot->ev.a = a;
+    slot->ev.b = b;
+    slot->ev.c = c;
+    /* Keep the end of long names, which is the informative part of a
+     * path. */
+    if (len >= TRACE_NAME_LEN) {
+        name += len - (TRACE_NAME_LEN - 1);
+    }
+    ovs_strlcpy(slot->ev.name, name, TRACE_NAME_LEN);
+
+    atomic_store_explicit(&slot->seq, idx + 1, memory_order_release);
+
+} /* sysd_trace */
+
+uint64_t
+sysd_trace_phase_start(const char *name)
+{
+    sysd_trace(SYSD_TRACE_PHASE_START, name, 0, 0, 0);
+    return sysd_trace_now();
+
+} /* sysd_trace_phase_start */
+
+void
+sysd_trace_phase_stop(const char *name, uint64_t start)
+{
+    sysd_trace(SYSD_TRACE_PHASE_STOP, name,
+               (sysd_trace_now() - start) / 1000, 0, 0);
+
+} /* sysd_trace_phase_stop */
+
+/* Copies event 'idx' into 'ev'. Fails if it has not been written yet or
+ * was overwritten while being copied. */
+static bool
+trace_read(uint64_t idx, struct trace_event *ev)
+{
+    struct trace_slot   *slot = &trace_ring[idx & TRACE_RING_MASK];
+    uint64_t            seq;
+
+    atomic_read_explicit(&slot->seq, &seq, memory_order_acquire);
+    if (seq != idx + 1) {
+        return false;
+    }
+    memcpy(ev, &slot->ev, sizeof *ev);
+    atomic_thread_fence(memory_order_acquire);
+    atomic_read_explicit(&slot->seq, &seq, memory_order_relaxed);
+
+    return seq == idx + 1;
+
+} /* trace_read */
+
+/* The formatting below only uses async-signal-safe code, since it also
+ * runs from the crash signal handler. */
+static char *
+trace_put_str(char *p, char *end, const char *s)
+{
+    while (*s && p < end) {
+        *p++ = *s++;
+    }
+    return p;
+
+} /* trace_put_str */
+
+static char *
+trace_put_uint(char *p, char *end, uint64_t v, int min_digits)
+{
+    char    digits[20];
+    int     n = 0;
+
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v || n < min_digits);
+
+    while (n && p < end) {
+        *p++ = digits[--n];
+    }
+    return p;
+
+} /* trace_put_uint */
+
+static char *
+trace_put_arg(char *p, char *end, const char *key, int64_t v)
+{
+    p = trace_put_str(p, end, " ");
+    p = trace_put_str(p, end, key);
+    p = trace_put_str(p, end, "=");
+    if (v < 0) {
+        p = trace_put_str(p, end, "-");
+        return trace_put_uint(p, end, -(uint64_t) v, 1);
+    }
+    return trace_put_uint(p, end, v, 1);
+
+} /* trace_put_arg */
+
+/* Formats 'ev' as one line, with its time relative to sysd_trace_init(),
+ * and returns its length. */
+static size_t
+trace_format_event(char *buf, const struct trace_event *ev)
+{
+    char        *p = buf;
+    char        *end = buf + TRACE_LINE_LEN - 1;
+    uint64_t    ns = ev->ns > trace_epoch ? ev->ns - trace_epoch : 0;
+
+    p = trace_put_uint(p, end, ns / 1000000000ULL, 4);
+    p = trace_put_str(p, end, ".");
+    p = trace_put_uint(p, end, ns % 1000000000ULL, 9);
+    p = trace_put_str(p, end, " ");
+    p = trace_put_str(p, end, ev->type < SYSD_TRACE_N_TYPES
+                              ? trace_types[ev->type].name : "unknown");
+    p = trace_put_str(p, end, " ");
+    p = trace_put_str(p, end, ev->name);
+
+    if (ev->type < SYSD_TRACE_N_TYPES) {
+        if (trace_types[ev->type].a) {
+            p = trace_put_arg(p, end, trace_types[ev->type].a, ev->a);
+        }
+        if (trace_types[ev->type].b) {
+            p = trace_put_arg(p, end, trace_types[ev->type].b, ev->b);
+        }
+        if (trace_types[ev->type].c) {
+            p = trace_put_arg(p, end, trace_types[ev->type].c, ev->c);
+        }
+        if (ev->type == SYSD_TRACE_TXN_COMMIT) {
+            /* Returns a string constant, so this is safe as well. */
+            p = trace_put_str(p, end, " ");
+            p = trace_put_str(p, end, ovsdb_idl_txn_status_to_string(ev->c));
+        }
+    }
+    *p++ = '\n';
+
+    return p - buf;
+
+} /* trace_format_event */
+
+/* Calls 'cb' on the last 'max_events' events in the ring, oldest first. */
+static void
+trace_for_each(unsigned int max_events,
+               void (*cb)(const char *line, size_t len, void *aux), void *aux)
+{
+    struct trace_event  ev;
+    char                line[TRACE_LINE_LEN];
+    uint64_t            head;
+    uint64_t            idx;
+
+    atomic_read_explicit(&trace_head, &head, memory_order_acquire);
+    if (max_events > SYSD_TRACE_RING_SIZE) {
+        max_events = SYSD_TRACE_RING_SIZE;
+    }
+    idx = head > max_events ? head - max_events : 0;
+
+    for (; idx < head; idx++) {
+        if (trace_read(idx, &ev)) {
+            cb(line, trace_format_event(line, &ev), aux);
+        }
+    }
+
+} /* trace_for_each */
+
+static void
+trace_put_ds(const char *line, size_t len, void *ds_)
+{
+    ds_put_buffer(ds_, line, len);
+
+} /* trace_put_ds */
+
+static void
+trace_put_fd(const char *line, size_t len, void *fd_)
+{
+    int fd = *(int *) fd_;
+
+    while (len) {
+        ssize_t n = write(fd, line, len);
+
+        if (n <= 0) {
+            return;
+        }
+        line += n;
+        len -= n;
+    }
+
+} /* trace_put_fd */
+
+void
+sysd_trace_format(struct ds *ds, unsigned int max_events)
+{
+    trace_for_each(max_events, trace_put_ds, ds);
+
+} /* sysd_trace_format */
+
+static bool
+trace_dump_file(void)
+{
+    int fd;
+
+    if (trace_file == NULL) {
+        return false;
+    }
+    fd = open(trace_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    trace_for_each(SYSD_TRACE_RING_SIZE, trace_put_fd, &fd);
+    close(fd);
+
+    return true;
+
+} /* trace_dump_file */
+
+static void
+trace_fatal_hook(void *aux OVS_UNUSED)
+{
+    if (!trace_clean_exit && trace_dump_file()) {
+        VLOG_WARN("Event trace written to %s", trace_file);
+    }
+
+} /* trace_fatal_hook */
+
+static void
+trace_crash_handler(int signr)
+{
+    /* SA_RESETHAND restored the default action, so this kills us. */
+    trace_dump_file();
+    raise(signr);
+
+} /* trace_crash_handler */
+
+void
+sysd_trace_init(void)
+{
+    struct sigaction    sa;
+    size_t              i;
+
+    trace_epoch = sysd_trace_now();
+    trace_file = xasprintf("%s/%s.trace", ovs_rundir(), program_name);
+
+    /* Runs on SIGTERM, SIGINT, SIGHUP and SIGALRM, and from exit(). */
+    fatal_signal_add_hook(trace_fatal_hook, NULL, NULL, true);
+
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = trace_crash_handler;
+    sa.sa_flags = SA_RESETHAND;
+    sigemptyset(&sa.sa_mask);
+    for (i = 0; i < ARRAY_SIZE(trace_crash_signals); i++) {
+        sigaction(trace_crash_signals[i], &sa, NULL);
+    }
+
+} /* sysd_trace_init */
+
+/* Called on the way out after an orderly shutdown, which needs no trace. */
+void
+sysd_trace_clean_exit(void)
+{
+    trace_clean_exit = true;
+
+} /* sysd_trace_clean_exit */
+/** @} end of group sysd */
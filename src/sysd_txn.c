@@ -0,0 +1,308 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup sysd
+ *
+ * @file
+ * Source for the sysd OVSDB transaction queue.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <ovsdb-idl.h>
+#include <poll-loop.h>
+#include <random.h>
+#include <timeval.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include "sysd_metrics.h"
+#include "sysd_trace.h"
+#include "sysd_txn.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_txn);
+
+/** @ingroup sysd
+ * @{ */
+
+extern struct ovsdb_idl *idl;
+
+struct txn_job {
+    struct txn_job      *next;
+    enum sysd_txn_site  site;
+    sysd_txn_build_cb   *build;
+    sysd_txn_done_cb    *done;
+    void                *aux;
+    unsigned int        attempts;
+    bool                built;      /* Added changes to cur_txn. */
+};
+
+static struct txn_job       *jobs_head;
+static struct txn_job       **jobs_tail = &jobs_head;
+static size_t               n_jobs;
+
+/* Transaction of the jobs at the head of the queue, while in flight. */
+static struct ovsdb_idl_txn *cur_txn;
+static size_t               cur_n_jobs;
+/* Site and attempt count of the first of them with changes. */
+static enum sysd_txn_site   cur_site;
+static unsigned int         cur_attempts;
+static uint64_t             cur_build_ns;
+static uint64_t             cur_commit_ns;
+static unsigned int         cur_rows;
+
+/* After a failed commit, the head jobs are built again from the IDL once
+ * 'retry_at' has passed. After TXN_TRY_AGAIN, the IDL must also have moved
+ * on from the sequence number their transaction was built against. */
+static bool                 retry_pending;
+static bool                 retry_wait_seqno;
+static unsigned int         retry_seqno;
+static long long            retry_at;
+static unsigned int         cur_seqno;
+
+void
+sysd_txn_submit(enum sysd_txn_site site, sysd_txn_build_cb *build,
+                sysd_txn_done_cb *done, void *aux)
+{
+    struct txn_job *job = xzalloc(sizeof *job);
+
+    job->site = site;
+    job->build = build;
+    job->done = done;
+    job->aux = aux;
+
+    *jobs_tail = job;
+    jobs_tail = &job->next;
+    n_jobs++;
+
+} /* sysd_txn_submit */
+
+size_t
+sysd_txn_n_pending(void)
+{
+    return n_jobs;
+
+} /* sysd_txn_n_pending */
+
+/* Removes the head job and reports 'status' to it. */
+static void
+txn_job_finish(enum ovsdb_idl_txn_status status)
+{
+    struct txn_job *job = jobs_head;
+
+    jobs_head = job->next;
+    if (jobs_head == NULL) {
+        jobs_tail = &jobs_head;
+    }
+    n_jobs--;
+
+    if (job->done) {
+        job->done(status, job->aux);
+    }
+    free(job);
+
+} /* txn_job_finish */
+
+/* Removes the jobs built into the last transaction and reports 'status' to
+ * them, or TXN_UNCHANGED to those that had nothing to write. */
+static void
+txn_jobs_finish(enum ovsdb_idl_txn_status status)
+{
+    size_t n = cur_n_jobs;
+
+    cur_n_jobs = 0;
+    while (n--) {
+        txn_job_finish(jobs_head->built ? status : TXN_UNCHANGED);
+    }
+
+} /* txn_jobs_finish */
+
+/* Whether jobs from 'site' only update a few columns of existing rows, so
+ * that they may share a transaction with the jobs queued around them. */
+static bool
+txn_site_is_small(enum sysd_txn_site site)
+{
+    return site == SYSD_TXN_HW_DONE || site == SYSD_TXN_SW_INFO;
+
+} /* txn_site_is_small */
+
+/* Builds the head job into cur_txn along with the jobs queued behind it, up
+ * to the second job that is not small, so that batched writes still get a
+ * transaction each. Returns the number of jobs that added changes. */
+static size_t
+txn_build_jobs(void)
+{
+    struct txn_job  *job;
+    size_t          n_built = 0;
+    bool            bulk = false;
+
+    cur_n_jobs = 0;
+    for (job = jobs_head; job; job = job->next) {
+        if (!txn_site_is_small(job->site)) {
+            if (bulk) {
+                break;
+            }
+            bulk = true;
+        }
+
+        job->built = job->build(cur_txn, job->aux);
+        if (job->built) {
+            if (!n_built) {
+                cur_site = job->site;
+                cur_attempts = job->attempts + 1;
+            }
+            job->attempts++;
+            n_built++;
+        }
+        cur_n_jobs++;
+    }
+
+    return n_built;
+
+} /* txn_build_jobs */
+
+/* Returns how long to wait before building a transaction again after its
+ * 'attempts'th commit failed: doubling with each attempt, and picked at
+ * random from the upper half of that so that clients that collided do not
+ * collide again. */
+static long long
+txn_backoff_msec(unsigned int attempts)
+{
+    unsigned int    shift = MIN(attempts - 1, 16);
+    long long       delay = MIN((long long) SYSD_TXN_BACKOFF_MIN_MSEC << shift,
+                                SYSD_TXN_BACKOFF_MAX_MSEC);
+
+    return delay / 2 + random_range(delay / 2 + 1);
+
+} /* txn_backoff_msec */
+
+/* Whether a failed commit with 'status' is worth building again. */
+static bool
+txn_should_retry(enum ovsdb_idl_txn_status status)
+{
+    switch (status) {
+    case TXN_TRY_AGAIN:
+    case TXN_NOT_LOCKED:
+        /* Contention or a lost connection, which will pass. */
+        return true;
+
+    case TXN_ERROR:
+        /* May be a transient server error, but give up eventually. */
+        return cur_attempts < SYSD_TXN_MAX_ERROR_ATTEMPTS;
+
+    default:
+        return false;
+    }
+
+} /* txn_should_retry */
+
+/* Whether the head job may be built now. */
+static bool
+txn_can_start(void)
+{
+    return jobs_head && ovsdb_idl_has_lock(idl)
+           && !(retry_pending
+                && (time_msec() < retry_at
+                    || (retry_wait_seqno
+                        && ovsdb_idl_get_seqno(idl) == retry_seqno)));
+
+} /* txn_can_start */
+
+/* Builds and commits queued jobs until a transaction is left in flight or
+ * the queue is empty. Called at the end of sysd_run(), so that the jobs
+ * queued during the pass share a transaction where they can. */
+void
+sysd_txn_run(void)
+{
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+
+    for (;;) {
+        enum ovsdb_idl_txn_status   status;
+        size_t                      n_built;
+
+        if (cur_txn == NULL) {
+            if (!txn_can_start()) {
+                return;
+            }
+            retry_pending = false;
+
+            cur_txn = ovsdb_idl_txn_create(idl);
+            cur_seqno = ovsdb_idl_get_seqno(idl);
+            cur_build_ns = sysd_trace_now();
+            sysd_metrics_txn_rows_take();
+            n_built = txn_build_jobs();
+            if (!n_built) {
+                ovsdb_idl_txn_destroy(cur_txn);
+                cur_txn = NULL;
+                sysd_metrics_txn_rows_take();
+                sysd_metrics_rows_settle(false);
+                txn_jobs_finish(TXN_UNCHANGED);
+                continue;
+            }
+            if (n_built > 1) {
+                sysd_metrics_txn_coalesced(n_built - 1);
+            }
+            cur_rows = sysd_metrics_txn_rows_take();
+            cur_commit_ns = sysd_trace_now();
+        }
+
+        status = ovsdb_idl_txn_commit(cur_txn);
+        if (status == TXN_INCOMPLETE) {
+            return;
+        }
+
+        sysd_metrics_txn_done(cur_site, status, cur_build_ns, cur_commit_ns,
+                              cur_rows);
+        /* Only committed rows count towards the per-table totals. */
+        sysd_metrics_rows_settle(status == TXN_SUCCESS);
+        ovsdb_idl_txn_destroy(cur_txn);
+        cur_txn = NULL;
+
+        if (txn_should_retry(status)) {
+            long long delay = txn_backoff_msec(cur_attempts);
+
+            VLOG_INFO_RL(&rl, "%s commit attempt %u: %s, retrying in %lld ms",
+                         sysd_metrics_txn_site_name(cur_site), cur_attempts,
+                         ovsdb_idl_txn_status_to_string(status), delay);
+            sysd_metrics_txn_retry(cur_site);
+            cur_n_jobs = 0;
+            retry_pending = true;
+            retry_wait_seqno = status == TXN_TRY_AGAIN;
+            retry_seqno = cur_seqno;
+            retry_at = time_msec() + delay;
+            continue;
+        }
+
+        txn_jobs_finish(status);
+    }
+
+} /* sysd_txn_run */
+
+void
+sysd_txn_wait(void)
+{
+    if (cur_txn) {
+        ovsdb_idl_txn_wait(cur_txn);
+    } else if (txn_can_start()) {
+        /* Submitted after sysd_txn_run(), e.g. from ovs-appctl. */
+        poll_immediate_wake();
+    } else if (retry_pending && time_msec() < retry_at) {
+        poll_timer_wait_until(retry_at);
+    }
+
+} /* sysd_txn_wait */
+/** @} end of group sysd */
@@ -35,6 +35,7 @@
 
 #include <config-yaml.h>
 #include "sysd_cfg_yaml.h"
+#include "sysd_trace.h"
 #include "sysd.h"
 
 /***********************************************************/
@@ -265,13 +266,15 @@ _sysd_process_daemons(struct shash *object) {
 
     SHASH_FOR_EACH (dnode, object) {
         daemons = realloc(daemons, sizeof(daemon_info_t*)*(num_daemons+1));
-        daemons[num_daemons] = calloc(sizeof(daemon_info_t), 1);
-        if (daemons[num_daemons] == (daemon_info_t *) NULL) {
+        if (daemons == (daemon_info_t **) NULL) {
             VLOG_ERR("Error processing daemon information");
             return (-1);
         }
+        daemons[num_daemons] = sysd_arena_alloc(&sysd_state_arena,
+                                                sizeof(daemon_info_t));
 
-        strncpy(daemons[num_daemons]->name, dnode->name, strlen(dnode->name));
+        ovs_strlcpy(daemons[num_daemons]->name, dnode->name,
+                    sizeof(daemons[num_daemons]->name));
 
         /* If this row is sysd, then go ahead and set cur_hw = 1 since
            ...everything is being done in one transaction. */
@@ -287,10 +290,13 @@ _sysd_process_daemons(struct shash *object) {
 
         _sysd_get_hw_handler(json_object(dnode->data));
 
-        VLOG_INFO("%s daemons_manifest:'%s', daemons_manifest_cur_hw %d, "
-                  "daemons_manifest_is_hw_handler %d", hostname,
-                  daemons[num_daemons]->name, (int)(daemons[num_daemons]->cur_hw),
-                  (int)(daemons[num_daemons]->is_hw_handler));
+        VLOG_DBG("%s daemons_manifest:'%s', daemons_manifest_cur_hw %d, "
+                 "daemons_manifest_is_hw_handler %d", hostname,
+                 daemons[num_daemons]->name, (int)(daemons[num_daemons]->cur_hw),
+                 (int)(daemons[num_daemons]->is_hw_handler));
+        sysd_trace(SYSD_TRACE_DAEMON, daemons[num_daemons]->name,
+                   daemons[num_daemons]->cur_hw,
+                   daemons[num_daemons]->is_hw_handler, 0);
         num_daemons++;
     }
 
@@ -310,9 +316,11 @@ _sysd_process_mgmt_intf(struct shash *object)
             jp = dnode->data;
             switch (jp->type) {
                 case JSON_STRING:
-                    mgmt_intf = xcalloc(sizeof(mgmt_intf_info_t), 0);
+                    free(mgmt_intf);
+                    mgmt_intf = xcalloc(1, sizeof(mgmt_intf_info_t));
 
-                    strncpy(mgmt_intf->name,jp->u.string,strlen(jp->u.string));
+                    ovs_strlcpy(mgmt_intf->name, jp->u.string,
+                                sizeof(mgmt_intf->name));
                     is_mgmt_intf_present = true;
                     VLOG_DBG("Management Interface read successfully: %s",mgmt_intf->name);
                     break;
@@ -433,9 +441,9 @@ sysd_set_num_hw_daemons()
 } /* sysd_set_num_hw_daemons() */
 
 int
-sysd_read_manifest_file(void)
+sysd_read_manifest_file(const char *path)
 {
-    manifest_info = json_from_file(IMAGE_MANIFEST_FILE_PATH);
+    manifest_info = json_from_file(path);
 
     if (manifest_info == (struct json *) NULL) {
         return -1;
@@ -449,7 +457,7 @@ sysd_read_manifest_file(void)
     }
 
     if (sysd_process_json(manifest_info)) {
-        VLOG_ERR("Error processing %s", IMAGE_MANIFEST_FILE_PATH);
+        VLOG_ERR("Error processing %s", path);
         return(-1);
     }
 